@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include "ASTCache.h"
+
+CASTCache::CASTCache(const std::string& strDir)
+	: m_strDir(strDir)
+{}
+
+/**
+@brief		Map the cached AST of a source
+@param		strSource	Source code
+@param		ast			(out) AST (cleared on a miss)
+@return		Whether the source was in the cache
+*/
+bool CASTCache::Load(std::string_view strSource, CFlatAST& ast) const
+{
+	return ast.Load(GetPath(strSource), Hash(strSource), strSource);
+}
+
+/**
+@brief		Put the AST of a source into the cache (the directory is made if needed)
+@param		strSource	Source code
+@param		ast			AST of the source
+@return		Whether the file could be written
+*/
+bool CASTCache::Store(std::string_view strSource, const CFlatAST& ast) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_strDir, error);
+
+	return ast.Save(GetPath(strSource), Hash(strSource), strSource);
+}
+
+/**
+@brief		Cache file of a source
+@param		strSource	Source code
+@return		File path
+*/
+std::string CASTCache::GetPath(std::string_view strSource) const
+{
+	char szName[32];
+	snprintf(szName, sizeof(szName), "%016llx.slast", Hash(strSource));
+
+	return (std::filesystem::path(m_strDir) / szName).string();
+}
+
+/**
+@brief		64-bit hash of a source (FNV-1a over 8-byte words, then the tail bytes)
+@param		strSource	Source code
+@return		Hash
+*/
+unsigned long long CASTCache::Hash(std::string_view strSource)
+{
+	static const unsigned long long FNV_OFFSET = 14695981039346656037ull;
+	static const unsigned long long FNV_PRIME = 1099511628211ull;
+
+	unsigned long long nHash = FNV_OFFSET ^ strSource.size();
+	size_t nPos = 0;
+
+	for (; nPos + sizeof(unsigned long long) <= strSource.size(); nPos += sizeof(unsigned long long))
+	{
+		unsigned long long nWord;
+		memcpy(&nWord, strSource.data() + nPos, sizeof(nWord));
+		nHash = (nHash ^ nWord) * FNV_PRIME;
+		nHash ^= nHash >> 32;
+	}
+
+	for (; nPos < strSource.size(); ++nPos)
+		nHash = (nHash ^ (unsigned char)strSource[nPos]) * FNV_PRIME;
+
+	return nHash;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "FlatAST.h"
+
+// AST cache
+// A directory of flat ASTs (CFlatAST::Save) named after the 64-bit hash of their source
+// code. On a hit the file is mapped and used as it is, so Scan and Parser are skipped.
+// The file also keeps the hash, the size and a copy of the source, and Load() checks all three,
+// so two sources with the same hash share a file name but never an AST.
+// The AST is stored as parsed, and only for sources that scan and parse without diagnostics:
+// the passes after the parser run again on the rebuilt program and report their own diagnostics.
+class CASTCache
+{
+// Variables ==============================================================================
+private:
+	std::string m_strDir;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CASTCache(const std::string& strDir);
+
+	bool Load(std::string_view strSource, CFlatAST& ast) const;
+	bool Store(std::string_view strSource, const CFlatAST& ast) const;
+	std::string GetPath(std::string_view strSource) const;
+
+	static unsigned long long Hash(std::string_view strSource);
+
+	inline const std::string& Dir() const
+	{
+		return m_strDir;
+	}
+
+// ========================================================================================
+
+};
\ No newline at end of file
@@ -0,0 +1,730 @@
+#include <algorithm>
+#include <charconv>
+#include "ASTDumper.h"
+
+// Output bytes per node reserved up front
+static const size_t BYTES_PER_NODE = 32;
+
+CASTDumper::CASTDumper(eFormat eFormatType)
+	: m_eFormat(eFormatType), m_nPos(0), m_nChildBase(0)
+{}
+
+/**
+@brief		Dump a program
+@param		prog		Program
+@return		Output (valid until the next Dump())
+*/
+std::string_view CASTDumper::Dump(const stProgram& prog)
+{
+	// The buffer keeps its size between dumps; m_nPos is the end of the output
+	m_nPos = 0;
+	if (m_strOut.size() < prog.nNodeCount * BYTES_PER_NODE)
+		m_strOut.resize(prog.nNodeCount * BYTES_PER_NODE);
+	m_vTask.clear();
+	BeginChildren();
+
+	if (m_eFormat == eFormat::Json)
+		Write("{\"functions\":[");
+
+	for (size_t i = 0; i < prog.vFunc.size(); ++i)
+	{
+		if (i > 0)
+			AddLabel("", ",", 0);
+		AddStatement(prog.vFunc[i], 0);
+	}
+	FlushChildren();
+
+	while (m_vTask.empty() == false)
+	{
+		stTask stTaskData = m_vTask.back();
+		m_vTask.pop_back();
+
+		if (stTaskData.pState != nullptr)
+		{
+			DumpStatement(stTaskData.pState, stTaskData.nDepth);
+		}
+		else if (stTaskData.pExp != nullptr)
+		{
+			DumpExpression(stTaskData.pExp, stTaskData.nDepth);
+		}
+		else if (m_eFormat == eFormat::Json)
+		{
+			// Neither a node nor a fragment: a missing child
+			if (stTaskData.strJson.empty() == false)
+				Write(stTaskData.strJson);
+			else if (stTaskData.strLabel.empty())
+				Write("null");
+		}
+		else if (stTaskData.strLabel.empty() == false)
+		{
+			WriteIndent(stTaskData.nDepth);
+			Write(stTaskData.strLabel);
+			Write('\n');
+		}
+	}
+
+	if (m_eFormat == eFormat::Json)
+		Write("]}\n");
+
+	return Output();
+}
+
+/**
+@brief		Dump a program and write it out in one call
+@param		prog		Program
+@param		pFile		Output file
+@return
+*/
+void CASTDumper::Print(const stProgram& prog, FILE* pFile)
+{
+	Dump(prog);
+	fwrite(m_strOut.data(), 1, m_nPos, pFile);
+}
+
+/**
+@brief		Write a statement and add its children as tasks
+@param		pState		Statement
+@param		nDepth		Indent of the text
+@return
+*/
+void CASTDumper::DumpStatement(const stStatement* pState, int nDepth)
+{
+	bool bJson = m_eFormat == eFormat::Json;
+
+	BeginChildren();
+
+	switch (pState->eKind)
+	{
+		case eNodeKind::Function:
+		{
+			const stFunction* pFunc = static_cast<const stFunction*>(pState);
+
+			if (bJson)
+			{
+				Write("{\"kind\":\"Function\",\"type\":");
+				WriteLex(pFunc->eType);
+				Write(",\"name\":");
+				WriteSymbol(pFunc->nSymbol);
+				Write(",\"params\":[");
+				for (size_t i = 0; i < pFunc->vParams.size(); ++i)
+				{
+					if (i > 0)
+						Write(',');
+					WriteSymbol(pFunc->vParams[i]);
+				}
+				Write(']');
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Function(");
+				WriteLex(pFunc->eType);
+				Write(") ");
+				WriteSymbol(pFunc->nSymbol);
+				Write('(');
+				for (SymbolID nParam : pFunc->vParams)
+				{
+					WriteSymbol(nParam);
+					Write(' ');
+				}
+				Write("):\n");
+			}
+
+			AddBlock("", ",\"block\":[", pFunc->vBlock, nDepth, nDepth + 1);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::Variable:
+		{
+			const stVariable* pVar = static_cast<const stVariable*>(pState);
+
+			if (bJson)
+			{
+				Write("{\"kind\":\"Variable\",\"type\":");
+				WriteLex(pVar->eType);
+				Write(",\"name\":");
+				WriteSymbol(pVar->nSymbol);
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Variable(");
+				WriteLex(pVar->eType);
+				Write(") ");
+				WriteSymbol(pVar->nSymbol);
+				Write(":\n");
+			}
+
+			AddLabel("", ",\"init\":", nDepth);
+			AddExpression(pVar->stExp, nDepth + 1);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::ExpStatement:
+			WriteHeader(nDepth, "Exp Statement:", "ExpStatement");
+			AddLabel("", ",\"expression\":", nDepth);
+			AddExpression(static_cast<const stExpStatement*>(pState)->stExp, nDepth + 1);
+			AddLabel("", "}", nDepth);
+			break;
+		case eNodeKind::Return:
+			WriteHeader(nDepth, "Return:", "Return");
+			AddLabel("", ",\"expression\":", nDepth);
+			AddExpression(static_cast<const stReturn*>(pState)->stExp, nDepth + 1);
+			AddLabel("", "}", nDepth);
+			break;
+		case eNodeKind::For:
+		{
+			const stFor* pFor = static_cast<const stFor*>(pState);
+
+			WriteHeader(nDepth, "For:", "For");
+			AddLabel(" Init-statement:", ",\"init\":", nDepth);
+			AddStatement(pFor->stVar, nDepth + 2);
+			AddLabel(" Condition-expression:", ",\"cond\":", nDepth);
+			AddExpression(pFor->stCondExp, nDepth + 2);
+			AddLabel(" Loop-expression:", ",\"loop\":", nDepth);
+			AddExpression(pFor->stLoopExp, nDepth + 2);
+			AddBlock(" Block:", ",\"block\":[", pFor->stBlock, nDepth, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::While:
+		{
+			const stWhile* pWhile = static_cast<const stWhile*>(pState);
+
+			WriteHeader(nDepth, "While:", "While");
+			AddLabel(" Condition-expression:", ",\"cond\":", nDepth);
+			AddExpression(pWhile->stCondExp, nDepth + 2);
+			AddBlock(" Block:", ",\"block\":[", pWhile->stBlock, nDepth, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::If:
+		{
+			const stIf* pIf = static_cast<const stIf*>(pState);
+
+			// The first branch line is the header of the text
+			if (bJson)
+				Write("{\"kind\":\"If\",\"branches\":[");
+
+			for (size_t i = 0; i < pIf->stCondStm.size(); ++i)
+			{
+				AddLabel(i == 0 ? "If:" : "Elif:", i == 0 ? "{\"cond\":" : ",{\"cond\":", nDepth);
+				AddLabel(" Condition-expression:", "", nDepth);
+				AddExpression(pIf->stCondStm[i], nDepth + 2);
+				AddBlock(" Block:", ",\"block\":[", pIf->vIfBlock[i], nDepth, nDepth + 2);
+				AddLabel("", "}", nDepth);
+			}
+
+			AddLabel("Else:", "]", nDepth);
+			AddBlock(" Block:", ",\"else\":[", pIf->vElseBlock, nDepth, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::Switch:
+		{
+			const stSwitch* pSwitch = static_cast<const stSwitch*>(pState);
+
+			WriteHeader(nDepth, "Switch:", "Switch");
+			AddLabel(" Init-statement:", ",\"expression\":", nDepth);
+			AddExpression(pSwitch->stExp, nDepth + 2);
+			AddLabel("", ",\"cases\":[", nDepth);
+
+			// The default is listed where it is in the source, with a null condition
+			for (size_t i = 0; i <= pSwitch->stCondStm.size(); ++i)
+			{
+				bool bFirst = i == 0 && pSwitch->nDefaultIdx != 0;
+
+				if ((int)i == pSwitch->nDefaultIdx)
+				{
+					AddLabel(" Default:", i == 0 ? "{\"cond\":null" : ",{\"cond\":null", nDepth);
+					AddBlock(" Block:", ",\"block\":[", pSwitch->vDefaultBlock, nDepth, nDepth + 2);
+					AddLabel("", "}", nDepth);
+				}
+				if (i == pSwitch->stCondStm.size())
+					break;
+
+				AddLabel(" Case:", bFirst ? "{\"cond\":" : ",{\"cond\":", nDepth);
+				AddLabel(" Condition-expression:", "", nDepth);
+				AddExpression(pSwitch->stCondStm[i], nDepth + 2);
+				AddBlock(" Block:", ",\"block\":[", pSwitch->vCaseBlock[i], nDepth, nDepth + 2);
+				AddLabel("", "}", nDepth);
+			}
+
+			AddLabel("", "]}", nDepth);
+			break;
+		}
+		case eNodeKind::Break:
+			WriteHeader(nDepth, "Break:", "Break");
+			if (bJson)
+				Write('}');
+			break;
+		case eNodeKind::Continue:
+			WriteHeader(nDepth, "Continue:", "Continue");
+			if (bJson)
+				Write('}');
+			break;
+		case eNodeKind::Print:
+		{
+			const stPrint* pPrint = static_cast<const stPrint*>(pState);
+
+			WriteHeader(nDepth, "Print:", "Print");
+			if (bJson)
+			{
+				Write(",\"format\":");
+				WriteString(pPrint->strFormat);
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write(" Format: ");
+				Write(pPrint->strFormat);
+				Write('\n');
+			}
+
+			AddExpressionList(" Arguments:", ",\"args\":[", pPrint->stArgs, nDepth, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		default:
+			break;
+	}
+
+	FlushChildren();
+}
+
+/**
+@brief		Write an expression and add its children as tasks
+@param		pExp		Expression
+@param		nDepth		Indent of the text
+@return
+*/
+void CASTDumper::DumpExpression(const stExpression* pExp, int nDepth)
+{
+	bool bJson = m_eFormat == eFormat::Json;
+
+	BeginChildren();
+
+	switch (pExp->eKind)
+	{
+		case eNodeKind::NullData:
+			WriteHeader(nDepth, "Null Data:", "NullData");
+			if (bJson)
+				Write('}');
+			break;
+		case eNodeKind::VoidData:
+			WriteHeader(nDepth, "Void Data:", "VoidData");
+			if (bJson)
+				Write('}');
+			break;
+		case eNodeKind::BoolData:
+		{
+			bool bData = static_cast<const stBoolData*>(pExp)->bData;
+
+			if (bJson)
+			{
+				Write(bData ? "{\"kind\":\"BoolData\",\"value\":true}" : "{\"kind\":\"BoolData\",\"value\":false}");
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write(bData ? "Boolean Data: true\n" : "Boolean Data: false\n");
+			}
+			break;
+		}
+		case eNodeKind::IntData:
+			if (bJson)
+			{
+				Write("{\"kind\":\"IntData\",\"value\":");
+				WriteInt(static_cast<const stIntData*>(pExp)->nData);
+				Write('}');
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Integer Data: ");
+				WriteInt(static_cast<const stIntData*>(pExp)->nData);
+				Write('\n');
+			}
+			break;
+		case eNodeKind::DoubleData:
+			if (bJson)
+			{
+				Write("{\"kind\":\"DoubleData\",\"value\":");
+				WriteDouble(static_cast<const stDoubleData*>(pExp)->dData);
+				Write('}');
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Double Data: ");
+				WriteDouble(static_cast<const stDoubleData*>(pExp)->dData);
+				Write('\n');
+			}
+			break;
+		case eNodeKind::StringData:
+		{
+			std::string_view strData = static_cast<const stStringData*>(pExp)->strData;
+
+			if (bJson)
+			{
+				Write("{\"kind\":\"StringData\",\"value\":");
+				WriteString(strData);
+				Write('}');
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("String Data: ");
+				Write(strData);
+				Write('\n');
+			}
+			break;
+		}
+		case eNodeKind::Array:
+			if (bJson)
+			{
+				Write("{\"kind\":\"Array\",\"size\":");
+				WriteInt(static_cast<const stArray*>(pExp)->Size());
+				Write('}');
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Array: ");
+				WriteInt(static_cast<const stArray*>(pExp)->Size());
+				Write('\n');
+			}
+			break;
+		case eNodeKind::And:
+		case eNodeKind::Or:
+		{
+			// stAnd and stOr have the same layout
+			bool bAnd = pExp->eKind == eNodeKind::And;
+			const stExpression* pLeft = bAnd ? static_cast<const stAnd*>(pExp)->stLeft : static_cast<const stOr*>(pExp)->stLeft;
+			const stExpression* pRight = bAnd ? static_cast<const stAnd*>(pExp)->stRight : static_cast<const stOr*>(pExp)->stRight;
+
+			WriteHeader(nDepth, bAnd ? "And:" : "Or:", bAnd ? "And" : "Or");
+			AddLabel(" Left:", ",\"left\":", nDepth);
+			AddExpression(pLeft, nDepth + 2);
+			AddLabel(" Right:", ",\"right\":", nDepth);
+			AddExpression(pRight, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::Relational:
+		case eNodeKind::Arithmetic:
+		{
+			bool bRel = pExp->eKind == eNodeKind::Relational;
+			const stExpression* pLeft = bRel ? static_cast<const stRelational*>(pExp)->stLeft : static_cast<const stArithmetic*>(pExp)->stLeft;
+			const stExpression* pRight = bRel ? static_cast<const stRelational*>(pExp)->stRight : static_cast<const stArithmetic*>(pExp)->stRight;
+			CLexer::eLexEnum eType = bRel ? static_cast<const stRelational*>(pExp)->eType : static_cast<const stArithmetic*>(pExp)->eType;
+
+			if (bJson)
+			{
+				Write(bRel ? "{\"kind\":\"Relational\",\"op\":" : "{\"kind\":\"Arithmetic\",\"op\":");
+				WriteLex(eType);
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write(bRel ? "Relational(" : "Arithmetic(");
+				WriteLex(eType);
+				Write("):\n");
+			}
+
+			AddLabel(" Left:", ",\"left\":", nDepth);
+			AddExpression(pLeft, nDepth + 2);
+			AddLabel(" Right:", ",\"right\":", nDepth);
+			AddExpression(pRight, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::Unary:
+		{
+			const stUnary* pUn = static_cast<const stUnary*>(pExp);
+
+			if (bJson)
+			{
+				Write("{\"kind\":\"Unary\",\"op\":");
+				WriteLex(pUn->eType);
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Unary(");
+				WriteLex(pUn->eType);
+				Write("):\n");
+			}
+
+			AddLabel(" Subsituation expression:", ",\"operand\":", nDepth);
+			AddExpression(pUn->stSubExp, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::GetVariable:
+			if (bJson)
+			{
+				Write("{\"kind\":\"GetVariable\",\"name\":");
+				WriteSymbol(static_cast<const stGetVariable*>(pExp)->nSymbol);
+				Write('}');
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Get Variable: ");
+				WriteSymbol(static_cast<const stGetVariable*>(pExp)->nSymbol);
+				Write('\n');
+			}
+			break;
+		case eNodeKind::SetVariable:
+		{
+			const stSetVariable* pSetVar = static_cast<const stSetVariable*>(pExp);
+
+			if (bJson)
+			{
+				Write("{\"kind\":\"SetVariable\",\"name\":");
+				WriteSymbol(pSetVar->nSymbol);
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Set Variable: ");
+				WriteSymbol(pSetVar->nSymbol);
+				Write('\n');
+			}
+
+			AddLabel(" Init-expression:", ",\"init\":", nDepth);
+			AddExpression(pSetVar->stInitExp, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::GetElement:
+		{
+			const stGetElement* pGetElem = static_cast<const stGetElement*>(pExp);
+
+			WriteHeader(nDepth, "Get Element:", "GetElement");
+			AddLabel(" Container:", ",\"container\":", nDepth);
+			AddExpression(pGetElem->stMemsExp, nDepth + 2);
+			AddLabel(" Index:", ",\"index\":", nDepth);
+			AddExpression(pGetElem->stIndexExp, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::SetElement:
+		{
+			const stSetElement* pSetElem = static_cast<const stSetElement*>(pExp);
+
+			WriteHeader(nDepth, "Set Element:", "SetElement");
+			AddLabel(" Container:", ",\"container\":", nDepth);
+			AddExpression(pSetElem->stMemsExp, nDepth + 2);
+			AddLabel(" Index:", ",\"index\":", nDepth);
+			AddExpression(pSetElem->stIndexExp, nDepth + 2);
+			AddLabel(" Init-expression:", ",\"init\":", nDepth);
+			AddExpression(pSetElem->stInitExp, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::CallFunc:
+		{
+			const stCallFunc* pCall = static_cast<const stCallFunc*>(pExp);
+
+			WriteHeader(nDepth, "Call Function:", "CallFunc");
+			AddLabel(" Callee:", ",\"callee\":", nDepth);
+			AddExpression(pCall->stSubExp, nDepth + 2);
+			AddExpressionList(" Arguments:", ",\"args\":[", pCall->vArgsExp, nDepth, nDepth + 2);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		case eNodeKind::Convert:
+		{
+			const stConvert* pConv = static_cast<const stConvert*>(pExp);
+
+			if (bJson)
+			{
+				Write("{\"kind\":\"Convert\",\"type\":");
+				WriteString(GetValueTypeName(pConv->eValType));
+			}
+			else
+			{
+				WriteIndent(nDepth);
+				Write("Convert(");
+				Write(GetValueTypeName(pConv->eValType));
+				Write("):\n");
+			}
+
+			AddLabel("", ",\"expression\":", nDepth);
+			AddExpression(pConv->stSubExp, nDepth + 1);
+			AddLabel("", "}", nDepth);
+			break;
+		}
+		default:
+			break;
+	}
+
+	FlushChildren();
+}
+
+/**
+@brief		Write the line of a node (text) or open its object (JSON)
+@param		nDepth		Indent of the text
+@param		strText		Line of the text
+@param		strKind		Kind of the JSON object
+@return
+*/
+void CASTDumper::WriteHeader(int nDepth, std::string_view strText, std::string_view strKind)
+{
+	if (m_eFormat == eFormat::Json)
+	{
+		Write("{\"kind\":\"");
+		Write(strKind);
+		Write('"');
+	}
+	else
+	{
+		WriteIndent(nDepth);
+		Write(strText);
+		Write('\n');
+	}
+}
+
+/**
+@brief		Grow the buffer (at least doubled)
+@param		nSize		Bytes that have to fit after m_nPos
+@return
+*/
+void CASTDumper::Grow(size_t nSize)
+{
+	m_strOut.resize(std::max(m_strOut.size() * 2, m_nPos + nSize));
+}
+
+/**
+@brief		Write a quoted JSON string
+@param		strString	String
+@return
+*/
+void CASTDumper::WriteString(std::string_view strString)
+{
+	static const char HEX[] = "0123456789abcdef";
+
+	Write('"');
+
+	// Runs without a charactor to escape are appended at once
+	size_t nRun = 0;
+	for (size_t i = 0; i < strString.size(); ++i)
+	{
+		unsigned char ch = (unsigned char)strString[i];
+		if (ch >= 0x20 &&
+			ch != '"' &&
+			ch != '\\')
+			continue;
+
+		Write(std::string_view(strString.data() + nRun, i - nRun));
+		nRun = i + 1;
+
+		switch (ch)
+		{
+			case '"':
+				Write("\\\"");
+				break;
+			case '\\':
+				Write("\\\\");
+				break;
+			case '\n':
+				Write("\\n");
+				break;
+			case '\r':
+				Write("\\r");
+				break;
+			case '\t':
+				Write("\\t");
+				break;
+			default:
+				Write("\\u00");
+				Write(HEX[ch >> 4]);
+				Write(HEX[ch & 0xF]);
+				break;
+		}
+	}
+
+	Write(std::string_view(strString.data() + nRun, strString.size() - nRun));
+	Write('"');
+}
+
+/**
+@brief		Write an integer
+@param		nValue		Value
+@return
+*/
+void CASTDumper::WriteInt(long long nValue)
+{
+	char szBuffer[24];
+	std::to_chars_result result = std::to_chars(szBuffer, szBuffer + sizeof(szBuffer), nValue);
+
+	Write(std::string_view(szBuffer, result.ptr - szBuffer));
+}
+
+/**
+@brief		Write a double (%f like Print() in the text, round-trip precision in the JSON)
+@param		dValue		Value
+@return
+*/
+void CASTDumper::WriteDouble(double dValue)
+{
+	// %f of the largest double is 309 digits
+	char szBuffer[352];
+	int nLength = snprintf(szBuffer, sizeof(szBuffer), m_eFormat == eFormat::Json ? "%.17g" : "%f", dValue);
+
+	if (nLength > 0)
+		Write(std::string_view(szBuffer, std::min((size_t)nLength, sizeof(szBuffer) - 1)));
+}
+
+/**
+@brief		Add a label and the statements of a block
+@param		strLabel	Label line of the text ("": none)
+@param		strJson		Key and "[" of the JSON
+@param		vBlock		Block
+@param		nDepth		Indent of the label
+@param		nItemDepth	Indent of the statements
+@return
+*/
+void CASTDumper::AddBlock(std::string_view strLabel, std::string_view strJson, const vstStatement& vBlock, int nDepth, int nItemDepth)
+{
+	AddLabel(strLabel, strJson, nDepth);
+	for (size_t i = 0; i < vBlock.size(); ++i)
+	{
+		if (i > 0)
+			AddLabel("", ",", nDepth);
+		AddStatement(vBlock[i], nItemDepth);
+	}
+	AddLabel("", "]", nDepth);
+}
+
+/**
+@brief		Add a label and a list of expressions
+@param		strLabel	Label line of the text
+@param		strJson		Key and "[" of the JSON
+@param		vExp		Expressions
+@param		nDepth		Indent of the label
+@param		nItemDepth	Indent of the expressions
+@return
+*/
+void CASTDumper::AddExpressionList(std::string_view strLabel, std::string_view strJson, const vstExpression& vExp, int nDepth, int nItemDepth)
+{
+	AddLabel(strLabel, strJson, nDepth);
+	for (size_t i = 0; i < vExp.size(); ++i)
+	{
+		if (i > 0)
+			AddLabel("", ",", nDepth);
+		AddExpression(vExp[i], nItemDepth);
+	}
+	AddLabel("", "]", nDepth);
+}
+
+/**
+@brief		Reverse the tasks of the node on the stack, so they come out in order
+@return
+*/
+void CASTDumper::FlushChildren()
+{
+	std::reverse(m_vTask.begin() + m_nChildBase, m_vTask.end());
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Structures.h"
+
+// AST dumper
+// Writes a program into one growable buffer, as indented text (the layout of the nodes'
+// Print(), covering every node kind) or as JSON. Nodes are visited by their kind with an
+// explicit stack of tasks, so any nesting depth the parser accepts can be dumped. A task
+// is a node or a fragment written between nodes (a label line of the text, a piece of
+// the JSON). Once the buffer and the stacks have grown, nothing is allocated per node.
+class CASTDumper
+{
+// Enums and Classes, Structures ==========================================================
+public:
+	enum class eFormat
+	{
+		Text,
+		Json,
+	};
+
+private:
+	// Node (pState or pExp), fragment (strLabel and/or strJson) or, with none of them, a missing child
+	struct stTask
+	{
+	public:
+		const stStatement* pState;
+		const stExpression* pExp;
+		// Label line of the text (written at nDepth)
+		std::string_view strLabel;
+		// Piece of the JSON
+		std::string_view strJson;
+		int nDepth;
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	eFormat m_eFormat;
+	// Output buffer (m_nPos bytes are written; the rest is room to grow into)
+	std::string m_strOut;
+	size_t m_nPos;
+	// Tasks that are waiting to be written (last in, first out)
+	std::vector<stTask> m_vTask;
+	// First task of the node being written (its tasks are added in output order, then reversed)
+	size_t m_nChildBase;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CASTDumper(eFormat eFormatType = eFormat::Text);
+
+	std::string_view Dump(const stProgram& prog);
+	void Print(const stProgram& prog, FILE* pFile = stdout);
+
+	inline std::string_view Output() const
+	{
+		return std::string_view(m_strOut.data(), m_nPos);
+	}
+
+	inline eFormat GetFormat() const
+	{
+		return m_eFormat;
+	}
+
+private:
+	void DumpStatement(const stStatement* pState, int nDepth);
+	void DumpExpression(const stExpression* pExp, int nDepth);
+	void WriteHeader(int nDepth, std::string_view strText, std::string_view strKind);
+	void WriteString(std::string_view strString);
+	void WriteInt(long long nValue);
+	void WriteDouble(double dValue);
+	void AddBlock(std::string_view strLabel, std::string_view strJson, const vstStatement& vBlock, int nDepth, int nItemDepth);
+	void AddExpressionList(std::string_view strLabel, std::string_view strJson, const vstExpression& vExp, int nDepth, int nItemDepth);
+	void FlushChildren();
+
+	inline void BeginChildren()
+	{
+		m_nChildBase = m_vTask.size();
+	}
+	void Grow(size_t nSize);
+
+	inline void AddLabel(std::string_view strLabel, std::string_view strJson, int nDepth)
+	{
+		m_vTask.push_back(stTask{ nullptr, nullptr, strLabel, strJson, nDepth });
+	}
+
+	inline void AddStatement(const stStatement* pState, int nDepth)
+	{
+		m_vTask.push_back(stTask{ pState, nullptr, std::string_view(), std::string_view(), nDepth });
+	}
+
+	inline void AddExpression(const stExpression* pExp, int nDepth)
+	{
+		m_vTask.push_back(stTask{ nullptr, pExp, std::string_view(), std::string_view(), nDepth });
+	}
+
+	// Appends are a bounds check and a memcpy (no strlen, no std::string bookkeeping)
+	inline void Write(std::string_view strText)
+	{
+		if (strText.size() > m_strOut.size() - m_nPos)
+			Grow(strText.size());
+		memcpy(&m_strOut[m_nPos], strText.data(), strText.size());
+		m_nPos += strText.size();
+	}
+
+	inline void Write(char ch)
+	{
+		if (m_nPos == m_strOut.size())
+			Grow(1);
+		m_strOut[m_nPos++] = ch;
+	}
+
+	inline void WriteIndent(int nDepth)
+	{
+		if ((size_t)nDepth > m_strOut.size() - m_nPos)
+			Grow((size_t)nDepth);
+		memset(&m_strOut[m_nPos], ' ', (size_t)nDepth);
+		m_nPos += (size_t)nDepth;
+	}
+
+	inline void WriteSymbol(SymbolID nSymbol)
+	{
+		std::string_view strName = CSymbolTable::Global().GetName(nSymbol);
+
+		if (m_eFormat == eFormat::Json)
+			WriteString(strName);
+		else
+			Write(strName);
+	}
+
+	inline void WriteLex(CLexer::eLexEnum eLex)
+	{
+		const std::string& strLex = CLexer::FindLexToString(eLex);
+
+		if (m_eFormat == eFormat::Json)
+			WriteString(strLex);
+		else
+			Write(strLex);
+	}
+
+// ========================================================================================
+
+};
\ No newline at end of file
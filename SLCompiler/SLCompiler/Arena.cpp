@@ -0,0 +1,115 @@
+#include <cstdint>
+#include <cstring>
+#include "Arena.h"
+
+// Current arena of the thread
+thread_local CArena* CArena::m_pCurrent = nullptr;
+
+/**
+@brief		Arena
+@param		eArenaMode			Allocation mode
+@param		nFirstBlockSize		Size of the first block (small arenas start small; blocks double up to BLOCK_SIZE)
+*/
+CArena::CArena(eMode eArenaMode, size_t nFirstBlockSize)
+	: m_eMode(eArenaMode), m_pBlockPos(nullptr), m_nBlockLeft(0),
+	  m_nFirstBlockSize(nFirstBlockSize < BLOCK_SIZE ? nFirstBlockSize : BLOCK_SIZE), m_nBlockSize(m_nFirstBlockSize), m_nBytes(0)
+{}
+
+/**
+@brief		Allocate memory
+@param		nSize		Size
+@param		nAlign		Alignment (power of two, at most alignof(std::max_align_t))
+@return		Memory (valid until Release())
+*/
+void* CArena::Allocate(size_t nSize, size_t nAlign)
+{
+	if (nSize == 0)
+		nSize = 1;
+
+	m_nBytes += nSize;
+
+	if (m_eMode == eMode::Heap)
+	{
+		m_vBlock.emplace_back(new char[nSize]);
+		return m_vBlock.back().get();
+	}
+
+	size_t nPadding = (size_t)(-(intptr_t)m_pBlockPos) & (nAlign - 1);
+	if (m_pBlockPos == nullptr ||
+		nSize + nPadding > m_nBlockLeft)
+	{
+		// Big allocations get a block of their own, so the current block stays in use
+		if (nSize > BLOCK_SIZE / 4)
+		{
+			m_vBlock.emplace_back(new char[nSize]);
+			return m_vBlock.back().get();
+		}
+
+		size_t nBlockSize = m_nBlockSize;
+		while (nBlockSize < nSize)
+			nBlockSize *= 2;
+
+		m_vBlock.emplace_back(new char[nBlockSize]);
+		m_pBlockPos = m_vBlock.back().get();
+		m_nBlockLeft = nBlockSize;
+		m_nBlockSize = nBlockSize * 2 < BLOCK_SIZE ? nBlockSize * 2 : BLOCK_SIZE;
+		nPadding = 0;
+	}
+
+	char* p = m_pBlockPos + nPadding;
+	m_pBlockPos = p + nSize;
+	m_nBlockLeft -= nSize + nPadding;
+
+	return p;
+}
+
+/**
+@brief		Give memory back
+			(Only the last allocation of the current block is reused, e.g. a vector that grows
+			 in place; anything else is kept until Release())
+@param		p			Memory
+@param		nSize		Size
+@return
+*/
+void CArena::Free(void* p, size_t nSize)
+{
+	if (m_eMode == eMode::Heap ||
+		p == nullptr)
+		return;
+
+	if (static_cast<char*>(p) + nSize == m_pBlockPos)
+	{
+		m_pBlockPos = static_cast<char*>(p);
+		m_nBlockLeft += nSize;
+		m_nBytes -= nSize;
+	}
+}
+
+/**
+@brief		Copy a string into the arena
+@param		strString	String
+@return		Copied string
+*/
+std::string_view CArena::CopyString(std::string_view strString)
+{
+	if (strString.empty())
+		return std::string_view();
+
+	char* pCopy = static_cast<char*>(Allocate(strString.size(), 1));
+	memcpy(pCopy, strString.data(), strString.size());
+
+	return std::string_view(pCopy, strString.size());
+}
+
+/**
+@brief		Release every allocation at once (objects in the arena are not destructed)
+@return
+*/
+void CArena::Release()
+{
+	m_vBlock.clear();
+	m_pBlockPos = nullptr;
+	m_nBlockLeft = 0;
+	m_nBlockSize = m_nFirstBlockSize;
+	m_nBytes = 0;
+}
\ No newline at end of file
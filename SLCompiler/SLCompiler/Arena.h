@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Arena (AST node storage)
+// Allocations are bumped out of large blocks and are only given back all at once
+// by Release() or the destructor. Destructors of the objects are never run, so an
+// object that lives in the arena must keep all of its memory in the arena too.
+// The parser makes the program's arena current (CScope) while it builds the nodes;
+// CArenaAllocator takes the current arena, so child vectors land in it as well.
+class CArena
+{
+// Enums and Classes, Structures ==========================================================
+public:
+	enum class eMode
+	{
+		Block,					// Bump allocation out of large blocks
+		Heap,					// One heap block per allocation (baseline for the benchmark)
+	};
+
+	// Makes an arena current for the lifetime of the scope
+	class CScope
+	{
+	private:
+		CArena* m_pPrev;
+
+	public:
+		CScope(CArena& arena)
+			: m_pPrev(m_pCurrent)
+		{
+			m_pCurrent = &arena;
+		}
+
+		~CScope()
+		{
+			m_pCurrent = m_pPrev;
+		}
+
+		CScope(const CScope&) = delete;
+		CScope& operator=(const CScope&) = delete;
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+	static thread_local CArena* m_pCurrent;
+
+	eMode m_eMode;
+	// Blocks (every allocation in Heap mode)
+	std::vector<std::unique_ptr<char[]>> m_vBlock;
+	char* m_pBlockPos;
+	size_t m_nBlockLeft;
+	// Size of the first block and of the next block (blocks double up to BLOCK_SIZE)
+	size_t m_nFirstBlockSize;
+	size_t m_nBlockSize;
+	// Allocated bytes
+	size_t m_nBytes;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CArena(eMode eArenaMode = eMode::Block, size_t nFirstBlockSize = BLOCK_SIZE);
+	CArena(const CArena&) = delete;
+	CArena& operator=(const CArena&) = delete;
+
+	void* Allocate(size_t nSize, size_t nAlign = alignof(std::max_align_t));
+	void Free(void* p, size_t nSize);
+	std::string_view CopyString(std::string_view strString);
+	void Release();
+
+	template <typename T, typename... Args>
+	inline T* New(Args&&... args)
+	{
+		return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	inline eMode GetMode() const
+	{
+		return m_eMode;
+	}
+
+	inline size_t GetBytes() const
+	{
+		return m_nBytes;
+	}
+
+	inline static CArena* Current()
+	{
+		return m_pCurrent;
+	}
+
+// ========================================================================================
+
+};
+
+
+// Arena allocator (for the child vectors of the AST nodes)
+// Allocates from the arena that was current when the allocator was made, or from
+// the heap if there was none.
+template <typename T>
+class CArenaAllocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	CArena* m_pArena;
+
+	CArenaAllocator()
+		: m_pArena(CArena::Current())
+	{}
+
+	template <typename U>
+	CArenaAllocator(const CArenaAllocator<U>& other)
+		: m_pArena(other.m_pArena)
+	{}
+
+	inline T* allocate(size_t n)
+	{
+		if (m_pArena == nullptr)
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		return static_cast<T*>(m_pArena->Allocate(n * sizeof(T), alignof(T)));
+	}
+
+	inline void deallocate(T* p, size_t n)
+	{
+		if (m_pArena == nullptr)
+			::operator delete(p);
+		else
+			m_pArena->Free(p, n * sizeof(T));
+	}
+
+	template <typename U>
+	inline bool operator==(const CArenaAllocator<U>& other) const
+	{
+		return m_pArena == other.m_pArena;
+	}
+
+	template <typename U>
+	inline bool operator!=(const CArenaAllocator<U>& other) const
+	{
+		return m_pArena != other.m_pArena;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,1314 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include "ASTCache.h"
+#include "ASTDumper.h"
+#include "Benchmark.h"
+#include "ConstantFolder.h"
+#include "Corpus.h"
+#include "DeadCodeEliminator.h"
+#include "FlatAST.h"
+#include "IncrementalParser.h"
+#include "Interpreter.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "TypeChecker.h"
+#include "ThreadPool.h"
+#include "TokenBuffer.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Psapi.h>
+#pragma comment(lib, "Psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+/**
+@brief		Benchmark entry point
+@param		argc		Argument count
+@param		argv		Arguments (-bench [Corpus MB] [Repeat] [Max threads])
+@return		Process exit code
+*/
+int CBenchmark::Run(int argc, char* argv[])
+{
+	size_t nMegaBytes = argc > 2 ? (size_t)atoi(argv[2]) : 16;
+	int nRepeat = argc > 3 ? atoi(argv[3]) : 5;
+	int nMaxThreads = argc > 4 ? atoi(argv[4]) : (int)std::thread::hardware_concurrency();
+
+	if (nMegaBytes == 0 ||
+		nRepeat <= 0)
+	{
+		printf("Usage: %s -bench [Corpus MB] [Repeat] [Max threads]\n", argv[0]);
+		return 1;
+	}
+
+	std::string strSource = CCorpus::Make(CCorpus::eShape::Mixed, nMegaBytes * 1024 * 1024, 1);
+	BenchLexer(strSource, nRepeat);
+	BenchLexerParallel(strSource, nRepeat, nMaxThreads);
+	BenchParserParallel(strSource, nRepeat, nMaxThreads);
+	BenchRecovery(strSource, nRepeat);
+	BenchIncremental(strSource, 200);
+	BenchCache(strSource, nRepeat);
+	BenchDump(strSource, nRepeat);
+	BenchResolve(strSource, nRepeat);
+	BenchTypeCheck(strSource, nRepeat);
+	BenchFold(CCorpus::Make(CCorpus::eShape::Constant, strSource.size(), 1), nRepeat);
+	BenchDeadCode(CCorpus::Make(CCorpus::eShape::DeadCode, strSource.size(), 1), nRepeat);
+
+	return 0;
+}
+
+/**
+@brief		Shape benchmark entry point (lexer and parser measured separately)
+@param		argc		Argument count
+@param		argv		Arguments (-bench-shape [Shape|all] [Corpus MB] [Repeat] [Depth])
+@return		Process exit code
+*/
+int CBenchmark::RunShape(int argc, char* argv[])
+{
+	std::string strShape = argc > 2 ? argv[2] : "all";
+	size_t nMegaBytes = argc > 3 ? (size_t)atoi(argv[3]) : 4;
+	int nRepeat = argc > 4 ? atoi(argv[4]) : 3;
+	int nDepth = argc > 5 ? atoi(argv[5]) : 64;
+	CCorpus::eShape eShapeType = CCorpus::FindShape(strShape);
+
+	if ((eShapeType == CCorpus::eShape::ShapeMax && strShape != "all") ||
+		nMegaBytes == 0 ||
+		nRepeat <= 0 ||
+		nDepth <= 0)
+	{
+		printf("Usage: %s -bench-shape [Shape|all] [Corpus MB] [Repeat] [Depth]\n", argv[0]);
+		printf("Shapes:");
+		for (int i = 0; i < static_cast<int>(CCorpus::eShape::ShapeMax); ++i)
+			printf(" %s", CCorpus::GetShapeName(static_cast<CCorpus::eShape>(i)).c_str());
+		printf("\n");
+		return 1;
+	}
+
+	for (int i = 0; i < static_cast<int>(CCorpus::eShape::ShapeMax); ++i)
+	{
+		if (eShapeType != CCorpus::eShape::ShapeMax &&
+			eShapeType != static_cast<CCorpus::eShape>(i))
+			continue;
+
+		std::string strSource = CCorpus::Make(static_cast<CCorpus::eShape>(i), nMegaBytes * 1024 * 1024, nDepth);
+		BenchShape(static_cast<CCorpus::eShape>(i), strSource, nRepeat);
+	}
+
+	return 0;
+}
+
+// Programs of the interpreter benchmark (main returns the checked value)
+// The language has no mutable arrays, so "primes" counts by trial division instead of a sieve.
+static const char* const EXEC_FIB =
+	"int fib(int n)\n"
+	"{\n"
+	"\tif (n < 2)\n"
+	"\t{\n"
+	"\t\treturn n;\n"
+	"\t}\n"
+	"\treturn fib(n - 1) + fib(n - 2);\n"
+	"}\n"
+	"int main()\n"
+	"{\n"
+	"\treturn fib(25);\n"
+	"}\n";
+
+static const char* const EXEC_RECURSION =
+	"int sum(int n)\n"
+	"{\n"
+	"\tif (n == 0)\n"
+	"\t{\n"
+	"\t\treturn 0;\n"
+	"\t}\n"
+	"\treturn 1 + sum(n - 1);\n"
+	"}\n"
+	"int main()\n"
+	"{\n"
+	"\treturn sum(10000);\n"
+	"}\n";
+
+static const char* const EXEC_LOOPS =
+	"int main()\n"
+	"{\n"
+	"\tint nSum = 0;\n"
+	"\tfor (int i = 0; i < 1000; i = i + 1)\n"
+	"\t{\n"
+	"\t\tfor (int j = 0; j < 1000; j = j + 1)\n"
+	"\t\t{\n"
+	"\t\t\tnSum = (nSum + i * j) % 1000003;\n"
+	"\t\t}\n"
+	"\t}\n"
+	"\treturn nSum;\n"
+	"}\n";
+
+static const char* const EXEC_PRIMES =
+	"int main()\n"
+	"{\n"
+	"\tint nCount = 0;\n"
+	"\tfor (int n = 2; n < 30000; n = n + 1)\n"
+	"\t{\n"
+	"\t\tint nPrime = 1;\n"
+	"\t\tfor (int d = 2; d * d <= n; d = d + 1)\n"
+	"\t\t{\n"
+	"\t\t\tif (n % d == 0)\n"
+	"\t\t\t{\n"
+	"\t\t\t\tnPrime = 0;\n"
+	"\t\t\t\tbreak;\n"
+	"\t\t\t}\n"
+	"\t\t}\n"
+	"\t\tnCount = nCount + nPrime;\n"
+	"\t}\n"
+	"\treturn nCount;\n"
+	"}\n";
+
+static const char* const EXEC_STRINGS =
+	"int main()\n"
+	"{\n"
+	"\tstring strText = \"\";\n"
+	"\tfor (int i = 0; i < 2000; i = i + 1)\n"
+	"\t{\n"
+	"\t\tstrText = strText + \"ab\";\n"
+	"\t}\n"
+	"\tint nCount = 0;\n"
+	"\tfor (int j = 0; j < 4000; j = j + 1)\n"
+	"\t{\n"
+	"\t\tif (strText[j] == \"b\")\n"
+	"\t\t{\n"
+	"\t\t\tnCount = nCount + 1;\n"
+	"\t\t}\n"
+	"\t}\n"
+	"\treturn nCount;\n"
+	"}\n";
+
+// The default labels are not last, so a case that does not match falls through the arms after the default
+static const char* const EXEC_SWITCH =
+	"int main()\n"
+	"{\n"
+	"\tint nSum = 0;\n"
+	"\tfor (int i = 0; i < 10000; i = i + 1)\n"
+	"\t{\n"
+	"\t\tswitch (i % 4)\n"
+	"\t\t{\n"
+	"\t\t\tcase 1:\n"
+	"\t\t\t\tnSum = nSum + 1;\n"
+	"\t\t\tdefault:\n"
+	"\t\t\t\tnSum = nSum + 10;\n"
+	"\t\t\tcase 3:\n"
+	"\t\t\t\tnSum = nSum + 100;\n"
+	"\t\t\t\tbreak;\n"
+	"\t\t\tcase 0:\n"
+	"\t\t\t\tnSum = nSum + 1000;\n"
+	"\t\t}\n"
+	"\t\tswitch (i % 3)\n"
+	"\t\t{\n"
+	"\t\t\tdefault:\n"
+	"\t\t\t\tnSum = nSum + 7;\n"
+	"\t\t\tcase 1:\n"
+	"\t\t\t\tnSum = nSum + 13;\n"
+	"\t\t\t\tbreak;\n"
+	"\t\t\tcase 2:\n"
+	"\t\t\t\tnSum = nSum + 17;\n"
+	"\t\t}\n"
+	"\t}\n"
+	"\treturn nSum;\n"
+	"}\n";
+
+/**
+@brief		Interpreter benchmark entry point
+@param		argc		Argument count
+@param		argv		Arguments (-bench-exec [Repeat])
+@return		Process exit code (1 if a program returned a wrong value)
+*/
+int CBenchmark::RunExec(int argc, char* argv[])
+{
+	int nRepeat = argc > 2 ? atoi(argv[2]) : 5;
+
+	if (nRepeat <= 0)
+	{
+		printf("Usage: %s -bench-exec [Repeat]\n", argv[0]);
+		return 1;
+	}
+
+	// Value of the loops program, computed natively
+	int nLoops = 0;
+	for (int i = 0; i < 1000; ++i)
+	{
+		for (int j = 0; j < 1000; ++j)
+			nLoops = (nLoops + i * j) % 1000003;
+	}
+
+	bool bOk = true;
+	bOk &= BenchExec("fib", EXEC_FIB, 75025, nRepeat);
+	bOk &= BenchExec("recursion", EXEC_RECURSION, 10000, nRepeat);
+	bOk &= BenchExec("loops", EXEC_LOOPS, nLoops, nRepeat);
+	bOk &= BenchExec("primes", EXEC_PRIMES, 3245, nRepeat);
+	bOk &= BenchExec("strings", EXEC_STRINGS, 2000, nRepeat);
+	bOk &= BenchExec("switch", EXEC_SWITCH, 3469170, nRepeat);
+
+	return bOk ? 0 : 1;
+}
+
+/**
+@brief		Lexer throughput benchmark
+@param		strSource		Source code
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchLexer(const std::string& strSource, int nRepeat)
+{
+	double dBest = 0.0;
+	size_t nTokens = 0;
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		Clock::time_point tStart = Clock::now();
+		std::vector<CLexer::stToken> vTokens = CLexer::Scan(strSource);
+		double dSec = ElapsedSec(tStart);
+
+		nTokens = vTokens.size();
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	printf("[Lexer] %zu bytes, %zu tokens, best of %d: %.3f ms, %.1f MB/s, %.1f Mtokens/s\n",
+		   strSource.size(), nTokens, nRepeat, dBest * 1000.0,
+		   strSource.size() / dBest / (1024.0 * 1024.0), nTokens / dBest / 1000000.0);
+
+	// Struct-of-arrays token buffer
+	CTokenBuffer buffer;
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		Clock::time_point tStart = Clock::now();
+		CLexer::Scan(strSource, buffer);
+		double dSec = ElapsedSec(tStart);
+
+		nTokens = buffer.Size() - 1;
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	printf("[Lexer buffer] %zu bytes, %zu tokens, best of %d: %.3f ms, %.1f MB/s, %.1f Mtokens/s\n",
+		   strSource.size(), nTokens, nRepeat, dBest * 1000.0,
+		   strSource.size() / dBest / (1024.0 * 1024.0), nTokens / dBest / 1000000.0);
+
+	// Pull-style lexer (no token vector)
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		Clock::time_point tStart = Clock::now();
+		CLexerStream stream(strSource);
+		CLexer::stToken stTokenData;
+		size_t nCount = 0;
+		while (stream.NextToken(stTokenData))
+			++nCount;
+		double dSec = ElapsedSec(tStart);
+
+		nTokens = nCount;
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	printf("[Lexer stream] %zu bytes, %zu tokens, best of %d: %.3f ms, %.1f MB/s, %.1f Mtokens/s\n",
+		   strSource.size(), nTokens, nRepeat, dBest * 1000.0,
+		   strSource.size() / dBest / (1024.0 * 1024.0), nTokens / dBest / 1000000.0);
+}
+
+/**
+@brief		Parallel lexer scaling benchmark (1, 2, 4, ... threads)
+@param		strSource		Source code
+@param		nRepeat			Repeat count (the best run is reported)
+@param		nMaxThreads		Maximum thread count
+@return
+*/
+void CBenchmark::BenchLexerParallel(const std::string& strSource, int nRepeat, int nMaxThreads)
+{
+	std::vector<CLexer::stToken> vSerial = CLexer::Scan(strSource);
+	double dBase = 0.0;
+
+	if (nMaxThreads < 1)
+		nMaxThreads = 1;
+
+	for (int nThreads = 1; ; nThreads = std::min(nThreads * 2, nMaxThreads))
+	{
+		CThreadPool pool(nThreads);
+		std::vector<CLexer::stToken> vTokens;
+		double dBest = 0.0;
+
+		for (int i = 0; i < nRepeat; ++i)
+		{
+			Clock::time_point tStart = Clock::now();
+			vTokens = CLexer::ScanParallel(strSource, pool);
+			double dSec = ElapsedSec(tStart);
+
+			if (i == 0 || dSec < dBest)
+				dBest = dSec;
+		}
+
+		// Output must be identical to the serial scanner
+		bool bSame = IsSameTokens(vTokens, vSerial);
+
+		if (nThreads == 1)
+			dBase = dBest;
+
+		printf("[Lexer parallel] %2d threads, best of %d: %.3f ms, %.1f MB/s, speedup %.2fx, %s\n",
+			   nThreads, nRepeat, dBest * 1000.0, strSource.size() / dBest / (1024.0 * 1024.0),
+			   dBase / dBest, bSame ? "identical" : "MISMATCH");
+
+		if (nThreads >= nMaxThreads)
+			break;
+	}
+
+	// A chunk that ends in lexical errors must not scan into the next chunk
+	std::string strError;
+	strError.reserve(3 * 1024 * 1024);
+	while (strError.size() < 3 * 1024 * 1024)
+		strError += "a=1;@\n";
+
+	CThreadPool pool(std::max(nMaxThreads, 4));
+	CDiagnostics diagSerial;
+	CDiagnostics diagParallel;
+	std::vector<CLexer::stToken> vErrorSerial = CLexer::Scan(strError, &diagSerial);
+	std::vector<CLexer::stToken> vErrorTokens = CLexer::ScanParallel(strError, pool, &diagParallel);
+	bool bSame = IsSameTokens(vErrorTokens, vErrorSerial) && diagParallel.ErrorCount() == diagSerial.ErrorCount();
+
+	printf("[Lexer parallel] error input, %d threads: %zu tokens (serial %zu), %zu errors (serial %zu), %s\n",
+		   pool.GetThreadCount(), vErrorTokens.size(), vErrorSerial.size(), diagParallel.ErrorCount(), diagSerial.ErrorCount(),
+		   bSame ? "identical" : "MISMATCH");
+}
+
+/**
+@brief		Parallel parser scaling benchmark (1, 2, 4, ... threads)
+@param		strSource		Source code
+@param		nRepeat			Repeat count (the best run is reported)
+@param		nMaxThreads		Maximum thread count
+@return
+*/
+void CBenchmark::BenchParserParallel(const std::string& strSource, int nRepeat, int nMaxThreads)
+{
+	CTokenBuffer buffer;
+	CLexer::Scan(strSource, buffer);
+
+	stProgram* pSerial = CParser::Parser(buffer);
+	if (pSerial == nullptr)
+	{
+		printf("[Parser parallel] parse failed\n");
+		return;
+	}
+
+	CFlatAST astSerial;
+	astSerial.Build(*pSerial);
+	DeletePtr<stProgram>(pSerial);
+
+	double dBase = 0.0;
+
+	if (nMaxThreads < 1)
+		nMaxThreads = 1;
+
+	for (int nThreads = 1; ; nThreads = std::min(nThreads * 2, nMaxThreads))
+	{
+		CThreadPool pool(nThreads);
+		CFlatAST ast;
+		double dBest = 0.0;
+
+		for (int i = 0; i < nRepeat; ++i)
+		{
+			Clock::time_point tStart = Clock::now();
+			stProgram* pProg = CParser::ParserParallel(buffer, pool);
+			double dSec = ElapsedSec(tStart);
+
+			if (pProg == nullptr)
+			{
+				printf("[Parser parallel] parse failed\n");
+				return;
+			}
+
+			// Output must be identical to the serial parser
+			if (i == 0)
+				ast.Build(*pProg);
+			DeletePtr<stProgram>(pProg);
+
+			if (i == 0 || dSec < dBest)
+				dBest = dSec;
+		}
+
+		if (nThreads == 1)
+			dBase = dBest;
+
+		printf("[Parser parallel] %2d threads, best of %d: %.3f ms, %.1f Mnodes/s, speedup %.2fx, %s\n",
+			   nThreads, nRepeat, dBest * 1000.0, ast.Size() / dBest / 1000000.0,
+			   dBase / dBest, IsSameAST(ast, astSerial) ? "identical" : "MISMATCH");
+
+		if (nThreads >= nMaxThreads)
+			break;
+	}
+}
+
+// Every n-th statement of the broken source has errors
+static const size_t RECOVERY_ERROR_STRIDE = 32;
+
+/**
+@brief		Error recovery benchmark (a clean and a broken copy of the source, scanned and parsed
+			with diagnostics, as a batch compiler does file after file)
+@param		strSource		Source code
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchRecovery(const std::string& strSource, int nRepeat)
+{
+	// An unknown charactor and a stray ")" before every n-th ";"
+	std::string strBroken;
+	size_t nSemicolons = 0;
+
+	strBroken.reserve(strSource.size() + strSource.size() / 16);
+	for (char ch : strSource)
+	{
+		if (ch == ';' &&
+			++nSemicolons % RECOVERY_ERROR_STRIDE == 0)
+			strBroken += " # )";
+		strBroken += ch;
+	}
+
+	const std::string* pArrSource[] = { &strSource, &strBroken };
+	const char* pArrName[] = { "clean", "broken" };
+	double dClean = 0.0;
+
+	for (int nMode = 0; nMode < 2; ++nMode)
+	{
+		double dBest = 0.0;
+		size_t nFunc = 0;
+		size_t nErrors = 0;
+
+		for (int i = 0; i < nRepeat; ++i)
+		{
+			CDiagnostics diag;
+			Clock::time_point tStart = Clock::now();
+			CLexerStream stream(*pArrSource[nMode], &diag);
+			stProgram* pProg = CParser::Parser(stream, CParser::eParseMode::Auto, &diag);
+			double dSec = ElapsedSec(tStart);
+
+			nFunc = pProg->vFunc.size();
+			nErrors = diag.ErrorCount();
+			DeletePtr<stProgram>(pProg);
+
+			if (i == 0 || dSec < dBest)
+				dBest = dSec;
+		}
+
+		if (nMode == 0)
+			dClean = dBest;
+
+		printf("[Recovery] %-6s scan + parse, best of %d: %.3f ms, %.1f MB/s, %zu functions, %zu errors, %.2fx of clean\n",
+			   pArrName[nMode], nRepeat, dBest * 1000.0, pArrSource[nMode]->size() / dBest / (1024.0 * 1024.0),
+			   nFunc, nErrors, dClean / dBest);
+	}
+}
+
+/**
+@brief		Incremental parser benchmark (edit latency vs a full re-parse)
+@param		strSource		Source code
+@param		nEdits			Edit count (each is a statement typed after a ";" and then removed)
+@return
+*/
+void CBenchmark::BenchIncremental(const std::string& strSource, int nEdits)
+{
+	static const char STATEMENT[] = " nEdit = nEdit + 1;";
+	CIncrementalParser incremental;
+
+	Clock::time_point tStart = Clock::now();
+	incremental.Open(strSource);
+	double dOpen = ElapsedSec(tStart);
+
+	double dTotal = 0.0;
+	double dMax = 0.0;
+	size_t nLexedBytes = 0;
+	size_t nSeed = 1;
+	size_t nOffset = 0;
+
+	for (int i = 0; i < nEdits * 2; ++i)
+	{
+		// Insert after a pseudo-random ";" (even edits), then remove it again (odd edits)
+		if (i % 2 == 0)
+		{
+			nSeed = nSeed * 6364136223846793005ull + 1442695040888963407ull;
+			nOffset = incremental.Source().find(';', (size_t)(nSeed >> 33) % incremental.Source().size());
+			nOffset = nOffset == std::string::npos ? 0 : nOffset + 1;
+		}
+
+		tStart = Clock::now();
+		if (i % 2 == 0)
+			incremental.Edit(nOffset, 0, STATEMENT);
+		else
+			incremental.Edit(nOffset, sizeof(STATEMENT) - 1, std::string_view());
+		double dSec = ElapsedSec(tStart);
+
+		dTotal += dSec;
+		dMax = std::max(dMax, dSec);
+		nLexedBytes += incremental.GetLastEdit().nLexedBytes;
+	}
+
+	// Output must be identical to a full parse of the edited source
+	CLexerStream stream(incremental.Source());
+	tStart = Clock::now();
+	stProgram* pFull = CParser::Parser(stream);
+	double dFull = ElapsedSec(tStart);
+
+	stProgram progView;
+	incremental.GetFunctions(progView.vFunc);
+	progView.nNodeCount = incremental.GetNodeCount();
+
+	CFlatAST astFull;
+	CFlatAST astIncremental;
+	astFull.Build(*pFull);
+	astIncremental.Build(progView);
+	DeletePtr<stProgram>(pFull);
+
+	printf("[Incremental] open %.3f ms, %zu units; %d edits: mean %.1f us, max %.1f us, %.0f bytes re-lexed per edit; full re-parse %.3f ms (%.0fx), %s\n",
+		   dOpen * 1000.0, incremental.GetUnitCount(), nEdits * 2, dTotal / (nEdits * 2) * 1000000.0, dMax * 1000000.0,
+		   (double)nLexedBytes / (nEdits * 2), dFull * 1000.0, dFull / (dTotal / (nEdits * 2)),
+		   IsSameAST(astFull, astIncremental) ? "identical" : "MISMATCH");
+}
+
+/**
+@brief		AST cache benchmark (cold: scan + parse + store, warm: map the cached AST)
+@param		strSource		Source code
+@param		nRepeat			Repeat count (best time is reported)
+@return
+*/
+void CBenchmark::BenchCache(const std::string& strSource, int nRepeat)
+{
+	std::error_code error;
+	std::filesystem::path pathDir = std::filesystem::temp_directory_path(error) / "slc-bench-cache";
+	CASTCache cache(pathDir.string());
+	double dCold = 0.0;
+	double dWarm = 0.0;
+	double dRebuild = 0.0;
+	CFlatAST astParsed;
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		std::filesystem::remove_all(pathDir, error);
+
+		Clock::time_point tStart = Clock::now();
+		CLexerStream stream(strSource);
+		stProgram* pProg = CParser::Parser(stream);
+		astParsed.Build(*pProg);
+		bool bStored = cache.Store(strSource, astParsed);
+		double dSec = ElapsedSec(tStart);
+		DeletePtr<stProgram>(pProg);
+
+		if (bStored == false)
+		{
+			printf("[Cache] cannot write %s\n", cache.Dir().c_str());
+			return;
+		}
+
+		if (i == 0 || dSec < dCold)
+			dCold = dSec;
+	}
+
+	CFlatAST astCached;
+	bool bSame = true;
+	bool bMapped = false;
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		Clock::time_point tStart = Clock::now();
+		bool bHit = cache.Load(strSource, astCached);
+		double dSec = ElapsedSec(tStart);
+
+		// Warm and then a stProgram for the passes that walk the node tree
+		stProgram prog;
+		astCached.ToProgram(prog);
+		double dRebuildSec = ElapsedSec(tStart);
+
+		CFlatAST astRebuilt;
+		astRebuilt.Build(prog);
+		bSame = bSame && bHit && IsSameAST(astParsed, astCached) && IsSameAST(astParsed, astRebuilt);
+		bMapped = astCached.IsMapped();
+
+		if (i == 0 || dSec < dWarm)
+			dWarm = dSec;
+		if (i == 0 || dRebuildSec < dRebuild)
+			dRebuild = dRebuildSec;
+	}
+
+	uintmax_t nFileSize = std::filesystem::file_size(cache.GetPath(strSource), error);
+	astCached.Clear();
+	std::filesystem::remove_all(pathDir, error);
+
+	printf("[Cache] file %.1f MB (%.2fx of source), %s\n",
+		   (double)nFileSize / (1024.0 * 1024.0), (double)nFileSize / strSource.size(), bMapped ? "mapped" : "copied");
+	printf("[Cache] cold  scan + parse + store, best of %d: %.3f ms\n", nRepeat, dCold * 1000.0);
+	printf("[Cache] warm  load, best of %d: %.3f ms (%.0fx), %s\n", nRepeat, dWarm * 1000.0, dCold / dWarm, bSame ? "identical" : "MISMATCH");
+	printf("[Cache] warm  load + ToProgram, best of %d: %.3f ms (%.1fx)\n", nRepeat, dRebuild * 1000.0, dCold / dRebuild);
+}
+
+/**
+@brief		AST dumper benchmark (against a copy of the same number of bytes)
+@param		strSource		Source code
+@param		nRepeat			Repeat count (best time is reported)
+@return
+*/
+void CBenchmark::BenchDump(const std::string& strSource, int nRepeat)
+{
+	CLexerStream stream(strSource);
+	stProgram* pProg = CParser::Parser(stream);
+	CASTDumper::eFormat arrFormat[] = { CASTDumper::eFormat::Text, CASTDumper::eFormat::Json };
+	const char* pArrName[] = { "text", "json" };
+
+	for (int nFormat = 0; nFormat < 2; ++nFormat)
+	{
+		CASTDumper dumper(arrFormat[nFormat]);
+		double dBest = 0.0;
+		double dCopy = 0.0;
+
+		for (int i = 0; i < nRepeat; ++i)
+		{
+			Clock::time_point tStart = Clock::now();
+			dumper.Dump(*pProg);
+			double dSec = ElapsedSec(tStart);
+
+			if (i == 0 || dSec < dBest)
+				dBest = dSec;
+		}
+
+		// Memory bandwidth for the same output
+		std::string strCopy(dumper.Output().size(), '\0');
+		for (int i = 0; i < nRepeat; ++i)
+		{
+			Clock::time_point tStart = Clock::now();
+			memcpy(&strCopy[0], dumper.Output().data(), strCopy.size());
+			double dSec = ElapsedSec(tStart);
+
+			if (i == 0 || dSec < dCopy)
+				dCopy = dSec;
+		}
+
+		double dMegaBytes = dumper.Output().size() / (1024.0 * 1024.0);
+		printf("[Dump] %s %.1f MB, best of %d: %.3f ms, %.1f MB/s, %.1f Mnodes/s (memcpy %.1f MB/s)\n",
+			   pArrName[nFormat], dMegaBytes, nRepeat, dBest * 1000.0, dMegaBytes / dBest,
+			   pProg->nNodeCount / dBest / 1000000.0, dMegaBytes / dCopy);
+	}
+
+	DeletePtr<stProgram>(pProg);
+}
+
+/**
+@brief		Scope resolution benchmark
+@param		strSource		Source code
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchResolve(const std::string& strSource, int nRepeat)
+{
+	CLexerStream stream(strSource);
+	stProgram* pProg = CParser::Parser(stream);
+	CResolver resolver;
+	CDiagnostics diag;
+	double dBest = 0.0;
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		diag.Clear();
+		Clock::time_point tStart = Clock::now();
+		resolver.Resolve(*pProg, &diag);
+		double dSec = ElapsedSec(tStart);
+
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	unsigned int nMaxFrame = 0;
+	size_t nSlots = 0;
+	for (const stFunction* pFunc : pProg->vFunc)
+	{
+		nMaxFrame = std::max(nMaxFrame, pFunc->nFrameSize);
+		nSlots += pFunc->nFrameSize;
+	}
+
+	printf("[Resolve] %zu functions, best of %d: %.3f ms, %.1f Mnodes/s, frame mean %.1f / max %u slots, %zu errors\n",
+		   pProg->vFunc.size(), nRepeat, dBest * 1000.0, pProg->nNodeCount / dBest / 1000000.0,
+		   pProg->vFunc.empty() ? 0.0 : (double)nSlots / pProg->vFunc.size(), nMaxFrame, diag.ErrorCount());
+
+	DeletePtr<stProgram>(pProg);
+}
+
+/**
+@brief		Type checker benchmark (the conversions are inserted by the first run)
+@param		strSource		Source code
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchTypeCheck(const std::string& strSource, int nRepeat)
+{
+	CLexerStream stream(strSource);
+	stProgram* pProg = CParser::Parser(stream);
+	CResolver resolver;
+	CTypeChecker checker;
+	CDiagnostics diag;
+	double dBest = 0.0;
+	size_t nConverts = 0;
+
+	resolver.Resolve(*pProg, &diag);
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		diag.Clear();
+		Clock::time_point tStart = Clock::now();
+		checker.Check(*pProg, &diag);
+		double dSec = ElapsedSec(tStart);
+
+		if (i == 0)
+			nConverts = checker.GetConvertCount();
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	printf("[Types] %zu functions, best of %d: %.3f ms, %.1f Mnodes/s, %zu conversions, %zu errors\n",
+		   pProg->vFunc.size(), nRepeat, dBest * 1000.0, pProg->nNodeCount / dBest / 1000000.0, nConverts, diag.ErrorCount());
+
+	DeletePtr<stProgram>(pProg);
+}
+
+/**
+@brief		Constant folder benchmark (a fold changes the program, so every run folds a new parse)
+@param		strSource		Source code (constant corpus)
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchFold(const std::string& strSource, int nRepeat)
+{
+	CConstantFolder folder;
+	CDiagnostics diag;
+	double dBest = 0.0;
+	size_t nFunc = 0;
+	size_t nNodes = 0;
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		CLexerStream stream(strSource);
+		stProgram* pProg = CParser::Parser(stream);
+		CResolver resolver;
+		CTypeChecker checker;
+
+		diag.Clear();
+		resolver.Resolve(*pProg, &diag);
+		checker.Check(*pProg, &diag);
+
+		Clock::time_point tStart = Clock::now();
+		folder.Fold(*pProg, &diag);
+		double dSec = ElapsedSec(tStart);
+
+		nFunc = pProg->vFunc.size();
+		nNodes = pProg->nNodeCount;
+		DeletePtr<stProgram>(pProg);
+
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	const CConstantFolder::stFoldStats& stStats = folder.GetStats();
+	printf("[Fold] %zu functions, best of %d: %.3f ms, %.1f Mnodes/s, %zu folded, %zu simplified, %zu arms pruned, %zu warnings\n",
+		   nFunc, nRepeat, dBest * 1000.0, nNodes / dBest / 1000000.0, stStats.nFolded, stStats.nSimplified, stStats.nPrunedArms,
+		   diag.Get().size() - diag.ErrorCount());
+}
+
+/**
+@brief		Dead code eliminator benchmark (every run eliminates in a new parse)
+@param		strSource		Source code (dead code corpus)
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchDeadCode(const std::string& strSource, int nRepeat)
+{
+	CDeadCodeEliminator eliminator;
+	double dBest = 0.0;
+	size_t nFunc = 0;
+	size_t nNodes = 0;
+	size_t nErrors = 0;
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		CLexerStream stream(strSource);
+		stProgram* pProg = CParser::Parser(stream);
+		CResolver resolver;
+		CTypeChecker checker;
+		CConstantFolder folder;
+		CDiagnostics diag;
+
+		resolver.Resolve(*pProg, &diag);
+		checker.Check(*pProg, &diag);
+		folder.Fold(*pProg, &diag);
+		nFunc = pProg->vFunc.size();
+		nNodes = pProg->nNodeCount;
+		nErrors = diag.ErrorCount();
+
+		Clock::time_point tStart = Clock::now();
+		eliminator.Eliminate(*pProg);
+		double dSec = ElapsedSec(tStart);
+
+		DeletePtr<stProgram>(pProg);
+
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	const CDeadCodeEliminator::stDeadCodeStats& stStats = eliminator.GetStats();
+	printf("[DeadCode] %zu functions, best of %d: %.3f ms, %.1f Mnodes/s, %zu statements and %zu functions removed, %zu errors\n",
+		   nFunc, nRepeat, dBest * 1000.0, nNodes / dBest / 1000000.0, stStats.nStatements, stStats.nFunctions, nErrors);
+}
+
+/**
+@brief		Interpreter benchmark (the program is checked and optimized once, then run nRepeat times)
+@param		pName			Program name
+@param		strSource		Source code (main returns an int)
+@param		nExpected		Value that main has to return
+@param		nRepeat			Repeat count (the best run is reported)
+@return		Whether every run returned nExpected
+*/
+bool CBenchmark::BenchExec(const char* pName, const std::string& strSource, int nExpected, int nRepeat)
+{
+	CDiagnostics diag;
+	CLexerStream stream(strSource);
+	stProgram* pProg = CParser::Parser(stream, CParser::eParseMode::Auto, &diag);
+	CResolver resolver;
+	CTypeChecker checker;
+	CConstantFolder folder;
+	CDeadCodeEliminator eliminator;
+
+	resolver.Resolve(*pProg, &diag);
+	checker.Check(*pProg, &diag);
+	folder.Fold(*pProg, &diag);
+	eliminator.Eliminate(*pProg);
+
+	if (diag.HasError())
+	{
+		printf("[Exec %s] %zu errors\n", pName, diag.ErrorCount());
+		diag.Sort();
+		diag.Print(strSource);
+		DeletePtr<stProgram>(pProg);
+		return false;
+	}
+
+	// printf output is kept in a string, so the terminal is not measured
+	CInterpreter interpreter;
+	std::string strOut;
+	interpreter.SetOutput(&strOut);
+
+	double dBest = 0.0;
+	size_t nOps = 0;
+	int nResult = 0;
+	bool bOk = true;
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		stValue valResult;
+		strOut.clear();
+
+		Clock::time_point tStart = Clock::now();
+		bool bRun = interpreter.Run(*pProg, valResult, &diag);
+		double dSec = ElapsedSec(tStart);
+
+		nResult = valResult.eType == eValueType::Int ? valResult.nData : 0;
+		bOk = bOk && bRun && valResult.eType == eValueType::Int && nResult == nExpected;
+		nOps = interpreter.GetOpCount();
+
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	printf("[Exec %s] result %d (%s), best of %d: %.3f ms, %zu ops, %.1f Mops/s\n",
+		   pName, nResult, bOk ? "ok" : "FAIL", nRepeat, dBest * 1000.0, nOps, nOps / dBest / 1000000.0);
+	diag.Sort();
+	diag.Print(strSource);
+
+	DeletePtr<stProgram>(pProg);
+	return bOk;
+}
+
+/**
+@brief		Compare two token streams
+@param		vA		Tokens
+@param		vB		Tokens
+@return		Whether the kinds, source slices and values are the same
+*/
+bool CBenchmark::IsSameTokens(const std::vector<CLexer::stToken>& vA, const std::vector<CLexer::stToken>& vB)
+{
+	if (vA.size() != vB.size())
+		return false;
+
+	for (size_t i = 0; i < vA.size(); ++i)
+	{
+		bool bSame = vA[i].eLex == vB[i].eLex &&
+					 vA[i].strString.data() == vB[i].strString.data() &&
+					 vA[i].strString.size() == vB[i].strString.size() &&
+					 (vA[i].eLex == CLexer::eLexEnum::Double ?
+					  vA[i].uValue.dDouble == vB[i].uValue.dDouble :
+					  vA[i].uValue.nInt == vB[i].uValue.nInt);
+		if (bSame == false)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+@brief		Compare two flat ASTs node by node
+@param		astA		AST
+@param		astB		AST
+@return		Whether the nodes, lists and strings are the same
+*/
+bool CBenchmark::IsSameAST(const CFlatAST& astA, const CFlatAST& astB)
+{
+	if (astA.Size() != astB.Size() ||
+		astA.GetBytes() != astB.GetBytes())
+		return false;
+
+	for (NodeID nNode = 0; nNode < astA.Size(); ++nNode)
+	{
+		if (astA.Kind(nNode) != astB.Kind(nNode) ||
+			astA.Op(nNode) != astB.Op(nNode) ||
+			astA.A(nNode) != astB.A(nNode) ||
+			astA.B(nNode) != astB.B(nNode) ||
+			astA.C(nNode) != astB.C(nNode))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+@brief		Lexer and parser benchmark of one corpus shape
+@param		eShapeType		Corpus shape
+@param		strSource		Source code
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchShape(CCorpus::eShape eShapeType, const std::string& strSource, int nRepeat)
+{
+	const char* pName = CCorpus::GetShapeName(eShapeType).c_str();
+	double dMegaBytes = strSource.size() / (1024.0 * 1024.0);
+	CTokenBuffer buffer;
+	double dBest = 0.0;
+
+	// Lexer
+	ResetPeakRSS();
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		Clock::time_point tStart = Clock::now();
+		CLexer::Scan(strSource, buffer);
+		double dSec = ElapsedSec(tStart);
+
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	size_t nTokens = buffer.Size() - 1;
+	printf("[Scan   %-10s] %.1f MB, %zu tokens, best of %d: %.3f ms, %.1f MB/s, %.1f Mtokens/s, peak RSS %.1f MB\n",
+		   pName, dMegaBytes, nTokens, nRepeat, dBest * 1000.0,
+		   dMegaBytes / dBest, nTokens / dBest / 1000000.0, PeakRSS() / (1024.0 * 1024.0));
+
+	// Parser (the program is released outside the timed region)
+	size_t nNodes = 0;
+	ResetPeakRSS();
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		Clock::time_point tStart = Clock::now();
+		stProgram* pProg = CParser::Parser(buffer);
+		double dSec = ElapsedSec(tStart);
+
+		if (pProg == nullptr)
+		{
+			printf("[Parser %-10s] parse failed\n", pName);
+			return;
+		}
+
+		nNodes = pProg->nNodeCount;
+		DeletePtr<stProgram>(pProg);
+
+		if (i == 0 || dSec < dBest)
+			dBest = dSec;
+	}
+
+	printf("[Parser %-10s] %zu tokens, %zu nodes, best of %d: %.3f ms, %.1f MB/s, %.1f Mtokens/s, %.1f Mnodes/s, peak RSS %.1f MB\n",
+		   pName, nTokens, nNodes, nRepeat, dBest * 1000.0, dMegaBytes / dBest,
+		   nTokens / dBest / 1000000.0, nNodes / dBest / 1000000.0, PeakRSS() / (1024.0 * 1024.0));
+
+	BenchStream(eShapeType, strSource, nRepeat);
+	BenchParseMode(eShapeType, buffer, nRepeat);
+	BenchArena(eShapeType, buffer, nRepeat);
+	BenchFlat(eShapeType, buffer, nRepeat);
+}
+
+/**
+@brief		Parse and teardown benchmark of the node allocation (one heap block per node vs arena)
+@param		eShapeType		Corpus shape
+@param		buffer			Tokens of the corpus
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchArena(CCorpus::eShape eShapeType, const CTokenBuffer& buffer, int nRepeat)
+{
+	const char* pName = CCorpus::GetShapeName(eShapeType).c_str();
+	const CArena::eMode eArrMode[] = { CArena::eMode::Heap, CArena::eMode::Block };
+	const char* pArrModeName[] = { "heap", "arena" };
+	double dBaseTotal = 0.0;
+
+	for (int nMode = 0; nMode < 2; ++nMode)
+	{
+		double dBestParse = 0.0;
+		double dBestFree = 0.0;
+		size_t nBytes = 0;
+
+		for (int i = 0; i < nRepeat; ++i)
+		{
+			Clock::time_point tStart = Clock::now();
+			stProgram* pProg = CParser::Parser(buffer, eArrMode[nMode]);
+			double dParse = ElapsedSec(tStart);
+
+			if (pProg == nullptr)
+			{
+				printf("[Arena  %-10s] parse failed\n", pName);
+				return;
+			}
+			nBytes = pProg->arena.GetBytes();
+
+			tStart = Clock::now();
+			DeletePtr<stProgram>(pProg);
+			double dFree = ElapsedSec(tStart);
+
+			if (i == 0 || dParse + dFree < dBestParse + dBestFree)
+			{
+				dBestParse = dParse;
+				dBestFree = dFree;
+			}
+		}
+
+		if (nMode == 0)
+			dBaseTotal = dBestParse + dBestFree;
+
+		printf("[Arena  %-10s] %-5s %.1f MB of nodes, best of %d: parse %.3f ms + teardown %.3f ms = %.3f ms, speedup %.2fx\n",
+			   pName, pArrModeName[nMode], nBytes / (1024.0 * 1024.0), nRepeat, dBestParse * 1000.0, dBestFree * 1000.0,
+			   (dBestParse + dBestFree) * 1000.0, dBaseTotal / (dBestParse + dBestFree));
+	}
+}
+
+/**
+@brief		Token vector vs lexer stream input of the parser (lexing included, peak RSS of each)
+@param		eShapeType	Shape
+@param		strSource	Source code
+@param		nRepeat		Repeat count (best time is printed)
+@return
+*/
+void CBenchmark::BenchStream(CCorpus::eShape eShapeType, const std::string& strSource, int nRepeat)
+{
+	const char* pName = CCorpus::GetShapeName(eShapeType).c_str();
+	const char* pArrModeName[] = { "vector", "stream" };
+	CFlatAST astArr[2];
+
+	for (int nMode = 0; nMode < 2; ++nMode)
+	{
+		double dBest = 0.0;
+
+		ResetPeakRSS();
+		for (int i = 0; i < nRepeat; ++i)
+		{
+			Clock::time_point tStart = Clock::now();
+			stProgram* pProg = nullptr;
+
+			if (nMode == 0)
+			{
+				std::vector<CLexer::stToken> vTokens = CLexer::Scan(strSource);
+				pProg = CParser::Parser(vTokens);
+			}
+			else
+			{
+				CLexerStream stream(strSource);
+				pProg = CParser::Parser(stream);
+			}
+			double dSec = ElapsedSec(tStart);
+
+			if (pProg == nullptr)
+			{
+				printf("[Stream %-10s] parse failed\n", pName);
+				return;
+			}
+
+			if (i == 0)
+				astArr[nMode].Build(*pProg);
+			DeletePtr<stProgram>(pProg);
+
+			if (i == 0 || dSec < dBest)
+				dBest = dSec;
+		}
+
+		printf("[Stream %-10s] %-6s scan + parse, best of %d: %.3f ms, peak RSS %.1f MB%s\n",
+			   pName, pArrModeName[nMode], nRepeat, dBest * 1000.0, PeakRSS() / (1024.0 * 1024.0),
+			   nMode == 0 ? "" : (IsSameAST(astArr[0], astArr[1]) ? ", identical" : ", MISMATCH"));
+	}
+}
+
+/**
+@brief		Recursive vs explicit-stack parsing of a corpus
+			(The recursive parser is skipped when the nesting could overflow the native stack)
+@param		eShapeType	Shape
+@param		buffer		Token buffer
+@param		nRepeat		Repeat count (best time is printed)
+@return
+*/
+void CBenchmark::BenchParseMode(CCorpus::eShape eShapeType, const CTokenBuffer& buffer, int nRepeat)
+{
+	const char* pName = CCorpus::GetShapeName(eShapeType).c_str();
+	const CParser::eParseMode eArrMode[] = { CParser::eParseMode::Recursive, CParser::eParseMode::Iterative };
+	double dArrBest[] = { 0.0, 0.0 };
+	size_t nNesting = CParser::MeasureNesting(buffer);
+
+	for (int nMode = 0; nMode < 2; ++nMode)
+	{
+		if (eArrMode[nMode] == CParser::eParseMode::Recursive &&
+			nNesting > CParser::RECURSION_LIMIT)
+			continue;
+
+		for (int i = 0; i < nRepeat; ++i)
+		{
+			Clock::time_point tStart = Clock::now();
+			stProgram* pProg = CParser::Parser(buffer, CArena::eMode::Block, eArrMode[nMode]);
+			double dElapsed = ElapsedSec(tStart);
+
+			if (pProg == nullptr)
+			{
+				printf("[Stack  %-10s] parse failed\n", pName);
+				return;
+			}
+			DeletePtr<stProgram>(pProg);
+
+			if (i == 0 || dElapsed < dArrBest[nMode])
+				dArrBest[nMode] = dElapsed;
+		}
+	}
+
+	if (nNesting > CParser::RECURSION_LIMIT)
+		printf("[Stack  %-10s] nesting %zu, best of %d: recursive skipped, explicit stack %.3f ms\n",
+			   pName, nNesting, nRepeat, dArrBest[1] * 1000.0);
+	else
+		printf("[Stack  %-10s] nesting %zu, best of %d: recursive %.3f ms, explicit stack %.3f ms (%.2fx)\n",
+			   pName, nNesting, nRepeat, dArrBest[0] * 1000.0, dArrBest[1] * 1000.0, dArrBest[0] / dArrBest[1]);
+}
+
+/**
+@brief		Reset the peak resident set size
+			(Only Linux can reset it; elsewhere PeakRSS() stays the peak of the process)
+@return
+*/
+void CBenchmark::ResetPeakRSS()
+{
+#ifdef __linux__
+	FILE* pFile = fopen("/proc/self/clear_refs", "w");
+	if (pFile != nullptr)
+	{
+		fputs("5", pFile);
+		fclose(pFile);
+	}
+#endif
+}
+
+/**
+@brief		Peak resident set size
+@return		Peak RSS in bytes (0 if unknown)
+*/
+size_t CBenchmark::PeakRSS()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS stCounters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &stCounters, sizeof(stCounters)))
+		return stCounters.PeakWorkingSetSize;
+	return 0;
+#else
+#ifdef __linux__
+	// VmHWM follows ResetPeakRSS(), ru_maxrss does not
+	FILE* pFile = fopen("/proc/self/status", "r");
+	if (pFile != nullptr)
+	{
+		char chLine[256];
+		size_t nKiloBytes = 0;
+		while (fgets(chLine, sizeof(chLine), pFile) != nullptr)
+		{
+			if (sscanf(chLine, "VmHWM: %zu", &nKiloBytes) == 1)
+				break;
+		}
+		fclose(pFile);
+
+		if (nKiloBytes > 0)
+			return nKiloBytes * 1024;
+	}
+#endif
+	struct rusage stUsage;
+	if (getrusage(RUSAGE_SELF, &stUsage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return (size_t)stUsage.ru_maxrss;
+#else
+	return (size_t)stUsage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+/**
+@brief		Flat AST benchmark (build time, memory and a linear scan over the nodes)
+@param		eShapeType		Corpus shape
+@param		buffer			Tokens of the corpus
+@param		nRepeat			Repeat count (the best run is reported)
+@return
+*/
+void CBenchmark::BenchFlat(CCorpus::eShape eShapeType, const CTokenBuffer& buffer, int nRepeat)
+{
+	const char* pName = CCorpus::GetShapeName(eShapeType).c_str();
+	stProgram* pProg = CParser::Parser(buffer);
+
+	if (pProg == nullptr)
+	{
+		printf("[Flat   %-10s] parse failed\n", pName);
+		return;
+	}
+
+	CFlatAST ast;
+	double dBestBuild = 0.0;
+	double dBestScan = 0.0;
+	long long nSum = 0;
+
+	for (int i = 0; i < nRepeat; ++i)
+	{
+		Clock::time_point tStart = Clock::now();
+		ast.Build(*pProg);
+		double dBuild = ElapsedSec(tStart);
+
+		// Sum of the integer literals: one pass over the kind array
+		tStart = Clock::now();
+		const unsigned char* pKind = ast.KindData();
+		size_t nSize = ast.Size();
+		nSum = 0;
+		for (size_t n = 0; n < nSize; ++n)
+		{
+			if (pKind[n] == static_cast<unsigned char>(eNodeKind::IntData))
+				nSum += ast.Int((NodeID)n);
+		}
+		double dScan = ElapsedSec(tStart);
+
+		if (i == 0 || dBuild < dBestBuild)
+			dBestBuild = dBuild;
+		if (i == 0 || dScan < dBestScan)
+			dBestScan = dScan;
+	}
+
+	printf("[Flat   %-10s] %zu nodes, %.1f bytes/node (tree %.1f), best of %d: build %.3f ms, scan %.3f ms, %.1f Mnodes/s, sum %lld\n",
+		   pName, ast.Size(), (double)ast.GetBytes() / ast.Size(), (double)pProg->arena.GetBytes() / pProg->nNodeCount,
+		   nRepeat, dBestBuild * 1000.0, dBestScan * 1000.0, ast.Size() / dBestScan / 1000000.0, nSum);
+
+	DeletePtr<stProgram>(pProg);
+}
\ No newline at end of file
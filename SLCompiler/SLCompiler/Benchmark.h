@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include "Corpus.h"
+#include "Lexer.h"
+
+class CTokenBuffer;
+class CFlatAST;
+
+static class CBenchmark
+{
+// Enums and Classes, Structures ==========================================================
+public:
+	typedef std::chrono::steady_clock Clock;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	static int Run(int argc, char* argv[]);
+	static int RunShape(int argc, char* argv[]);
+	static int RunExec(int argc, char* argv[]);
+
+private:
+	static void BenchLexer(const std::string& strSource, int nRepeat);
+	static void BenchLexerParallel(const std::string& strSource, int nRepeat, int nMaxThreads);
+	static void BenchParserParallel(const std::string& strSource, int nRepeat, int nMaxThreads);
+	static bool IsSameTokens(const std::vector<CLexer::stToken>& vA, const std::vector<CLexer::stToken>& vB);
+	static bool IsSameAST(const CFlatAST& astA, const CFlatAST& astB);
+	static void BenchRecovery(const std::string& strSource, int nRepeat);
+	static void BenchIncremental(const std::string& strSource, int nEdits);
+	static void BenchCache(const std::string& strSource, int nRepeat);
+	static void BenchDump(const std::string& strSource, int nRepeat);
+	static void BenchResolve(const std::string& strSource, int nRepeat);
+	static void BenchTypeCheck(const std::string& strSource, int nRepeat);
+	static void BenchFold(const std::string& strSource, int nRepeat);
+	static void BenchDeadCode(const std::string& strSource, int nRepeat);
+	static bool BenchExec(const char* pName, const std::string& strSource, int nExpected, int nRepeat);
+	static void BenchShape(CCorpus::eShape eShapeType, const std::string& strSource, int nRepeat);
+	static void BenchStream(CCorpus::eShape eShapeType, const std::string& strSource, int nRepeat);
+	static void BenchParseMode(CCorpus::eShape eShapeType, const CTokenBuffer& buffer, int nRepeat);
+	static void BenchArena(CCorpus::eShape eShapeType, const CTokenBuffer& buffer, int nRepeat);
+	static void BenchFlat(CCorpus::eShape eShapeType, const CTokenBuffer& buffer, int nRepeat);
+	static void ResetPeakRSS();
+	static size_t PeakRSS();
+
+	inline static double ElapsedSec(Clock::time_point tStart)
+	{
+		return std::chrono::duration<double>(Clock::now() - tStart).count();
+	}
+
+// ========================================================================================
+
+};
@@ -0,0 +1,701 @@
+#include <algorithm>
+#include <climits>
+#include "ConstantFolder.h"
+
+/**
+@brief		Result of an int operation as a 32-bit machine gives it (wraps around)
+@param		nValue		Exact result
+@return		Result
+*/
+static int WrapInt(long long nValue)
+{
+	return (int)(unsigned int)(unsigned long long)nValue;
+}
+
+/**
+@brief		Compare two constants
+@param		eOp			Relational operator
+@param		left		Left side
+@param		right		Right side
+@return		Result
+*/
+template <typename T>
+static bool Compare(CLexer::eLexEnum eOp, T left, T right)
+{
+	switch (eOp)
+	{
+		case CLexer::eLexEnum::RelOpEqual:				return left == right;
+		case CLexer::eLexEnum::RelOpNotEqual:			return left != right;
+		case CLexer::eLexEnum::RelOpLessThan:			return left < right;
+		case CLexer::eLexEnum::RelOpGreaterThan:		return left > right;
+		case CLexer::eLexEnum::RelOpLessOrEqual:		return left <= right;
+		case CLexer::eLexEnum::RelOpGreaterOrEqual:		return left >= right;
+		default:										return false;
+	}
+}
+
+CConstantFolder::CConstantFolder()
+	: m_pProg(nullptr), m_pDiag(nullptr)
+{
+}
+
+/**
+@brief		Fold the constant expressions and branches of a program
+@param		prog		Program (typed by CTypeChecker; literals are made in its arena)
+@param		pDiag		Diagnostics (nullptr: dropped)
+@return		true if anything was folded, simplified or pruned
+*/
+bool CConstantFolder::Fold(stProgram& prog, CDiagnostics* pDiag)
+{
+	CDiagnostics diagLocal;
+	m_pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+	m_pProg = &prog;
+	m_stStats = stFoldStats();
+
+	for (stFunction* pFunc : prog.vFunc)
+		FoldFunction(pFunc);
+
+	m_pDiag = nullptr;
+	m_pProg = nullptr;
+
+	return m_stStats.nFolded + m_stStats.nSimplified + m_stStats.nPrunedArms > 0;
+}
+
+/**
+@brief		Fold the statements of a function
+@param		pFunc		Function
+@return
+*/
+void CConstantFolder::FoldFunction(stFunction* pFunc)
+{
+	m_vTask.clear();
+	PushBlock(pFunc->vBlock);
+
+	while (m_vTask.empty() == false)
+	{
+		stTask stTaskData = m_vTask.back();
+		m_vTask.pop_back();
+
+		switch (stTaskData.eKind)
+		{
+			case eTaskKind::Statement:
+				BeginStatement(stTaskData.pState);
+				break;
+			case eTaskKind::StatementEnd:
+				PruneIf(static_cast<stIf*>(stTaskData.pState));
+				break;
+			case eTaskKind::BlockEnd:
+				CompactBlock(*stTaskData.pBlock);
+				break;
+			case eTaskKind::Expression:
+				BeginExpression(stTaskData.ppExp);
+				break;
+			case eTaskKind::ExpressionEnd:
+				EndExpression(stTaskData.ppExp);
+				break;
+		}
+	}
+}
+
+/**
+@brief		Push the tasks of a statement (its children in source order)
+@param		pState		Statement
+@return
+*/
+void CConstantFolder::BeginStatement(stStatement* pState)
+{
+	switch (pState->eKind)
+	{
+		case eNodeKind::Variable:
+			PushExpression(&static_cast<stVariable*>(pState)->stExp);
+			break;
+		case eNodeKind::ExpStatement:
+			PushExpression(&static_cast<stExpStatement*>(pState)->stExp);
+			break;
+		case eNodeKind::Return:
+			PushExpression(&static_cast<stReturn*>(pState)->stExp);
+			break;
+		case eNodeKind::For:
+		{
+			stFor* pFor = static_cast<stFor*>(pState);
+			PushBlock(pFor->stBlock);
+			PushExpression(&pFor->stLoopExp);
+			PushExpression(&pFor->stCondExp);
+			PushStatement(pFor->stVar);
+			break;
+		}
+		case eNodeKind::While:
+		{
+			stWhile* pWhile = static_cast<stWhile*>(pState);
+			PushBlock(pWhile->stBlock);
+			PushExpression(&pWhile->stCondExp);
+			break;
+		}
+		case eNodeKind::If:
+		{
+			stIf* pIf = static_cast<stIf*>(pState);
+			m_vTask.push_back(stTask{ eTaskKind::StatementEnd, pIf, nullptr, nullptr });
+			PushBlock(pIf->vElseBlock);
+			for (size_t i = pIf->vIfBlock.size(); i-- > 0;)
+				PushBlock(pIf->vIfBlock[i]);
+			for (size_t i = pIf->stCondStm.size(); i-- > 0;)
+				PushExpression(&pIf->stCondStm[i]);
+			break;
+		}
+		case eNodeKind::Switch:
+		{
+			stSwitch* pSwitch = static_cast<stSwitch*>(pState);
+			PushBlock(pSwitch->vDefaultBlock);
+			for (size_t i = pSwitch->vCaseBlock.size(); i-- > 0;)
+				PushBlock(pSwitch->vCaseBlock[i]);
+			for (size_t i = pSwitch->stCondStm.size(); i-- > 0;)
+				PushExpression(&pSwitch->stCondStm[i]);
+			PushExpression(&pSwitch->stExp);
+			break;
+		}
+		case eNodeKind::Print:
+		{
+			stPrint* pPrint = static_cast<stPrint*>(pState);
+			for (size_t i = pPrint->stArgs.size(); i-- > 0;)
+				PushExpression(&pPrint->stArgs[i]);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Remove the arms of an if whose conditions are constant
+@param		pIf			If statement (its conditions are folded)
+@return
+*/
+void CConstantFolder::PruneIf(stIf* pIf)
+{
+	size_t nArms = pIf->stCondStm.size();
+	size_t nKeep = 0;
+
+	for (size_t i = 0; i < nArms; ++i)
+	{
+		int nTruth = Truth(pIf->stCondStm[i]);
+
+		// Never taken
+		if (nTruth == 0)
+			continue;
+
+		// Always taken once it is reached: the arms after it and the else are never reached
+		if (nTruth == 1)
+		{
+			pIf->vElseBlock.swap(pIf->vIfBlock[i]);
+			break;
+		}
+
+		if (nKeep != i)
+		{
+			pIf->stCondStm[nKeep] = pIf->stCondStm[i];
+			pIf->vIfBlock[nKeep].swap(pIf->vIfBlock[i]);
+		}
+		++nKeep;
+	}
+
+	if (nKeep == nArms)
+		return;
+
+	pIf->stCondStm.resize(nKeep);
+	pIf->vIfBlock.resize(nKeep);
+	m_stStats.nPrunedArms += nArms - nKeep;
+}
+
+/**
+@brief		Remove the if statements of a block that have nothing left to run
+@param		vBlock		Block (its statements are folded)
+@return
+*/
+void CConstantFolder::CompactBlock(vstStatement& vBlock)
+{
+	vBlock.erase(std::remove_if(vBlock.begin(), vBlock.end(), [](const stStatement* pState) {
+		if (pState->eKind != eNodeKind::If)
+			return false;
+
+		const stIf* pIf = static_cast<const stIf*>(pState);
+		return pIf->stCondStm.empty() && pIf->vElseBlock.empty();
+	}), vBlock.end());
+}
+
+/**
+@brief		Push the tasks of the children of an expression and its own fold
+@param		ppExp		Expression slot
+@return
+*/
+void CConstantFolder::BeginExpression(stExpression** ppExp)
+{
+	stExpression* pExp = *ppExp;
+
+	switch (pExp->eKind)
+	{
+		case eNodeKind::And:
+		{
+			stAnd* pAnd = static_cast<stAnd*>(pExp);
+			m_vTask.push_back(stTask{ eTaskKind::ExpressionEnd, nullptr, ppExp, nullptr });
+			PushExpression(&pAnd->stRight);
+			PushExpression(&pAnd->stLeft);
+			break;
+		}
+		case eNodeKind::Or:
+		{
+			stOr* pOr = static_cast<stOr*>(pExp);
+			m_vTask.push_back(stTask{ eTaskKind::ExpressionEnd, nullptr, ppExp, nullptr });
+			PushExpression(&pOr->stRight);
+			PushExpression(&pOr->stLeft);
+			break;
+		}
+		case eNodeKind::Relational:
+		{
+			stRelational* pRel = static_cast<stRelational*>(pExp);
+			m_vTask.push_back(stTask{ eTaskKind::ExpressionEnd, nullptr, ppExp, nullptr });
+			PushExpression(&pRel->stRight);
+			PushExpression(&pRel->stLeft);
+			break;
+		}
+		case eNodeKind::Arithmetic:
+		{
+			stArithmetic* pArith = static_cast<stArithmetic*>(pExp);
+			m_vTask.push_back(stTask{ eTaskKind::ExpressionEnd, nullptr, ppExp, nullptr });
+			PushExpression(&pArith->stRight);
+			PushExpression(&pArith->stLeft);
+			break;
+		}
+		case eNodeKind::Unary:
+			m_vTask.push_back(stTask{ eTaskKind::ExpressionEnd, nullptr, ppExp, nullptr });
+			PushExpression(&static_cast<stUnary*>(pExp)->stSubExp);
+			break;
+		case eNodeKind::Convert:
+			m_vTask.push_back(stTask{ eTaskKind::ExpressionEnd, nullptr, ppExp, nullptr });
+			PushExpression(&static_cast<stConvert*>(pExp)->stSubExp);
+			break;
+		// Not folded themselves, but their operands can be
+		case eNodeKind::SetVariable:
+			PushExpression(&static_cast<stSetVariable*>(pExp)->stInitExp);
+			break;
+		case eNodeKind::GetElement:
+		{
+			stGetElement* pGetElem = static_cast<stGetElement*>(pExp);
+			PushExpression(&pGetElem->stIndexExp);
+			PushExpression(&pGetElem->stMemsExp);
+			break;
+		}
+		case eNodeKind::SetElement:
+		{
+			stSetElement* pSetElem = static_cast<stSetElement*>(pExp);
+			PushExpression(&pSetElem->stInitExp);
+			PushExpression(&pSetElem->stIndexExp);
+			PushExpression(&pSetElem->stMemsExp);
+			break;
+		}
+		case eNodeKind::CallFunc:
+		{
+			stCallFunc* pCall = static_cast<stCallFunc*>(pExp);
+			for (size_t i = pCall->vArgsExp.size(); i-- > 0;)
+				PushExpression(&pCall->vArgsExp[i]);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Fold an expression whose children are folded
+@param		ppExp		Expression slot (the result is put in its place)
+@return
+*/
+void CConstantFolder::EndExpression(stExpression** ppExp)
+{
+	stExpression* pExp = *ppExp;
+
+	switch (pExp->eKind)
+	{
+		case eNodeKind::And:
+		{
+			stAnd* pAnd = static_cast<stAnd*>(pExp);
+			*ppExp = FoldLogical(pAnd, pAnd->stLeft, pAnd->stRight, true);
+			break;
+		}
+		case eNodeKind::Or:
+		{
+			stOr* pOr = static_cast<stOr*>(pExp);
+			*ppExp = FoldLogical(pOr, pOr->stLeft, pOr->stRight, false);
+			break;
+		}
+		case eNodeKind::Relational:
+			*ppExp = FoldRelational(static_cast<stRelational*>(pExp));
+			break;
+		case eNodeKind::Arithmetic:
+			*ppExp = FoldArithmetic(static_cast<stArithmetic*>(pExp));
+			break;
+		case eNodeKind::Unary:
+			*ppExp = FoldUnary(static_cast<stUnary*>(pExp));
+			break;
+		case eNodeKind::Convert:
+			*ppExp = FoldConvert(static_cast<stConvert*>(pExp));
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Fold an arithmetic expression, or apply an identity of an int one
+@param		pArith		Arithmetic expression
+@return		Expression to put in its place (pArith if it is kept)
+*/
+stExpression* CConstantFolder::FoldArithmetic(stArithmetic* pArith)
+{
+	stExpression* pLeft = pArith->stLeft;
+	stExpression* pRight = pArith->stRight;
+	CLexer::eLexEnum eOp = pArith->eType;
+
+	if (pLeft == nullptr ||
+		pRight == nullptr)
+		return pArith;
+
+	bool bDivide = eOp == CLexer::eLexEnum::OpDivide || eOp == CLexer::eLexEnum::OpModulo;
+
+	// Kept as it is, so the fault happens where the program runs it
+	if (bDivide &&
+		IsInt(pRight, 0) &&
+		pLeft->eKind != eNodeKind::DoubleData &&
+		pLeft->eValType != eValueType::Double)
+	{
+		m_pDiag->Warning(pArith->nOffset, eOp == CLexer::eLexEnum::OpDivide ? "Integer division by zero." : "Integer modulo by zero.");
+		++m_stStats.nDivByZero;
+		return pArith;
+	}
+
+	if (IsNumber(pLeft) &&
+		IsNumber(pRight))
+	{
+		if (pLeft->eKind == eNodeKind::IntData &&
+			pRight->eKind == eNodeKind::IntData)
+		{
+			long long nLeft = static_cast<stIntData*>(pLeft)->nData;
+			long long nRight = static_cast<stIntData*>(pRight)->nData;
+
+			switch (eOp)
+			{
+				case CLexer::eLexEnum::OpAdd:		return NewInt(pArith, WrapInt(nLeft + nRight));
+				case CLexer::eLexEnum::OpSubtract:	return NewInt(pArith, WrapInt(nLeft - nRight));
+				case CLexer::eLexEnum::OpMultiply:	return NewInt(pArith, WrapInt(nLeft * nRight));
+				default:							break;
+			}
+
+			// INT_MIN / -1 overflows (the machine faults), so it is left to run
+			if (bDivide &&
+				(nLeft != INT_MIN || nRight != -1))
+				return NewInt(pArith, (int)(eOp == CLexer::eLexEnum::OpDivide ? nLeft / nRight : nLeft % nRight));
+			return pArith;
+		}
+
+		double dLeft = ToDouble(pLeft);
+		double dRight = ToDouble(pRight);
+
+		switch (eOp)
+		{
+			case CLexer::eLexEnum::OpAdd:		return NewDouble(pArith, dLeft + dRight);
+			case CLexer::eLexEnum::OpSubtract:	return NewDouble(pArith, dLeft - dRight);
+			case CLexer::eLexEnum::OpMultiply:	return NewDouble(pArith, dLeft * dRight);
+			case CLexer::eLexEnum::OpDivide:	return NewDouble(pArith, dLeft / dRight);
+			default:							return pArith;
+		}
+	}
+
+	// Identities are only safe for ints (x + 0 is not x for a double -0.0, x * 0 is not 0 for NaN)
+	if (pArith->eValType != eValueType::Int)
+		return pArith;
+
+	switch (eOp)
+	{
+		case CLexer::eLexEnum::OpAdd:
+			if (IsInt(pRight, 0))
+				return Simplified(pLeft);
+			if (IsInt(pLeft, 0))
+				return Simplified(pRight);
+			break;
+		case CLexer::eLexEnum::OpSubtract:
+			if (IsInt(pRight, 0))
+				return Simplified(pLeft);
+			break;
+		case CLexer::eLexEnum::OpMultiply:
+			if (IsInt(pRight, 1))
+				return Simplified(pLeft);
+			if (IsInt(pLeft, 1))
+				return Simplified(pRight);
+			if ((IsInt(pRight, 0) && IsDroppable(pLeft)) ||
+				(IsInt(pLeft, 0) && IsDroppable(pRight)))
+				return NewInt(pArith, 0);
+			break;
+		case CLexer::eLexEnum::OpDivide:
+			if (IsInt(pRight, 1))
+				return Simplified(pLeft);
+			break;
+		case CLexer::eLexEnum::OpModulo:
+			if ((IsInt(pRight, 1) || IsInt(pRight, -1)) &&
+				IsDroppable(pLeft))
+				return NewInt(pArith, 0);
+			break;
+		default:
+			break;
+	}
+
+	return pArith;
+}
+
+/**
+@brief		Fold a relational expression of two numbers or two bools
+@param		pRel		Relational expression
+@return		Expression to put in its place (pRel if it is kept)
+*/
+stExpression* CConstantFolder::FoldRelational(stRelational* pRel)
+{
+	stExpression* pLeft = pRel->stLeft;
+	stExpression* pRight = pRel->stRight;
+
+	if (pLeft == nullptr ||
+		pRight == nullptr)
+		return pRel;
+
+	if (IsNumber(pLeft) &&
+		IsNumber(pRight))
+	{
+		if (pLeft->eKind == eNodeKind::IntData &&
+			pRight->eKind == eNodeKind::IntData)
+			return NewBool(pRel, Compare(pRel->eType, static_cast<stIntData*>(pLeft)->nData, static_cast<stIntData*>(pRight)->nData));
+
+		return NewBool(pRel, Compare(pRel->eType, ToDouble(pLeft), ToDouble(pRight)));
+	}
+
+	// Bools are only compared for equality
+	if (pLeft->eKind == eNodeKind::BoolData &&
+		pRight->eKind == eNodeKind::BoolData &&
+		(pRel->eType == CLexer::eLexEnum::RelOpEqual || pRel->eType == CLexer::eLexEnum::RelOpNotEqual))
+		return NewBool(pRel, Compare(pRel->eType, static_cast<stBoolData*>(pLeft)->bData, static_cast<stBoolData*>(pRight)->bData));
+
+	return pRel;
+}
+
+/**
+@brief		Fold a unary expression of a number
+@param		pUn			Unary expression
+@return		Expression to put in its place (pUn if it is kept)
+*/
+stExpression* CConstantFolder::FoldUnary(stUnary* pUn)
+{
+	stExpression* pSub = pUn->stSubExp;
+
+	if (pSub == nullptr ||
+		IsNumber(pSub) == false)
+		return pUn;
+
+	if (pUn->eType == CLexer::eLexEnum::OpAdd)
+		return Simplified(pSub);
+	if (pUn->eType != CLexer::eLexEnum::OpSubtract)
+		return pUn;
+
+	if (pSub->eKind == eNodeKind::IntData)
+		return NewInt(pUn, WrapInt(-(long long)static_cast<stIntData*>(pSub)->nData));
+	return NewDouble(pUn, -static_cast<stDoubleData*>(pSub)->dData);
+}
+
+/**
+@brief		Fold a conversion of a literal
+@param		pConv		Conversion (eValType is the target type)
+@return		Expression to put in its place (pConv if it is kept)
+*/
+stExpression* CConstantFolder::FoldConvert(stConvert* pConv)
+{
+	stExpression* pSub = pConv->stSubExp;
+
+	if (pSub == nullptr)
+		return pConv;
+
+	switch (pConv->eValType)
+	{
+		case eValueType::Double:
+			if (pSub->eKind == eNodeKind::IntData)
+				return NewDouble(pConv, static_cast<stIntData*>(pSub)->nData);
+			break;
+		case eValueType::Int:
+			if (pSub->eKind == eNodeKind::BoolData)
+				return NewInt(pConv, static_cast<stBoolData*>(pSub)->bData ? 1 : 0);
+			if (pSub->eKind == eNodeKind::DoubleData)
+			{
+				// Truncated as C does; a double out of the int range (or NaN) is left to run
+				double dData = static_cast<stDoubleData*>(pSub)->dData;
+				if (dData > -2147483649.0 &&
+					dData < 2147483648.0)
+					return NewInt(pConv, (int)dData);
+			}
+			break;
+		case eValueType::Bool:
+			if (pSub->eKind == eNodeKind::IntData)
+				return NewBool(pConv, static_cast<stIntData*>(pSub)->nData != 0);
+			break;
+		default:
+			break;
+	}
+
+	return pConv;
+}
+
+/**
+@brief		Fold an And or Or expression with a constant side
+@param		pExp		And or Or expression
+@param		pLeft		Left side
+@param		pRight		Right side
+@param		bAnd		And (false: Or)
+@return		Expression to put in its place (pExp if it is kept)
+*/
+stExpression* CConstantFolder::FoldLogical(stExpression* pExp, stExpression* pLeft, stExpression* pRight, bool bAnd)
+{
+	if (pLeft == nullptr ||
+		pRight == nullptr)
+		return pExp;
+
+	int nLeft = Truth(pLeft);
+	int nRight = Truth(pRight);
+	// Side value that decides the result on its own (false for And, true for Or)
+	int nDecide = bAnd ? 0 : 1;
+
+	// The right side is never run
+	if (nLeft == nDecide)
+		return NewBool(pExp, !bAnd);
+
+	if (nLeft != -1)
+	{
+		if (nRight != -1)
+			return NewBool(pExp, nRight == 1);
+		return IsBool(pRight) ? Simplified(pRight) : pExp;
+	}
+
+	// The left side still has to run unless it can be dropped
+	if (nRight == nDecide)
+		return IsDroppable(pLeft) ? NewBool(pExp, !bAnd) : pExp;
+	if (nRight != -1)
+		return IsBool(pLeft) ? Simplified(pLeft) : pExp;
+
+	return pExp;
+}
+
+/**
+@brief		Whether an expression can be removed without changing what the program does
+@param		pExp		Expression
+@return		false if it calls, assigns, indexes or divides (a division can fault)
+*/
+bool CConstantFolder::IsDroppable(const stExpression* pExp)
+{
+	m_vDrop.clear();
+	m_vDrop.push_back(pExp);
+
+	while (m_vDrop.empty() == false)
+	{
+		const stExpression* pCur = m_vDrop.back();
+		m_vDrop.pop_back();
+
+		if (pCur == nullptr)
+			continue;
+
+		switch (pCur->eKind)
+		{
+			case eNodeKind::NullData:
+			case eNodeKind::BoolData:
+			case eNodeKind::IntData:
+			case eNodeKind::DoubleData:
+			case eNodeKind::StringData:
+			case eNodeKind::GetVariable:
+				break;
+			case eNodeKind::Unary:
+				m_vDrop.push_back(static_cast<const stUnary*>(pCur)->stSubExp);
+				break;
+			case eNodeKind::Convert:
+				m_vDrop.push_back(static_cast<const stConvert*>(pCur)->stSubExp);
+				break;
+			case eNodeKind::And:
+				m_vDrop.push_back(static_cast<const stAnd*>(pCur)->stLeft);
+				m_vDrop.push_back(static_cast<const stAnd*>(pCur)->stRight);
+				break;
+			case eNodeKind::Or:
+				m_vDrop.push_back(static_cast<const stOr*>(pCur)->stLeft);
+				m_vDrop.push_back(static_cast<const stOr*>(pCur)->stRight);
+				break;
+			case eNodeKind::Relational:
+				m_vDrop.push_back(static_cast<const stRelational*>(pCur)->stLeft);
+				m_vDrop.push_back(static_cast<const stRelational*>(pCur)->stRight);
+				break;
+			case eNodeKind::Arithmetic:
+			{
+				const stArithmetic* pArith = static_cast<const stArithmetic*>(pCur);
+				if (pArith->eType == CLexer::eLexEnum::OpDivide ||
+					pArith->eType == CLexer::eLexEnum::OpModulo)
+					return false;
+				m_vDrop.push_back(pArith->stLeft);
+				m_vDrop.push_back(pArith->stRight);
+				break;
+			}
+			default:
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+@brief		Make an int literal in place of an expression
+@param		pExp		Folded expression (gives the source offset)
+@param		nData		Value
+@return		Literal
+*/
+stExpression* CConstantFolder::NewInt(const stExpression* pExp, int nData)
+{
+	stIntData* pData = m_pProg->arena.New<stIntData>();
+	pData->nData = nData;
+	pData->eValType = eValueType::Int;
+	pData->nOffset = pExp->nOffset;
+
+	++m_stStats.nFolded;
+	return pData;
+}
+
+/**
+@brief		Make a double literal in place of an expression
+@param		pExp		Folded expression (gives the source offset)
+@param		dData		Value
+@return		Literal
+*/
+stExpression* CConstantFolder::NewDouble(const stExpression* pExp, double dData)
+{
+	stDoubleData* pData = m_pProg->arena.New<stDoubleData>();
+	pData->dData = dData;
+	pData->eValType = eValueType::Double;
+	pData->nOffset = pExp->nOffset;
+
+	++m_stStats.nFolded;
+	return pData;
+}
+
+/**
+@brief		Make a bool literal in place of an expression
+@param		pExp		Folded expression (gives the source offset)
+@param		bData		Value
+@return		Literal
+*/
+stExpression* CConstantFolder::NewBool(const stExpression* pExp, bool bData)
+{
+	stBoolData* pData = m_pProg->arena.New<stBoolData>();
+	pData->bData = bData;
+	pData->eValType = eValueType::Bool;
+	pData->nOffset = pExp->nOffset;
+
+	++m_stStats.nFolded;
+	return pData;
+}
\ No newline at end of file
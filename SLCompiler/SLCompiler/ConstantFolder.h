@@ -0,0 +1,168 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Diagnostics.h"
+#include "Structures.h"
+
+// Constant folder (optimization pass, runs after CTypeChecker)
+// Replaces every Arithmetic, Relational, Unary, And, Or and Convert expression whose operands
+// are int, double or bool literals by the literal of its value, so "1 + 2 * 3" is computed
+// once here and not every time it runs.
+// - int arithmetic wraps around as the machine does; a division or modulo by a constant 0 is
+//   reported (warning) and kept, and INT_MIN / -1 is kept.
+// - Identities of int expressions (typed by CTypeChecker): x + 0, 0 + x, x - 0, x * 1, 1 * x
+//   and x / 1 are x; x * 0, 0 * x and x % 1 are 0 if x can be dropped (it has no call,
+//   assignment, index or division).
+// - And/Or with a constant side is short-circuited (false && x is false, true && x is x).
+// - If/elif arms with a constant false condition are removed; an arm with a constant true
+//   condition becomes the else block and the arms after it are removed. An if without arms
+//   keeps its else block as a scope (so the slots and bindings stay valid), and an if
+//   without arms and else is removed from its block.
+// Literals are made in the arena of the program; stProgram::nNodeCount is not lowered (a fold
+// never adds nodes, so it stays an upper bound).
+// Nodes are visited with an explicit stack of tasks (children before their parent), so any
+// nesting depth the parser accepts can be folded.
+class CConstantFolder
+{
+// Enums and Classes, Structures ==========================================================
+public:
+	// Work of the last Fold()
+	struct stFoldStats
+	{
+	public:
+		// Expressions replaced by a literal
+		size_t nFolded = 0;
+		// Expressions replaced by one of their operands
+		size_t nSimplified = 0;
+		// If/elif arms removed
+		size_t nPrunedArms = 0;
+		// Divisions and modulos by a constant 0
+		size_t nDivByZero = 0;
+	};
+
+private:
+	enum class eTaskKind : unsigned char
+	{
+		Statement,
+		// Prune the arms of an if once its conditions are folded
+		StatementEnd,
+		// Remove the statements of a block that were emptied
+		BlockEnd,
+		Expression,
+		// Fold an expression once its children are folded
+		ExpressionEnd,
+	};
+
+	struct stTask
+	{
+	public:
+		eTaskKind eKind;
+		stStatement* pState;
+		// Expression slot (the folded expression is put in its place)
+		stExpression** ppExp;
+		vstStatement* pBlock;
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	stProgram* m_pProg;
+	CDiagnostics* m_pDiag;
+	// Tasks that are waiting to be folded (last in, first out)
+	std::vector<stTask> m_vTask;
+	// Nodes that are waiting to be checked by IsDroppable()
+	std::vector<const stExpression*> m_vDrop;
+	stFoldStats m_stStats;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CConstantFolder();
+
+	bool Fold(stProgram& prog, CDiagnostics* pDiag = nullptr);
+
+	inline const stFoldStats& GetStats() const
+	{
+		return m_stStats;
+	}
+
+	// Value of a constant condition (-1: not a constant)
+	inline static int Truth(const stExpression* pExp)
+	{
+		if (pExp == nullptr)
+			return -1;
+		if (pExp->eKind == eNodeKind::BoolData)
+			return static_cast<const stBoolData*>(pExp)->bData ? 1 : 0;
+		if (pExp->eKind == eNodeKind::IntData)
+			return static_cast<const stIntData*>(pExp)->nData != 0 ? 1 : 0;
+		return -1;
+	}
+
+private:
+	void FoldFunction(stFunction* pFunc);
+	void BeginStatement(stStatement* pState);
+	void PruneIf(stIf* pIf);
+	void CompactBlock(vstStatement& vBlock);
+	void BeginExpression(stExpression** ppExp);
+	void EndExpression(stExpression** ppExp);
+	stExpression* FoldArithmetic(stArithmetic* pArith);
+	stExpression* FoldRelational(stRelational* pRel);
+	stExpression* FoldUnary(stUnary* pUn);
+	stExpression* FoldConvert(stConvert* pConv);
+	stExpression* FoldLogical(stExpression* pExp, stExpression* pLeft, stExpression* pRight, bool bAnd);
+	bool IsDroppable(const stExpression* pExp);
+	stExpression* NewInt(const stExpression* pExp, int nData);
+	stExpression* NewDouble(const stExpression* pExp, double dData);
+	stExpression* NewBool(const stExpression* pExp, bool bData);
+
+	inline void PushStatement(stStatement* pState)
+	{
+		if (pState != nullptr)
+			m_vTask.push_back(stTask{ eTaskKind::Statement, pState, nullptr, nullptr });
+	}
+
+	inline void PushExpression(stExpression** ppExp)
+	{
+		if (*ppExp != nullptr)
+			m_vTask.push_back(stTask{ eTaskKind::Expression, nullptr, ppExp, nullptr });
+	}
+
+	inline void PushBlock(vstStatement& vBlock)
+	{
+		m_vTask.push_back(stTask{ eTaskKind::BlockEnd, nullptr, nullptr, &vBlock });
+		for (size_t i = vBlock.size(); i-- > 0;)
+			PushStatement(vBlock[i]);
+	}
+
+	// Expression is replaced by one of its operands
+	inline stExpression* Simplified(stExpression* pExp)
+	{
+		++m_stStats.nSimplified;
+		return pExp;
+	}
+
+	inline static bool IsNumber(const stExpression* pExp)
+	{
+		return pExp->eKind == eNodeKind::IntData || pExp->eKind == eNodeKind::DoubleData;
+	}
+
+	inline static bool IsBool(const stExpression* pExp)
+	{
+		return pExp->eKind == eNodeKind::BoolData || pExp->eValType == eValueType::Bool;
+	}
+
+	inline static bool IsInt(const stExpression* pExp, int nData)
+	{
+		return pExp->eKind == eNodeKind::IntData && static_cast<const stIntData*>(pExp)->nData == nData;
+	}
+
+	inline static double ToDouble(const stExpression* pExp)
+	{
+		return pExp->eKind == eNodeKind::IntData ? static_cast<const stIntData*>(pExp)->nData : static_cast<const stDoubleData*>(pExp)->dData;
+	}
+
+// ========================================================================================
+
+};
\ No newline at end of file
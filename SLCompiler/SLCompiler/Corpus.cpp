@@ -0,0 +1,259 @@
+#include <cstdio>
+#include "Corpus.h"
+
+// Shape name
+const std::string CCorpus::SHAPE_NAME[static_cast<int>(eShape::ShapeMax)] =
+{
+	"mixed",
+	"nesting",
+	"elif",
+	"switch",
+	"expression",
+	"functions",
+	"constant",
+	"deadcode",
+};
+
+/**
+@brief		Make a synthetic program
+@param		eShapeType		Shape of the function bodies
+@param		nBytes			Approximate program size
+@param		nDepth			Nesting depth, elif/case count or operand count (by shape)
+@return		Source code
+*/
+std::string CCorpus::Make(eShape eShapeType, size_t nBytes, int nDepth)
+{
+	std::string strSource;
+
+	if (nDepth < 1)
+		nDepth = 1;
+
+	strSource.reserve(nBytes + 4096);
+
+	int nFunc = 0;
+	for (; strSource.size() < nBytes; ++nFunc)
+		AppendFunction(eShapeType, nFunc, nDepth, strSource);
+
+	// Function n calls function n - 2, so main reaches the functions of one parity
+	if (eShapeType == eShape::DeadCode)
+	{
+		strSource += "int main()\n{\n\treturn fn";
+		AppendName(nFunc - 1, strSource);
+		strSource += "(1, 2);\n}\n";
+	}
+
+	return strSource;
+}
+
+/**
+@brief		Find a shape by name
+@param		strName		Shape name
+@return		Shape (ShapeMax if the name is unknown)
+*/
+CCorpus::eShape CCorpus::FindShape(std::string_view strName)
+{
+	for (int i = 0; i < static_cast<int>(eShape::ShapeMax); ++i)
+	{
+		if (strName == SHAPE_NAME[i])
+			return static_cast<eShape>(i);
+	}
+
+	return eShape::ShapeMax;
+}
+
+/**
+@brief		Append one generated function
+@param		eShapeType		Shape of the function body
+@param		nFunc			Function index (names the function)
+@param		nDepth			Nesting depth, elif/case count or operand count
+@param		strSource		Source code
+@return
+*/
+void CCorpus::AppendFunction(eShape eShapeType, int nFunc, int nDepth, std::string& strSource)
+{
+	char chBuf[512];
+
+	strSource += "int fn";
+	AppendName(nFunc, strSource);
+	strSource += "(nLeft, nRight)\n{\n";
+
+	switch (eShapeType)
+	{
+		case eShape::Mixed:
+			strSource +=
+				"\tint nSum = nLeft * (nRight + 42) - 7;\n"
+				"\tstring strText = \"Hello World %d\";\n"
+				"\tif (nSum >= 100 && nRight != 0)\n"
+				"\t{\n"
+				"\t\tnSum = nSum / nRight % 13;\n"
+				"\t}\n"
+				"\telif (nSum <= 10 || nLeft == 1)\n"
+				"\t{\n"
+				"\t\tprintf(\"%d\", nSum);\n"
+				"\t}\n"
+				"\treturn nSum;\n";
+			break;
+		case eShape::Nesting:
+			strSource += "\tint nSum = 0;\n";
+			for (int i = 0; i < nDepth; ++i)
+			{
+				AppendIndent(i + 1, strSource);
+				snprintf(chBuf, sizeof(chBuf), i % 2 == 0 ? "if (nLeft > %d)\n" : "while (nSum < %d)\n", i);
+				strSource += chBuf;
+				AppendIndent(i + 1, strSource);
+				strSource += "{\n";
+			}
+			AppendIndent(nDepth + 1, strSource);
+			strSource += "nSum = nSum + nRight;\n";
+			for (int i = nDepth - 1; i >= 0; --i)
+			{
+				AppendIndent(i + 1, strSource);
+				strSource += "}\n";
+			}
+			strSource += "\treturn nSum;\n";
+			break;
+		case eShape::ElifChain:
+			strSource += "\tint nSum = 0;\n";
+			for (int i = 0; i < nDepth; ++i)
+			{
+				snprintf(chBuf, sizeof(chBuf), "\t%s (nLeft == %d)\n\t{\n\t\tnSum = nRight + %d;\n\t}\n", i == 0 ? "if" : "elif", i, i);
+				strSource += chBuf;
+			}
+			strSource +=
+				"\telse\n"
+				"\t{\n"
+				"\t\tnSum = nRight;\n"
+				"\t}\n"
+				"\treturn nSum;\n";
+			break;
+		case eShape::Switch:
+			strSource +=
+				"\tint nSum = 0;\n"
+				"\tswitch (nLeft)\n"
+				"\t{\n";
+			for (int i = 0; i < nDepth; ++i)
+			{
+				snprintf(chBuf, sizeof(chBuf), "\t\tcase %d:\n\t\t\tnSum = nRight * %d;\n\t\t\tbreak;\n", i, i);
+				strSource += chBuf;
+			}
+			strSource +=
+				"\t\tdefault:\n"
+				"\t\t\tnSum = nRight;\n"
+				"\t}\n"
+				"\treturn nSum;\n";
+			break;
+		case eShape::Expression:
+		{
+			// Operators cycle through every precedence level
+			const char* pOper[] = { " + ", " * ", " - ", " / ", " % ", " < ", " && ", " == ", " || " };
+			const int nOperSize = sizeof(pOper) / sizeof(const char*);
+
+			strSource += "\tint nSum = ";
+			for (int i = 0; i < nDepth; ++i)
+			{
+				if (i > 0)
+					strSource += pOper[i % nOperSize];
+				if (i % 7 == 3)
+				{
+					snprintf(chBuf, sizeof(chBuf), "(nLeft - %d)", i);
+					strSource += chBuf;
+				}
+				else
+					strSource += i % 2 == 0 ? "nLeft" : "nRight";
+			}
+			strSource +=
+				";\n"
+				"\treturn nSum;\n";
+			break;
+		}
+		case eShape::Functions:
+			strSource += "\treturn nLeft + nRight;\n";
+			break;
+		case eShape::Constant:
+			strSource +=
+				"\tint nSum = nLeft * 1 + (2 * 3 - 6) + nRight * (4 - 4);\n"
+				"\tdouble dRate = 1.5 * 2 + 0.25;\n"
+				"\tif (1 > 2 && nLeft != 0)\n"
+				"\t{\n"
+				"\t\tnSum = nSum + 1;\n"
+				"\t}\n"
+				"\telif (nRight - 0 > 10 * 10 || 3 == 3)\n"
+				"\t{\n"
+				"\t\tnSum = nSum * (8 / 4 - 1) + -(-7);\n"
+				"\t}\n"
+				"\telse\n"
+				"\t{\n"
+				"\t\tprintf(\"%d\", 1 + 2 * 3);\n"
+				"\t}\n"
+				"\tprintf(\"%f\", dRate + 1);\n"
+				"\treturn nSum / (10 - 9) + 0;\n";
+			break;
+		case eShape::DeadCode:
+			strSource += "\tint nSum = nLeft;\n";
+			if (nFunc >= 2)
+			{
+				strSource += "\tnSum = nSum + fn";
+				AppendName(nFunc - 2, strSource);
+				strSource += "(nLeft, nRight - 1);\n";
+			}
+			strSource +=
+				"\twhile (false)\n"
+				"\t{\n"
+				"\t\tnSum = nSum + 1;\n"
+				"\t}\n"
+				"\tfor (int i = 0; i < nRight; i = i + 1)\n"
+				"\t{\n"
+				"\t\tif (i > 10)\n"
+				"\t\t{\n"
+				"\t\t\tbreak;\n"
+				"\t\t\tnSum = 0;\n"
+				"\t\t}\n"
+				"\t\tnSum = nSum + i;\n"
+				"\t\tcontinue;\n"
+				"\t\tprintf(\"%d\", i);\n"
+				"\t}\n"
+				"\tif (nLeft > 0)\n"
+				"\t{\n"
+				"\t\treturn nSum;\n"
+				"\t}\n"
+				"\telse\n"
+				"\t{\n"
+				"\t\treturn 0;\n"
+				"\t}\n"
+				"\tnSum = nSum * 2;\n"
+				"\tprintf(\"%d\", nSum);\n"
+				"\treturn nSum;\n";
+			break;
+		default:
+			break;
+	}
+
+	strSource += "}\n\n";
+}
+
+/**
+@brief		Append a generated name
+			(Identifiers are letters only, so names are a base-26 counter)
+@param		nIdx			Name index
+@param		strSource		Source code
+@return
+*/
+void CCorpus::AppendName(int nIdx, std::string& strSource)
+{
+	do
+	{
+		strSource += (char)('A' + nIdx % 26);
+		nIdx /= 26;
+	} while (nIdx > 0);
+}
+
+/**
+@brief		Append indentation
+@param		nDepth			Tab count
+@param		strSource		Source code
+@return
+*/
+void CCorpus::AppendIndent(int nDepth, std::string& strSource)
+{
+	strSource.append((size_t)nDepth, '\t');
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Synthetic source generator (benchmark corpus)
+// A program is made of generated functions until it reaches the requested size.
+// The shape decides what the function bodies look like; the depth is the nesting
+// depth, the elif/case count or the operand count of the shape.
+static class CCorpus
+{
+// Enums and Classes, Structures ==========================================================
+public:
+	enum class eShape
+	{
+		Mixed,					// Variables, if/elif, printf and return
+		Nesting,				// Deeply nested if/while blocks
+		ElifChain,				// Long if/elif/else chains
+		Switch,					// Huge switch blocks
+		Expression,				// Long expressions
+		Functions,				// Many small functions
+		Constant,				// Constant sub-expressions and branches (generated code)
+		DeadCode,				// Unreachable statements, and a main that calls half of the functions
+		ShapeMax
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	const static std::string SHAPE_NAME[static_cast<int>(eShape::ShapeMax)];
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	static std::string Make(eShape eShapeType, size_t nBytes, int nDepth);
+	static eShape FindShape(std::string_view strName);
+
+	inline static const std::string& GetShapeName(eShape eShapeType)
+	{
+		return SHAPE_NAME[static_cast<int>(eShapeType)];
+	}
+
+private:
+	static void AppendFunction(eShape eShapeType, int nFunc, int nDepth, std::string& strSource);
+	static void AppendName(int nIdx, std::string& strSource);
+	static void AppendIndent(int nDepth, std::string& strSource);
+
+// ========================================================================================
+
+};
\ No newline at end of file
@@ -0,0 +1,480 @@
+#include <climits>
+#include "ConstantFolder.h"
+#include "DeadCodeEliminator.h"
+
+CDeadCodeEliminator::CDeadCodeEliminator()
+{
+}
+
+/**
+@brief		Remove the statements and functions of a program that can never run
+@param		prog		Program (bound by CResolver, folded by CConstantFolder)
+@return		true if anything was removed
+*/
+bool CDeadCodeEliminator::Eliminate(stProgram& prog)
+{
+	m_stStats = stDeadCodeStats();
+
+	for (stFunction* pFunc : prog.vFunc)
+		EliminateFunction(pFunc);
+
+	RemoveFunctions(prog);
+
+	return m_stStats.nStatements + m_stStats.nFunctions > 0;
+}
+
+/**
+@brief		Remove the unreachable statements of a function
+@param		pFunc		Function
+@return
+*/
+void CDeadCodeEliminator::EliminateFunction(stFunction* pFunc)
+{
+	m_vTask.clear();
+	m_vBreakTarget.clear();
+	m_setNoExit.clear();
+	PushBlock(pFunc->vBlock);
+
+	while (m_vTask.empty() == false)
+	{
+		stTask stTaskData = m_vTask.back();
+		m_vTask.pop_back();
+
+		switch (stTaskData.eKind)
+		{
+			case eTaskKind::Statement:
+				BeginStatement(stTaskData.pState);
+				break;
+			case eTaskKind::StatementEnd:
+				EndStatement(stTaskData.pState);
+				break;
+			case eTaskKind::BlockEnd:
+				CompactBlock(*stTaskData.pBlock);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+/**
+@brief		Push the blocks of a compound statement (a loop or switch becomes the target of its breaks)
+@param		pState		Statement
+@return
+*/
+void CDeadCodeEliminator::BeginStatement(stStatement* pState)
+{
+	switch (pState->eKind)
+	{
+		case eNodeKind::For:
+			m_vTask.push_back(stTask{ eTaskKind::StatementEnd, pState, nullptr, nullptr });
+			m_vBreakTarget.push_back(stBreakTarget{ pState, false });
+			PushBlock(static_cast<stFor*>(pState)->stBlock);
+			break;
+		case eNodeKind::While:
+			m_vTask.push_back(stTask{ eTaskKind::StatementEnd, pState, nullptr, nullptr });
+			m_vBreakTarget.push_back(stBreakTarget{ pState, false });
+			PushBlock(static_cast<stWhile*>(pState)->stBlock);
+			break;
+		case eNodeKind::If:
+		{
+			stIf* pIf = static_cast<stIf*>(pState);
+			m_vTask.push_back(stTask{ eTaskKind::StatementEnd, pState, nullptr, nullptr });
+			PushBlock(pIf->vElseBlock);
+			for (size_t i = pIf->vIfBlock.size(); i-- > 0;)
+				PushBlock(pIf->vIfBlock[i]);
+			break;
+		}
+		case eNodeKind::Switch:
+		{
+			stSwitch* pSwitch = static_cast<stSwitch*>(pState);
+			m_vTask.push_back(stTask{ eTaskKind::StatementEnd, pState, nullptr, nullptr });
+			m_vBreakTarget.push_back(stBreakTarget{ pState, false });
+			PushBlock(pSwitch->vDefaultBlock);
+			for (size_t i = pSwitch->vCaseBlock.size(); i-- > 0;)
+				PushBlock(pSwitch->vCaseBlock[i]);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Decide whether control can leave a compound statement whose blocks are compacted
+@param		pState		Statement
+@return
+*/
+void CDeadCodeEliminator::EndStatement(stStatement* pState)
+{
+	switch (pState->eKind)
+	{
+		case eNodeKind::For:
+		{
+			stFor* pFor = static_cast<stFor*>(pState);
+			bool bBreak = m_vBreakTarget.back().bBreak;
+			int nTruth = pFor->stCondExp == nullptr ? 1 : CConstantFolder::Truth(pFor->stCondExp);
+			m_vBreakTarget.pop_back();
+
+			if (nTruth == 1 &&
+				bBreak == false)
+				m_setNoExit.insert(pFor);
+
+			// Only the init-statement and the condition run
+			if (nTruth == 0)
+			{
+				for (const stStatement* pSub : pFor->stBlock)
+					m_stStats.nStatements += CountStatements(pSub);
+				pFor->stBlock.clear();
+				pFor->stLoopExp = nullptr;
+			}
+			break;
+		}
+		case eNodeKind::While:
+		{
+			stWhile* pWhile = static_cast<stWhile*>(pState);
+			bool bBreak = m_vBreakTarget.back().bBreak;
+			m_vBreakTarget.pop_back();
+
+			if (CConstantFolder::Truth(pWhile->stCondExp) == 1 &&
+				bBreak == false)
+				m_setNoExit.insert(pWhile);
+			break;
+		}
+		case eNodeKind::If:
+		{
+			// Without an else, control can go past every arm
+			stIf* pIf = static_cast<stIf*>(pState);
+			bool bNoExit = IsNoExit(pIf->vElseBlock);
+
+			for (size_t i = 0; i < pIf->vIfBlock.size() && bNoExit; ++i)
+				bNoExit = IsNoExit(pIf->vIfBlock[i]);
+
+			if (bNoExit)
+				m_setNoExit.insert(pIf);
+			break;
+		}
+		case eNodeKind::Switch:
+			m_vBreakTarget.pop_back();
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Remove the statements of a block that can never run
+@param		vBlock		Block (its compound statements are done)
+@return
+*/
+void CDeadCodeEliminator::CompactBlock(vstStatement& vBlock)
+{
+	size_t nKeep = 0;
+	bool bEnded = false;
+
+	for (size_t i = 0; i < vBlock.size(); ++i)
+	{
+		stStatement* pState = vBlock[i];
+
+		if (bEnded ||
+			(pState->eKind == eNodeKind::While && CConstantFolder::Truth(static_cast<stWhile*>(pState)->stCondExp) == 0))
+		{
+			m_stStats.nStatements += CountStatements(pState);
+			continue;
+		}
+
+		// A break that runs leaves the innermost loop or switch
+		if (pState->eKind == eNodeKind::Break &&
+			m_vBreakTarget.empty() == false)
+			m_vBreakTarget.back().bBreak = true;
+
+		vBlock[nKeep++] = pState;
+		bEnded = IsNoExit(pState);
+	}
+
+	vBlock.resize(nKeep);
+}
+
+/**
+@brief		Remove the functions that main does not reach and renumber the function bindings
+@param		prog		Program
+@return
+*/
+void CDeadCodeEliminator::RemoveFunctions(stProgram& prog)
+{
+	SymbolID nMain = CSymbolTable::Global().Find("main");
+	size_t nSize = prog.vFunc.size();
+	size_t nMainIdx = nSize;
+
+	for (size_t i = 0; i < nSize && nMainIdx == nSize; ++i)
+	{
+		if (prog.vFunc[i]->nSymbol == nMain)
+			nMainIdx = i;
+	}
+
+	if (nMain == CSymbolTable::INVALID_SYMBOL ||
+		nMainIdx == nSize)
+		return;
+
+	m_vRef.clear();
+	m_vRefBegin.clear();
+	for (stFunction* pFunc : prog.vFunc)
+	{
+		m_vRefBegin.push_back(m_vRef.size());
+		CollectReferences(pFunc);
+	}
+	m_vRefBegin.push_back(m_vRef.size());
+
+	// Walk the references from main (the new index of each function; UINT_MAX: not reached)
+	std::vector<unsigned int> vIndex(nSize, UINT_MAX);
+	std::vector<size_t> vWork(1, nMainIdx);
+	vIndex[nMainIdx] = 0;
+
+	while (vWork.empty() == false)
+	{
+		size_t nFunc = vWork.back();
+		vWork.pop_back();
+
+		for (size_t i = m_vRefBegin[nFunc]; i < m_vRefBegin[nFunc + 1]; ++i)
+		{
+			unsigned int nCallee = m_vRef[i]->nSlot;
+			if (nCallee < nSize &&
+				vIndex[nCallee] == UINT_MAX)
+			{
+				vIndex[nCallee] = 0;
+				vWork.push_back(nCallee);
+			}
+		}
+	}
+
+	std::vector<stFunction*> vFunc;
+	for (size_t i = 0; i < nSize; ++i)
+	{
+		if (vIndex[i] == UINT_MAX)
+			continue;
+
+		vIndex[i] = (unsigned int)vFunc.size();
+		vFunc.push_back(prog.vFunc[i]);
+	}
+
+	if (vFunc.size() == nSize)
+		return;
+
+	for (size_t i = 0; i < nSize; ++i)
+	{
+		if (vIndex[i] == UINT_MAX)
+			continue;
+
+		for (size_t j = m_vRefBegin[i]; j < m_vRefBegin[i + 1]; ++j)
+			m_vRef[j]->nSlot = vIndex[m_vRef[j]->nSlot];
+	}
+
+	m_stStats.nFunctions += nSize - vFunc.size();
+	prog.vFunc.swap(vFunc);
+}
+
+/**
+@brief		Add the function bindings of the references of a function to m_vRef
+@param		pFunc		Function
+@return
+*/
+void CDeadCodeEliminator::CollectReferences(stFunction* pFunc)
+{
+	m_vTask.clear();
+	for (stStatement* pState : pFunc->vBlock)
+		PushStatement(pState);
+
+	while (m_vTask.empty() == false)
+	{
+		stTask stTaskData = m_vTask.back();
+		m_vTask.pop_back();
+
+		if (stTaskData.eKind == eTaskKind::Statement)
+		{
+			stStatement* pState = stTaskData.pState;
+
+			switch (pState->eKind)
+			{
+				case eNodeKind::Variable:
+					PushExpression(static_cast<stVariable*>(pState)->stExp);
+					break;
+				case eNodeKind::ExpStatement:
+					PushExpression(static_cast<stExpStatement*>(pState)->stExp);
+					break;
+				case eNodeKind::Return:
+					PushExpression(static_cast<stReturn*>(pState)->stExp);
+					break;
+				case eNodeKind::For:
+				{
+					stFor* pFor = static_cast<stFor*>(pState);
+					PushStatement(pFor->stVar);
+					PushExpression(pFor->stCondExp);
+					PushExpression(pFor->stLoopExp);
+					for (stStatement* pSub : pFor->stBlock)
+						PushStatement(pSub);
+					break;
+				}
+				case eNodeKind::While:
+				{
+					stWhile* pWhile = static_cast<stWhile*>(pState);
+					PushExpression(pWhile->stCondExp);
+					for (stStatement* pSub : pWhile->stBlock)
+						PushStatement(pSub);
+					break;
+				}
+				case eNodeKind::If:
+				{
+					stIf* pIf = static_cast<stIf*>(pState);
+					for (stExpression* pCond : pIf->stCondStm)
+						PushExpression(pCond);
+					for (const vstStatement& vBlock : pIf->vIfBlock)
+						for (stStatement* pSub : vBlock)
+							PushStatement(pSub);
+					for (stStatement* pSub : pIf->vElseBlock)
+						PushStatement(pSub);
+					break;
+				}
+				case eNodeKind::Switch:
+				{
+					stSwitch* pSwitch = static_cast<stSwitch*>(pState);
+					PushExpression(pSwitch->stExp);
+					for (stExpression* pCase : pSwitch->stCondStm)
+						PushExpression(pCase);
+					for (const vstStatement& vBlock : pSwitch->vCaseBlock)
+						for (stStatement* pSub : vBlock)
+							PushStatement(pSub);
+					for (stStatement* pSub : pSwitch->vDefaultBlock)
+						PushStatement(pSub);
+					break;
+				}
+				case eNodeKind::Print:
+					for (stExpression* pArg : static_cast<stPrint*>(pState)->stArgs)
+						PushExpression(pArg);
+					break;
+				default:
+					break;
+			}
+			continue;
+		}
+
+		stExpression* pExp = stTaskData.pExp;
+		switch (pExp->eKind)
+		{
+			case eNodeKind::GetVariable:
+			{
+				stBinding& stBind = static_cast<stGetVariable*>(pExp)->stBind;
+				if (stBind.eKind == eBindKind::Function)
+					m_vRef.push_back(&stBind);
+				break;
+			}
+			case eNodeKind::SetVariable:
+			{
+				stSetVariable* pSetVar = static_cast<stSetVariable*>(pExp);
+				if (pSetVar->stBind.eKind == eBindKind::Function)
+					m_vRef.push_back(&pSetVar->stBind);
+				PushExpression(pSetVar->stInitExp);
+				break;
+			}
+			case eNodeKind::And:
+				PushExpression(static_cast<stAnd*>(pExp)->stLeft);
+				PushExpression(static_cast<stAnd*>(pExp)->stRight);
+				break;
+			case eNodeKind::Or:
+				PushExpression(static_cast<stOr*>(pExp)->stLeft);
+				PushExpression(static_cast<stOr*>(pExp)->stRight);
+				break;
+			case eNodeKind::Relational:
+				PushExpression(static_cast<stRelational*>(pExp)->stLeft);
+				PushExpression(static_cast<stRelational*>(pExp)->stRight);
+				break;
+			case eNodeKind::Arithmetic:
+				PushExpression(static_cast<stArithmetic*>(pExp)->stLeft);
+				PushExpression(static_cast<stArithmetic*>(pExp)->stRight);
+				break;
+			case eNodeKind::Unary:
+				PushExpression(static_cast<stUnary*>(pExp)->stSubExp);
+				break;
+			case eNodeKind::Convert:
+				PushExpression(static_cast<stConvert*>(pExp)->stSubExp);
+				break;
+			case eNodeKind::GetElement:
+				PushExpression(static_cast<stGetElement*>(pExp)->stMemsExp);
+				PushExpression(static_cast<stGetElement*>(pExp)->stIndexExp);
+				break;
+			case eNodeKind::SetElement:
+				PushExpression(static_cast<stSetElement*>(pExp)->stMemsExp);
+				PushExpression(static_cast<stSetElement*>(pExp)->stIndexExp);
+				PushExpression(static_cast<stSetElement*>(pExp)->stInitExp);
+				break;
+			case eNodeKind::CallFunc:
+			{
+				stCallFunc* pCall = static_cast<stCallFunc*>(pExp);
+				PushExpression(pCall->stSubExp);
+				for (stExpression* pArg : pCall->vArgsExp)
+					PushExpression(pArg);
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
+/**
+@brief		Count a statement and the statements nested in it
+@param		pState		Statement
+@return		Statement count
+*/
+size_t CDeadCodeEliminator::CountStatements(const stStatement* pState)
+{
+	size_t nCount = 0;
+	m_vCount.clear();
+	m_vCount.push_back(pState);
+
+	while (m_vCount.empty() == false)
+	{
+		const stStatement* pCur = m_vCount.back();
+		m_vCount.pop_back();
+
+		if (pCur == nullptr)
+			continue;
+
+		++nCount;
+		switch (pCur->eKind)
+		{
+			case eNodeKind::For:
+			{
+				const stFor* pFor = static_cast<const stFor*>(pCur);
+				m_vCount.push_back(pFor->stVar);
+				m_vCount.insert(m_vCount.end(), pFor->stBlock.begin(), pFor->stBlock.end());
+				break;
+			}
+			case eNodeKind::While:
+			{
+				const stWhile* pWhile = static_cast<const stWhile*>(pCur);
+				m_vCount.insert(m_vCount.end(), pWhile->stBlock.begin(), pWhile->stBlock.end());
+				break;
+			}
+			case eNodeKind::If:
+			{
+				const stIf* pIf = static_cast<const stIf*>(pCur);
+				for (const vstStatement& vBlock : pIf->vIfBlock)
+					m_vCount.insert(m_vCount.end(), vBlock.begin(), vBlock.end());
+				m_vCount.insert(m_vCount.end(), pIf->vElseBlock.begin(), pIf->vElseBlock.end());
+				break;
+			}
+			case eNodeKind::Switch:
+			{
+				const stSwitch* pSwitch = static_cast<const stSwitch*>(pCur);
+				for (const vstStatement& vBlock : pSwitch->vCaseBlock)
+					m_vCount.insert(m_vCount.end(), vBlock.begin(), vBlock.end());
+				m_vCount.insert(m_vCount.end(), pSwitch->vDefaultBlock.begin(), pSwitch->vDefaultBlock.end());
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	return nCount;
+}
\ No newline at end of file
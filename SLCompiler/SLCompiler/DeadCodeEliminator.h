@@ -0,0 +1,135 @@
+#pragma once
+#include <unordered_set>
+#include <vector>
+#include "Structures.h"
+
+// Dead code eliminator (optimization pass, runs after CConstantFolder)
+// Removes the statements that can never run, so the later stages neither compile nor keep them.
+// - Statements after a return, break or continue in a block are removed, and so are the
+//   statements after an if whose arms and else all end that way, or after a while (true) /
+//   for (;;) that no break leaves.
+// - A while with a constant false condition is removed; a for with one keeps only its
+//   init-statement (the block and the loop expression never run).
+// - Functions that are not reached from main through calls (or references) are removed, and the
+//   function bindings of the rest are renumbered. A program without main keeps every function.
+// Conditions are constant once CConstantFolder has folded them. Nodes stay in the arena, so
+// stProgram::nNodeCount stays an upper bound.
+// Nodes are visited with an explicit stack of tasks (children before their parent), so any
+// nesting depth the parser accepts can be handled.
+class CDeadCodeEliminator
+{
+// Enums and Classes, Structures ==========================================================
+public:
+	// Work of the last Eliminate()
+	struct stDeadCodeStats
+	{
+	public:
+		// Statements removed (with the statements nested in them)
+		size_t nStatements = 0;
+		// Functions removed
+		size_t nFunctions = 0;
+	};
+
+private:
+	enum class eTaskKind : unsigned char
+	{
+		Statement,
+		// Decide whether control can leave a compound statement once its blocks are done
+		StatementEnd,
+		// Remove the unreachable statements of a block
+		BlockEnd,
+		Expression,
+	};
+
+	struct stTask
+	{
+	public:
+		eTaskKind eKind;
+		stStatement* pState;
+		stExpression* pExp;
+		vstStatement* pBlock;
+	};
+
+	// Statement that a break leaves (loop or switch)
+	struct stBreakTarget
+	{
+	public:
+		stStatement* pState;
+		bool bBreak;
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	// Tasks that are waiting to be visited (last in, first out)
+	std::vector<stTask> m_vTask;
+	// Loops and switches that enclose the visited statement (innermost last)
+	std::vector<stBreakTarget> m_vBreakTarget;
+	// Compound statements after which nothing runs
+	std::unordered_set<const stStatement*> m_setNoExit;
+	// Function bindings of the references of each function (m_vRefBegin[i] .. m_vRefBegin[i + 1])
+	std::vector<stBinding*> m_vRef;
+	std::vector<size_t> m_vRefBegin;
+	// Statements that are waiting to be counted by CountStatements()
+	std::vector<const stStatement*> m_vCount;
+	stDeadCodeStats m_stStats;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CDeadCodeEliminator();
+
+	bool Eliminate(stProgram& prog);
+
+	inline const stDeadCodeStats& GetStats() const
+	{
+		return m_stStats;
+	}
+
+private:
+	void EliminateFunction(stFunction* pFunc);
+	void BeginStatement(stStatement* pState);
+	void EndStatement(stStatement* pState);
+	void CompactBlock(vstStatement& vBlock);
+	void RemoveFunctions(stProgram& prog);
+	void CollectReferences(stFunction* pFunc);
+	size_t CountStatements(const stStatement* pState);
+
+	inline void PushStatement(stStatement* pState)
+	{
+		if (pState != nullptr)
+			m_vTask.push_back(stTask{ eTaskKind::Statement, pState, nullptr, nullptr });
+	}
+
+	inline void PushExpression(stExpression* pExp)
+	{
+		if (pExp != nullptr)
+			m_vTask.push_back(stTask{ eTaskKind::Expression, nullptr, pExp, nullptr });
+	}
+
+	inline void PushBlock(vstStatement& vBlock)
+	{
+		m_vTask.push_back(stTask{ eTaskKind::BlockEnd, nullptr, nullptr, &vBlock });
+		for (size_t i = vBlock.size(); i-- > 0;)
+			PushStatement(vBlock[i]);
+	}
+
+	// Whether control never goes on to the next statement of the block
+	inline bool IsNoExit(const stStatement* pState) const
+	{
+		return pState->eKind == eNodeKind::Return ||
+			   pState->eKind == eNodeKind::Break ||
+			   pState->eKind == eNodeKind::Continue ||
+			   m_setNoExit.count(pState) > 0;
+	}
+
+	inline bool IsNoExit(const vstStatement& vBlock) const
+	{
+		return vBlock.empty() == false && IsNoExit(vBlock.back());
+	}
+
+// ========================================================================================
+
+};
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <algorithm>
+#include "Diagnostics.h"
+
+// Level string
+static const char* LEVEL_STRING[] =
+{
+	"Warning",
+	"Error",
+};
+
+CDiagnostics::CDiagnostics()
+	: m_nErrors(0)
+{}
+
+/**
+@brief		Add a diagnostic
+@param		eLv				Level
+@param		nOffset			Source offset
+@param		strMessage		Message
+@return
+*/
+void CDiagnostics::Add(stDiagnostic::eLevel eLv, size_t nOffset, std::string strMessage)
+{
+	m_vDiag.emplace_back(eLv, nOffset, std::move(strMessage));
+	if (eLv == stDiagnostic::eLevel::Error)
+		++m_nErrors;
+}
+
+/**
+@brief		Append the diagnostics of another collector
+@param		diag		Diagnostics
+@return
+*/
+void CDiagnostics::Append(const CDiagnostics& diag)
+{
+	m_vDiag.insert(m_vDiag.end(), diag.m_vDiag.begin(), diag.m_vDiag.end());
+	m_nErrors += diag.m_nErrors;
+}
+
+/**
+@brief		Remove every diagnostic
+@return
+*/
+void CDiagnostics::Clear()
+{
+	m_vDiag.clear();
+	m_nErrors = 0;
+}
+
+/**
+@brief		Sort the diagnostics by source offset
+			(The streaming parser reports a function after the lexer has scanned all of it)
+@return
+*/
+void CDiagnostics::Sort()
+{
+	std::stable_sort(m_vDiag.begin(), m_vDiag.end(), [](const stDiagnostic& stA, const stDiagnostic& stB) {
+		return stA.nOffset < stB.nOffset;
+	});
+}
+
+/**
+@brief		Print the diagnostics
+@param		strSource		Source code (if given, offsets are printed as line:column)
+@return
+*/
+void CDiagnostics::Print(std::string_view strSource) const
+{
+	// Lines are counted by one cursor that moves forward with the offsets, so sorted diagnostics
+	// scan the source once (an offset before the cursor starts the count again)
+	size_t nCursor = 0;
+	size_t nLine = 1;
+	size_t nLineStart = 0;
+
+	for (const stDiagnostic& stDiag : m_vDiag)
+	{
+		const char* pLevel = LEVEL_STRING[static_cast<int>(stDiag.eLv)];
+
+		if (strSource.empty() ||
+			stDiag.nOffset > strSource.size())
+		{
+			printf("[%-7s] offset %zu: %s\n", pLevel, stDiag.nOffset, stDiag.strMessage.c_str());
+			continue;
+		}
+
+		if (stDiag.nOffset < nCursor)
+		{
+			nCursor = 0;
+			nLine = 1;
+			nLineStart = 0;
+		}
+
+		for (; nCursor < stDiag.nOffset; ++nCursor)
+		{
+			if (strSource[nCursor] == '\n')
+			{
+				++nLine;
+				nLineStart = nCursor + 1;
+			}
+		}
+
+		printf("[%-7s] %zu:%zu: %s\n", pLevel, nLine, stDiag.nOffset - nLineStart + 1, stDiag.strMessage.c_str());
+	}
+}
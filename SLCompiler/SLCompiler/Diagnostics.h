@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Diagnostic structure
+struct stDiagnostic
+{
+public:
+	enum class eLevel
+	{
+		Warning,
+		Error,
+	};
+
+	// Level
+	eLevel eLv = eLevel::Error;
+	// Source offset
+	size_t nOffset = 0;
+	// Message
+	std::string strMessage;
+
+	stDiagnostic() {}
+	stDiagnostic(eLevel eLv, size_t nOffset, std::string strMessage)
+		: eLv(eLv), nOffset(nOffset), strMessage(std::move(strMessage)) {}
+};
+
+// Diagnostics of one compilation
+class CDiagnostics
+{
+// Variables ==============================================================================
+private:
+	std::vector<stDiagnostic> m_vDiag;
+	size_t m_nErrors;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CDiagnostics();
+
+	void Add(stDiagnostic::eLevel eLv, size_t nOffset, std::string strMessage);
+	void Append(const CDiagnostics& diag);
+	void Clear();
+	void Sort();
+	void Print(std::string_view strSource = std::string_view()) const;
+
+	inline void Error(size_t nOffset, std::string strMessage)
+	{
+		Add(stDiagnostic::eLevel::Error, nOffset, std::move(strMessage));
+	}
+
+	inline void Warning(size_t nOffset, std::string strMessage)
+	{
+		Add(stDiagnostic::eLevel::Warning, nOffset, std::move(strMessage));
+	}
+
+	inline bool HasError() const
+	{
+		return m_nErrors > 0;
+	}
+
+	inline size_t ErrorCount() const
+	{
+		return m_nErrors;
+	}
+
+	inline const std::vector<stDiagnostic>& Get() const
+	{
+		return m_vDiag;
+	}
+
+// ========================================================================================
+
+};
@@ -0,0 +1,987 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+#include "FlatAST.h"
+
+CFlatAST::CFlatAST()
+	: m_nFuncList(EMPTY_LIST),
+	  m_pKind(nullptr), m_pOp(nullptr), m_pA(nullptr), m_pB(nullptr), m_pC(nullptr), m_pOffset(nullptr), m_pList(nullptr), m_pString(nullptr),
+	  m_nNodes(0), m_nListSize(0), m_nStringSize(0)
+{
+	Clear();
+}
+
+/**
+@brief		Build the flat AST of a program
+@param		prog		Program
+@return
+*/
+void CFlatAST::Build(const stProgram& prog)
+{
+	Clear();
+
+	m_vKind.reserve(prog.nNodeCount);
+	m_vOp.reserve(prog.nNodeCount);
+	m_vA.reserve(prog.nNodeCount);
+	m_vB.reserve(prog.nNodeCount);
+	m_vC.reserve(prog.nNodeCount);
+	m_vOffset.reserve(prog.nNodeCount);
+
+	m_nFuncList = AddList(prog.vFunc.size());
+	for (size_t i = prog.vFunc.size(); i-- > 0;)
+		PushStatement(prog.vFunc[i], eSlot::List, m_nFuncList + 1 + (unsigned int)i);
+
+	// Children are pushed in reverse, so the nodes come out in pre-order
+	while (m_vTask.empty() == false)
+	{
+		stTask stChild = m_vTask.back();
+		m_vTask.pop_back();
+
+		NodeID nNode = stChild.pState != nullptr ? AddStatement(stChild.pState) : AddExpression(stChild.pExp);
+		if (nNode != INVALID_NODE)
+			m_vOffset[nNode] = stChild.pState != nullptr ? stChild.pState->nOffset : stChild.pExp->nOffset;
+		SetSlot(stChild, nNode);
+	}
+
+	BindVectors();
+}
+
+/**
+@brief		Remove every node
+@return
+*/
+void CFlatAST::Clear()
+{
+	m_vKind.clear();
+	m_vOp.clear();
+	m_vA.clear();
+	m_vB.clear();
+	m_vC.clear();
+	m_vOffset.clear();
+	m_vString.clear();
+	m_vTask.clear();
+
+	// List 0 is the empty list
+	m_vList.clear();
+	m_vList.push_back(0);
+	m_nFuncList = EMPTY_LIST;
+
+	m_pFile.reset();
+	BindVectors();
+}
+
+/**
+@brief		Memory used by the nodes, lists and strings
+@return		Bytes
+*/
+size_t CFlatAST::GetBytes() const
+{
+	return m_nNodes * (sizeof(unsigned char) * 2 + sizeof(unsigned int) * 4) +
+		   m_nListSize * sizeof(unsigned int) + m_nStringSize;
+}
+
+/**
+@brief		Write the flat AST to a file
+@param		strPath			File path (written to a temporary file first, then renamed)
+@param		nSourceHash		Hash of the source code (checked by Load)
+@param		strSource		Source code (a copy is written last and compared by Load)
+@return		Whether the file could be written
+*/
+bool CFlatAST::Save(const std::string& strPath, unsigned long long nSourceHash, std::string_view strSource) const
+{
+	// Symbols become indices into the name table of the file
+	std::unordered_map<SymbolID, unsigned int> mapLocal;
+	std::vector<std::string_view> vName;
+	std::vector<unsigned int> vA(m_pA, m_pA + m_nNodes);
+	std::vector<unsigned int> vList(m_pList, m_pList + m_nListSize);
+
+	auto ToLocal = [&mapLocal, &vName](unsigned int& nSymbol) {
+		if (nSymbol == CSymbolTable::INVALID_SYMBOL)
+			return;
+
+		std::pair<std::unordered_map<SymbolID, unsigned int>::iterator, bool> result = mapLocal.emplace(nSymbol, (unsigned int)vName.size());
+		if (result.second)
+			vName.push_back(CSymbolTable::Global().GetName(nSymbol));
+		nSymbol = result.first->second;
+	};
+
+	for (size_t i = 0; i < m_nNodes; ++i)
+	{
+		eNodeKind eKind = static_cast<eNodeKind>(m_pKind[i]);
+		if (IsSymbolNode(eKind) == false)
+			continue;
+
+		ToLocal(vA[i]);
+		if (eKind == eNodeKind::Function)
+		{
+			for (unsigned int nParam = 1; nParam <= vList[m_pB[i]]; ++nParam)
+				ToLocal(vList[m_pB[i] + nParam]);
+		}
+	}
+
+	std::vector<unsigned int> vNameOffset(1, 0);
+	for (std::string_view strName : vName)
+		vNameOffset.push_back(vNameOffset.back() + (unsigned int)strName.size());
+
+	stFileHeader stHeader = { { 'S', 'L', 'A', 'C' }, FILE_VERSION, nSourceHash, strSource.size(),
+		(unsigned int)m_nNodes, (unsigned int)m_nListSize, (unsigned int)m_nStringSize,
+		(unsigned int)vName.size(), vNameOffset.back(), m_nFuncList };
+
+	std::string strTemp = strPath + ".tmp";
+	FILE* pFile = fopen(strTemp.c_str(), "wb");
+	if (pFile == nullptr)
+		return false;
+
+	bool bWritten = fwrite(&stHeader, sizeof(stHeader), 1, pFile) == 1 &&
+					fwrite(vA.data(), sizeof(unsigned int), m_nNodes, pFile) == m_nNodes &&
+					fwrite(m_pB, sizeof(unsigned int), m_nNodes, pFile) == m_nNodes &&
+					fwrite(m_pC, sizeof(unsigned int), m_nNodes, pFile) == m_nNodes &&
+					fwrite(m_pOffset, sizeof(unsigned int), m_nNodes, pFile) == m_nNodes &&
+					fwrite(vList.data(), sizeof(unsigned int), m_nListSize, pFile) == m_nListSize &&
+					fwrite(vNameOffset.data(), sizeof(unsigned int), vNameOffset.size(), pFile) == vNameOffset.size() &&
+					fwrite(m_pKind, 1, m_nNodes, pFile) == m_nNodes &&
+					fwrite(m_pOp, 1, m_nNodes, pFile) == m_nNodes &&
+					fwrite(m_pString, 1, m_nStringSize, pFile) == m_nStringSize;
+
+	for (size_t i = 0; bWritten && i < vName.size(); ++i)
+		bWritten = fwrite(vName[i].data(), 1, vName[i].size(), pFile) == vName[i].size();
+
+	bWritten = bWritten && fwrite(strSource.data(), 1, strSource.size(), pFile) == strSource.size();
+
+	bWritten = fclose(pFile) == 0 && bWritten;
+
+	std::error_code error;
+	if (bWritten)
+		std::filesystem::rename(strTemp, strPath, error);
+	if (bWritten == false || error)
+	{
+		std::filesystem::remove(strTemp, error);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+@brief		Map a file written by Save()
+@param		strPath			File path
+@param		nSourceHash		Hash of the source code
+@param		strSource		Source code (compared with the copy in the file, so a hash collision is a miss)
+@return		false if the file is missing, broken or of another source (the AST is cleared)
+*/
+bool CFlatAST::Load(const std::string& strPath, unsigned long long nSourceHash, std::string_view strSource)
+{
+	Clear();
+
+	std::unique_ptr<CSourceFile> pFile(new CSourceFile());
+	if (pFile->Open(strPath) == false ||
+		pFile->Size() < sizeof(stFileHeader))
+		return false;
+
+	stFileHeader stHeader;
+	memcpy(&stHeader, pFile->Data(), sizeof(stHeader));
+
+	if (memcmp(stHeader.arrMagic, "SLAC", 4) != 0 ||
+		stHeader.nVersion != FILE_VERSION ||
+		stHeader.nSourceHash != nSourceHash ||
+		stHeader.nSourceSize != strSource.size() ||
+		stHeader.nListSize == 0 ||
+		stHeader.nFuncList >= stHeader.nListSize)
+		return false;
+
+	size_t nWords = (size_t)stHeader.nNodes * 4 + stHeader.nListSize + stHeader.nSymbols + 1;
+	size_t nBytes = (size_t)stHeader.nNodes * 2 + stHeader.nStringSize + stHeader.nNameBytes + strSource.size();
+	if (pFile->Size() != sizeof(stFileHeader) + nWords * sizeof(unsigned int) + nBytes)
+		return false;
+
+	const unsigned int* pWord = reinterpret_cast<const unsigned int*>(pFile->Data() + sizeof(stFileHeader));
+	const unsigned int* pNameOffset = pWord + (size_t)stHeader.nNodes * 4 + stHeader.nListSize;
+	const char* pByte = reinterpret_cast<const char*>(pNameOffset + stHeader.nSymbols + 1);
+	const char* pName = pByte + (size_t)stHeader.nNodes * 2 + stHeader.nStringSize;
+
+	// The hash only names the file: the source itself must be the same
+	if (memcmp(pName + stHeader.nNameBytes, strSource.data(), strSource.size()) != 0)
+		return false;
+
+	m_pA = pWord;
+	m_pB = pWord + stHeader.nNodes;
+	m_pC = pWord + (size_t)stHeader.nNodes * 2;
+	m_pOffset = pWord + (size_t)stHeader.nNodes * 3;
+	m_pList = pWord + (size_t)stHeader.nNodes * 4;
+	m_pKind = reinterpret_cast<const unsigned char*>(pByte);
+	m_pOp = m_pKind + stHeader.nNodes;
+	m_pString = pByte + (size_t)stHeader.nNodes * 2;
+	m_nNodes = stHeader.nNodes;
+	m_nListSize = stHeader.nListSize;
+	m_nStringSize = stHeader.nStringSize;
+	m_nFuncList = stHeader.nFuncList;
+	m_pFile = std::move(pFile);
+
+	// Symbol indices of the file to global IDs
+	std::vector<SymbolID> vSymbolRemap(stHeader.nSymbols);
+	bool bIdentity = true;
+
+	for (unsigned int i = 0; i < stHeader.nSymbols; ++i)
+	{
+		vSymbolRemap[i] = CSymbolTable::Global().Intern(std::string_view(pName + pNameOffset[i], pNameOffset[i + 1] - pNameOffset[i]));
+		bIdentity = bIdentity && vSymbolRemap[i] == i;
+	}
+
+	if (bIdentity)
+		return true;
+
+	m_vA.assign(m_pA, m_pA + m_nNodes);
+	m_vList.assign(m_pList, m_pList + m_nListSize);
+
+	auto ToGlobal = [&vSymbolRemap](unsigned int& nSymbol) {
+		if (nSymbol < vSymbolRemap.size())
+			nSymbol = vSymbolRemap[nSymbol];
+	};
+
+	for (size_t i = 0; i < m_nNodes; ++i)
+	{
+		eNodeKind eKind = static_cast<eNodeKind>(m_pKind[i]);
+		if (IsSymbolNode(eKind) == false)
+			continue;
+
+		ToGlobal(m_vA[i]);
+		if (eKind == eNodeKind::Function)
+		{
+			for (unsigned int nParam = 1; nParam <= m_vList[m_pB[i]]; ++nParam)
+				ToGlobal(m_vList[m_pB[i] + nParam]);
+		}
+	}
+
+	m_pA = m_vA.data();
+	m_pList = m_vList.data();
+
+	return true;
+}
+
+/**
+@brief		Rebuild the node tree of the flat AST
+@param		prog		(out) Program (empty; nodes are made in its arena)
+@return
+*/
+void CFlatAST::ToProgram(stProgram& prog) const
+{
+	CArena::CScope scope(prog.arena);
+	std::vector<stRebuildTask> vTask;
+	stList listFunc = Functions();
+
+	prog.vFunc.resize(listFunc.nCount);
+	for (unsigned int i = 0; i < listFunc.nCount; ++i)
+		prog.vFunc[i] = static_cast<stFunction*>(NewStatement(prog.arena, listFunc[i], vTask));
+
+	while (vTask.empty() == false)
+	{
+		stRebuildTask stChild = vTask.back();
+		vTask.pop_back();
+
+		if (stChild.ppState != nullptr)
+			*stChild.ppState = NewStatement(prog.arena, stChild.nNode, vTask);
+		else
+			*stChild.ppExp = NewExpression(prog.arena, stChild.nNode, vTask);
+	}
+
+	prog.nNodeCount = m_nNodes + 1;
+}
+
+/**
+@brief		Value of a DoubleData node
+@param		nNode		Node
+@return		Value
+*/
+double CFlatAST::Double(NodeID nNode) const
+{
+	unsigned long long nBits = (unsigned long long)m_pB[nNode] << 32 | m_pA[nNode];
+	double dValue;
+	memcpy(&dValue, &nBits, sizeof(dValue));
+
+	return dValue;
+}
+
+/**
+@brief		Add a node (operands are set once the children are added)
+@param		eKind		Node kind
+@param		eOp			Operator or data type
+@return		Node
+*/
+NodeID CFlatAST::AddNode(eNodeKind eKind, CLexer::eLexEnum eOp)
+{
+	NodeID nNode = (NodeID)m_vKind.size();
+
+	m_vKind.push_back(static_cast<unsigned char>(eKind));
+	m_vOp.push_back(static_cast<unsigned char>(eOp));
+	m_vA.push_back(INVALID_NODE);
+	m_vB.push_back(INVALID_NODE);
+	m_vC.push_back(INVALID_NODE);
+	m_vOffset.push_back(0);
+
+	return nNode;
+}
+
+/**
+@brief		Add a list (items are INVALID_NODE until the children are added)
+@param		nCount		Item count
+@return		List
+*/
+unsigned int CFlatAST::AddList(size_t nCount)
+{
+	if (nCount == 0)
+		return EMPTY_LIST;
+
+	unsigned int nList = (unsigned int)m_vList.size();
+	m_vList.push_back((unsigned int)nCount);
+	m_vList.resize(m_vList.size() + nCount, INVALID_NODE);
+
+	return nList;
+}
+
+/**
+@brief		Add the list of a block (the statements are pushed as children)
+@param		vBlock		Block
+@return		List of the statements
+*/
+unsigned int CFlatAST::AddBlock(const vstStatement& vBlock)
+{
+	unsigned int nList = AddList(vBlock.size());
+
+	for (size_t i = vBlock.size(); i-- > 0;)
+		PushStatement(vBlock[i], eSlot::List, nList + 1 + (unsigned int)i);
+
+	return nList;
+}
+
+/**
+@brief		Add the list of expressions (the expressions are pushed as children)
+@param		vExp		Expressions
+@return		List of the expressions
+*/
+unsigned int CFlatAST::AddExpressionList(const vstExpression& vExp)
+{
+	unsigned int nList = AddList(vExp.size());
+
+	for (size_t i = vExp.size(); i-- > 0;)
+		PushExpression(vExp[i], eSlot::List, nList + 1 + (unsigned int)i);
+
+	return nList;
+}
+
+/**
+@brief		Write the NodeID of an added child into its parent
+@param		stChild		Child
+@param		nNode		Node of the child
+@return
+*/
+void CFlatAST::SetSlot(const stTask& stChild, NodeID nNode)
+{
+	switch (stChild.eTarget)
+	{
+		case eSlot::A:
+			m_vA[stChild.nIndex] = nNode;
+			break;
+		case eSlot::B:
+			m_vB[stChild.nIndex] = nNode;
+			break;
+		case eSlot::C:
+			m_vC[stChild.nIndex] = nNode;
+			break;
+		case eSlot::List:
+			m_vList[stChild.nIndex] = nNode;
+			break;
+	}
+}
+
+/**
+@brief		Add a string to the string pool
+@param		strString	String
+@return		Offset
+*/
+unsigned int CFlatAST::AddString(std::string_view strString)
+{
+	unsigned int nOffset = (unsigned int)m_vString.size();
+	m_vString.insert(m_vString.end(), strString.begin(), strString.end());
+
+	return nOffset;
+}
+
+/**
+@brief		Add a statement (its children are pushed in reverse order)
+@param		pState		Statement
+@return		Node
+*/
+NodeID CFlatAST::AddStatement(const stStatement* pState)
+{
+	switch (pState->eKind)
+	{
+		case eNodeKind::Function:
+		{
+			const stFunction* pFunc = static_cast<const stFunction*>(pState);
+			NodeID nNode = AddNode(eNodeKind::Function, pFunc->eType);
+
+			// The parameter types follow the symbols (past the count of the list)
+			size_t nParamCount = pFunc->vParams.size();
+			unsigned int nParams = AddList(nParamCount * 2);
+			if (nParamCount > 0)
+				m_vList[nParams] = (unsigned int)nParamCount;
+			for (size_t i = 0; i < nParamCount; ++i)
+			{
+				m_vList[nParams + 1 + i] = pFunc->vParams[i];
+				m_vList[nParams + 1 + nParamCount + i] = static_cast<unsigned int>(pFunc->vParamTypes[i]);
+			}
+
+			SetOperands(nNode, pFunc->nSymbol, nParams, AddBlock(pFunc->vBlock));
+			return nNode;
+		}
+		case eNodeKind::Variable:
+		{
+			const stVariable* pVar = static_cast<const stVariable*>(pState);
+			NodeID nNode = AddNode(eNodeKind::Variable, pVar->eType);
+			SetOperands(nNode, pVar->nSymbol);
+			PushExpression(pVar->stExp, eSlot::B, nNode);
+			return nNode;
+		}
+		case eNodeKind::ExpStatement:
+		{
+			NodeID nNode = AddNode(eNodeKind::ExpStatement);
+			PushExpression(static_cast<const stExpStatement*>(pState)->stExp, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::Return:
+		{
+			NodeID nNode = AddNode(eNodeKind::Return);
+			PushExpression(static_cast<const stReturn*>(pState)->stExp, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::For:
+		{
+			const stFor* pFor = static_cast<const stFor*>(pState);
+			NodeID nNode = AddNode(eNodeKind::For);
+			unsigned int nHeader = AddList(2);
+			unsigned int nBlock = AddBlock(pFor->stBlock);
+
+			SetOperands(nNode, INVALID_NODE, nHeader, nBlock);
+			PushExpression(pFor->stLoopExp, eSlot::List, nHeader + 2);
+			PushExpression(pFor->stCondExp, eSlot::List, nHeader + 1);
+			PushStatement(pFor->stVar, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::While:
+		{
+			const stWhile* pWhile = static_cast<const stWhile*>(pState);
+			NodeID nNode = AddNode(eNodeKind::While);
+			unsigned int nBlock = AddBlock(pWhile->stBlock);
+
+			SetOperands(nNode, INVALID_NODE, nBlock);
+			PushExpression(pWhile->stCondExp, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::If:
+		{
+			const stIf* pIf = static_cast<const stIf*>(pState);
+			NodeID nNode = AddNode(eNodeKind::If);
+			unsigned int nElse = AddBlock(pIf->vElseBlock);
+
+			unsigned int nBlocks = AddList(pIf->vIfBlock.size());
+			for (size_t i = pIf->vIfBlock.size(); i-- > 0;)
+			{
+				unsigned int nBlock = AddBlock(pIf->vIfBlock[i]);
+				m_vList[nBlocks + 1 + i] = nBlock;
+			}
+
+			SetOperands(nNode, AddExpressionList(pIf->stCondStm), nBlocks, nElse);
+			return nNode;
+		}
+		case eNodeKind::Switch:
+		{
+			const stSwitch* pSwitch = static_cast<const stSwitch*>(pState);
+			NodeID nNode = AddNode(eNodeKind::Switch);
+
+			// Cases and the default in source order (the default has no condition)
+			size_t nDefault = pSwitch->nDefaultIdx == -1 ? SIZE_MAX : (size_t)pSwitch->nDefaultIdx;
+			size_t nArms = pSwitch->vCaseBlock.size() + (nDefault == SIZE_MAX ? 0 : 1);
+			unsigned int nConds = AddList(nArms);
+			unsigned int nBlocks = AddList(nArms);
+			for (size_t i = nArms; i-- > 0;)
+			{
+				size_t nCase = i > nDefault ? i - 1 : i;
+				unsigned int nBlock = AddBlock(i == nDefault ? pSwitch->vDefaultBlock : pSwitch->vCaseBlock[nCase]);
+				m_vList[nBlocks + 1 + i] = nBlock;
+			}
+			for (size_t i = nArms; i-- > 0;)
+			{
+				if (i != nDefault)
+					PushExpression(pSwitch->stCondStm[i > nDefault ? i - 1 : i], eSlot::List, nConds + 1 + (unsigned int)i);
+			}
+
+			SetOperands(nNode, INVALID_NODE, nConds, nBlocks);
+			PushExpression(pSwitch->stExp, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::Break:
+		case eNodeKind::Continue:
+			return AddNode(pState->eKind);
+		case eNodeKind::Print:
+		{
+			const stPrint* pPrint = static_cast<const stPrint*>(pState);
+			NodeID nNode = AddNode(eNodeKind::Print);
+			unsigned int nOffset = AddString(pPrint->strFormat);
+			SetOperands(nNode, nOffset, (unsigned int)pPrint->strFormat.size(), AddExpressionList(pPrint->stArgs));
+			return nNode;
+		}
+		default:
+			return INVALID_NODE;
+	}
+}
+
+/**
+@brief		Add an expression (its children are pushed in reverse order)
+@param		pExp		Expression
+@return		Node
+*/
+NodeID CFlatAST::AddExpression(const stExpression* pExp)
+{
+	switch (pExp->eKind)
+	{
+		case eNodeKind::NullData:
+		case eNodeKind::VoidData:
+			return AddNode(pExp->eKind);
+		case eNodeKind::BoolData:
+		{
+			NodeID nNode = AddNode(eNodeKind::BoolData);
+			SetOperands(nNode, static_cast<const stBoolData*>(pExp)->bData ? 1 : 0);
+			return nNode;
+		}
+		case eNodeKind::IntData:
+		{
+			NodeID nNode = AddNode(eNodeKind::IntData);
+			SetOperands(nNode, (unsigned int)static_cast<const stIntData*>(pExp)->nData);
+			return nNode;
+		}
+		case eNodeKind::DoubleData:
+		{
+			NodeID nNode = AddNode(eNodeKind::DoubleData);
+			unsigned long long nBits;
+			memcpy(&nBits, &static_cast<const stDoubleData*>(pExp)->dData, sizeof(nBits));
+			SetOperands(nNode, (unsigned int)nBits, (unsigned int)(nBits >> 32));
+			return nNode;
+		}
+		case eNodeKind::StringData:
+		{
+			const stStringData* pString = static_cast<const stStringData*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::StringData);
+			SetOperands(nNode, AddString(pString->strData), (unsigned int)pString->strData.size());
+			return nNode;
+		}
+		case eNodeKind::Array:
+		{
+			NodeID nNode = AddNode(eNodeKind::Array);
+			SetOperands(nNode, (unsigned int)static_cast<const stArray*>(pExp)->Size());
+			return nNode;
+		}
+		case eNodeKind::And:
+		{
+			const stAnd* pAnd = static_cast<const stAnd*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::And);
+			PushExpression(pAnd->stRight, eSlot::B, nNode);
+			PushExpression(pAnd->stLeft, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::Or:
+		{
+			const stOr* pOr = static_cast<const stOr*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::Or);
+			PushExpression(pOr->stRight, eSlot::B, nNode);
+			PushExpression(pOr->stLeft, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::Relational:
+		{
+			const stRelational* pRel = static_cast<const stRelational*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::Relational, pRel->eType);
+			PushExpression(pRel->stRight, eSlot::B, nNode);
+			PushExpression(pRel->stLeft, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::Arithmetic:
+		{
+			const stArithmetic* pArith = static_cast<const stArithmetic*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::Arithmetic, pArith->eType);
+			PushExpression(pArith->stRight, eSlot::B, nNode);
+			PushExpression(pArith->stLeft, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::Unary:
+		{
+			const stUnary* pUn = static_cast<const stUnary*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::Unary, pUn->eType);
+			PushExpression(pUn->stSubExp, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::GetVariable:
+		{
+			NodeID nNode = AddNode(eNodeKind::GetVariable);
+			SetOperands(nNode, static_cast<const stGetVariable*>(pExp)->nSymbol);
+			return nNode;
+		}
+		case eNodeKind::SetVariable:
+		{
+			const stSetVariable* pSetVar = static_cast<const stSetVariable*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::SetVariable);
+			SetOperands(nNode, pSetVar->nSymbol);
+			PushExpression(pSetVar->stInitExp, eSlot::B, nNode);
+			return nNode;
+		}
+		case eNodeKind::GetElement:
+		{
+			const stGetElement* pGetElem = static_cast<const stGetElement*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::GetElement);
+			PushExpression(pGetElem->stIndexExp, eSlot::B, nNode);
+			PushExpression(pGetElem->stMemsExp, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::SetElement:
+		{
+			const stSetElement* pSetElem = static_cast<const stSetElement*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::SetElement);
+			PushExpression(pSetElem->stInitExp, eSlot::C, nNode);
+			PushExpression(pSetElem->stIndexExp, eSlot::B, nNode);
+			PushExpression(pSetElem->stMemsExp, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::CallFunc:
+		{
+			const stCallFunc* pCall = static_cast<const stCallFunc*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::CallFunc);
+			SetOperands(nNode, INVALID_NODE, AddExpressionList(pCall->vArgsExp));
+			PushExpression(pCall->stSubExp, eSlot::A, nNode);
+			return nNode;
+		}
+		case eNodeKind::Convert:
+		{
+			const stConvert* pConv = static_cast<const stConvert*>(pExp);
+			NodeID nNode = AddNode(eNodeKind::Convert);
+			m_vOp[nNode] = static_cast<unsigned char>(pConv->eValType);
+			PushExpression(pConv->stSubExp, eSlot::A, nNode);
+			return nNode;
+		}
+		default:
+			return INVALID_NODE;
+	}
+}
+
+/**
+@brief		Point the accessors at the vectors
+@return
+*/
+void CFlatAST::BindVectors()
+{
+	m_pKind = m_vKind.data();
+	m_pOp = m_vOp.data();
+	m_pA = m_vA.data();
+	m_pB = m_vB.data();
+	m_pC = m_vC.data();
+	m_pOffset = m_vOffset.data();
+	m_pList = m_vList.data();
+	m_pString = m_vString.data();
+	m_nNodes = m_vKind.size();
+	m_nListSize = m_vList.size();
+	m_nStringSize = m_vString.size();
+}
+
+/**
+@brief		Make the statement of a node (its children are pushed as tasks)
+@param		arena		Arena of the program
+@param		nNode		Node
+@param		vTask		Nodes that are not made yet
+@return		Statement
+*/
+stStatement* CFlatAST::NewStatement(CArena& arena, NodeID nNode, std::vector<stRebuildTask>& vTask) const
+{
+	switch (Kind(nNode))
+	{
+		case eNodeKind::Function:
+		{
+			stFunction* pFunc = NewNode<stFunction>(arena, nNode);
+			stList listParam = List(B(nNode));
+
+			pFunc->eType = Op(nNode);
+			pFunc->nSymbol = A(nNode);
+			pFunc->vParams.assign(listParam.begin(), listParam.end());
+			pFunc->vParamTypes.resize(listParam.nCount);
+			for (unsigned int i = 0; i < listParam.nCount; ++i)
+				pFunc->vParamTypes[i] = static_cast<CLexer::eLexEnum>(listParam.pItem[listParam.nCount + i]);
+			NewBlock(C(nNode), pFunc->vBlock, vTask);
+			return pFunc;
+		}
+		case eNodeKind::Variable:
+		{
+			stVariable* pVar = NewNode<stVariable>(arena, nNode);
+			pVar->eType = Op(nNode);
+			pVar->nSymbol = A(nNode);
+			if (B(nNode) != INVALID_NODE)
+				vTask.push_back(stRebuildTask{ B(nNode), nullptr, &pVar->stExp });
+			return pVar;
+		}
+		case eNodeKind::ExpStatement:
+		{
+			stExpStatement* pExpState = NewNode<stExpStatement>(arena, nNode);
+			if (A(nNode) != INVALID_NODE)
+				vTask.push_back(stRebuildTask{ A(nNode), nullptr, &pExpState->stExp });
+			return pExpState;
+		}
+		case eNodeKind::Return:
+		{
+			stReturn* pReturn = NewNode<stReturn>(arena, nNode);
+			if (A(nNode) != INVALID_NODE)
+				vTask.push_back(stRebuildTask{ A(nNode), nullptr, &pReturn->stExp });
+			return pReturn;
+		}
+		case eNodeKind::For:
+		{
+			stFor* pFor = NewNode<stFor>(arena, nNode);
+			stList listHeader = List(B(nNode));
+
+			if (A(nNode) != INVALID_NODE)
+				pFor->stVar = static_cast<stVariable*>(NewStatement(arena, A(nNode), vTask));
+			if (listHeader[0] != INVALID_NODE)
+				vTask.push_back(stRebuildTask{ listHeader[0], nullptr, &pFor->stCondExp });
+			if (listHeader[1] != INVALID_NODE)
+				vTask.push_back(stRebuildTask{ listHeader[1], nullptr, &pFor->stLoopExp });
+			NewBlock(C(nNode), pFor->stBlock, vTask);
+			return pFor;
+		}
+		case eNodeKind::While:
+		{
+			stWhile* pWhile = NewNode<stWhile>(arena, nNode);
+			if (A(nNode) != INVALID_NODE)
+				vTask.push_back(stRebuildTask{ A(nNode), nullptr, &pWhile->stCondExp });
+			NewBlock(B(nNode), pWhile->stBlock, vTask);
+			return pWhile;
+		}
+		case eNodeKind::If:
+		{
+			stIf* pIf = NewNode<stIf>(arena, nNode);
+			stList listBlocks = List(B(nNode));
+
+			NewExpressionList(A(nNode), pIf->stCondStm, vTask);
+			pIf->vIfBlock.resize(listBlocks.nCount);
+			for (unsigned int i = 0; i < listBlocks.nCount; ++i)
+				NewBlock(listBlocks[i], pIf->vIfBlock[i], vTask);
+			NewBlock(C(nNode), pIf->vElseBlock, vTask);
+			return pIf;
+		}
+		case eNodeKind::Switch:
+		{
+			stSwitch* pSwitch = NewNode<stSwitch>(arena, nNode);
+			stList listConds = List(B(nNode));
+			stList listBlocks = List(C(nNode));
+
+			if (A(nNode) != INVALID_NODE)
+				vTask.push_back(stRebuildTask{ A(nNode), nullptr, &pSwitch->stExp });
+
+			// The arm without a condition is the default
+			for (unsigned int i = 0; i < listConds.nCount; ++i)
+			{
+				if (listConds[i] == INVALID_NODE)
+					pSwitch->nDefaultIdx = (int)i;
+			}
+
+			unsigned int nCases = listConds.nCount - (pSwitch->nDefaultIdx == -1 ? 0 : 1);
+			pSwitch->stCondStm.resize(nCases, nullptr);
+			pSwitch->vCaseBlock.resize(nCases);
+			for (unsigned int i = 0, nCase = 0; i < listBlocks.nCount; ++i)
+			{
+				if ((int)i == pSwitch->nDefaultIdx)
+				{
+					NewBlock(listBlocks[i], pSwitch->vDefaultBlock, vTask);
+					continue;
+				}
+
+				vTask.push_back(stRebuildTask{ listConds[i], nullptr, &pSwitch->stCondStm[nCase] });
+				NewBlock(listBlocks[i], pSwitch->vCaseBlock[nCase], vTask);
+				++nCase;
+			}
+			return pSwitch;
+		}
+		case eNodeKind::Break:
+			return NewNode<stBreak>(arena, nNode);
+		case eNodeKind::Continue:
+			return NewNode<stContinue>(arena, nNode);
+		case eNodeKind::Print:
+		{
+			stPrint* pPrint = NewNode<stPrint>(arena, nNode);
+			pPrint->strFormat = arena.CopyString(String(A(nNode), B(nNode)));
+			NewExpressionList(C(nNode), pPrint->stArgs, vTask);
+			return pPrint;
+		}
+		default:
+			return nullptr;
+	}
+}
+
+/**
+@brief		Make the expression of a node (its children are pushed as tasks)
+@param		arena		Arena of the program
+@param		nNode		Node
+@param		vTask		Nodes that are not made yet
+@return		Expression
+*/
+stExpression* CFlatAST::NewExpression(CArena& arena, NodeID nNode, std::vector<stRebuildTask>& vTask) const
+{
+	// Pushes an operand that is a child node
+	auto PushChild = [&vTask](unsigned int nChild, stExpression** ppExp) {
+		if (nChild != INVALID_NODE)
+			vTask.push_back(stRebuildTask{ nChild, nullptr, ppExp });
+	};
+
+	switch (Kind(nNode))
+	{
+		case eNodeKind::NullData:
+			return NewNode<stNullData>(arena, nNode);
+		case eNodeKind::VoidData:
+			return NewNode<stVoidData>(arena, nNode);
+		case eNodeKind::BoolData:
+		{
+			stBoolData* pBool = NewNode<stBoolData>(arena, nNode);
+			pBool->bData = A(nNode) != 0;
+			return pBool;
+		}
+		case eNodeKind::IntData:
+		{
+			stIntData* pInt = NewNode<stIntData>(arena, nNode);
+			pInt->nData = Int(nNode);
+			return pInt;
+		}
+		case eNodeKind::DoubleData:
+		{
+			stDoubleData* pDouble = NewNode<stDoubleData>(arena, nNode);
+			pDouble->dData = Double(nNode);
+			return pDouble;
+		}
+		case eNodeKind::StringData:
+		{
+			stStringData* pString = NewNode<stStringData>(arena, nNode);
+			pString->strData = arena.CopyString(String(A(nNode), B(nNode)));
+			return pString;
+		}
+		case eNodeKind::Array:
+			return NewNode<stArray>(arena, nNode, (int)A(nNode));
+		case eNodeKind::And:
+		{
+			stAnd* pAnd = NewNode<stAnd>(arena, nNode);
+			PushChild(A(nNode), &pAnd->stLeft);
+			PushChild(B(nNode), &pAnd->stRight);
+			return pAnd;
+		}
+		case eNodeKind::Or:
+		{
+			stOr* pOr = NewNode<stOr>(arena, nNode);
+			PushChild(A(nNode), &pOr->stLeft);
+			PushChild(B(nNode), &pOr->stRight);
+			return pOr;
+		}
+		case eNodeKind::Relational:
+		{
+			stRelational* pRel = NewNode<stRelational>(arena, nNode);
+			pRel->eType = Op(nNode);
+			PushChild(A(nNode), &pRel->stLeft);
+			PushChild(B(nNode), &pRel->stRight);
+			return pRel;
+		}
+		case eNodeKind::Arithmetic:
+		{
+			stArithmetic* pArith = NewNode<stArithmetic>(arena, nNode);
+			pArith->eType = Op(nNode);
+			PushChild(A(nNode), &pArith->stLeft);
+			PushChild(B(nNode), &pArith->stRight);
+			return pArith;
+		}
+		case eNodeKind::Unary:
+		{
+			stUnary* pUn = NewNode<stUnary>(arena, nNode);
+			pUn->eType = Op(nNode);
+			PushChild(A(nNode), &pUn->stSubExp);
+			return pUn;
+		}
+		case eNodeKind::GetVariable:
+		{
+			stGetVariable* pGetVar = NewNode<stGetVariable>(arena, nNode);
+			pGetVar->nSymbol = A(nNode);
+			return pGetVar;
+		}
+		case eNodeKind::SetVariable:
+		{
+			stSetVariable* pSetVar = NewNode<stSetVariable>(arena, nNode);
+			pSetVar->nSymbol = A(nNode);
+			PushChild(B(nNode), &pSetVar->stInitExp);
+			return pSetVar;
+		}
+		case eNodeKind::GetElement:
+		{
+			stGetElement* pGetElem = NewNode<stGetElement>(arena, nNode);
+			PushChild(A(nNode), &pGetElem->stMemsExp);
+			PushChild(B(nNode), &pGetElem->stIndexExp);
+			return pGetElem;
+		}
+		case eNodeKind::SetElement:
+		{
+			stSetElement* pSetElem = NewNode<stSetElement>(arena, nNode);
+			PushChild(A(nNode), &pSetElem->stMemsExp);
+			PushChild(B(nNode), &pSetElem->stIndexExp);
+			PushChild(C(nNode), &pSetElem->stInitExp);
+			return pSetElem;
+		}
+		case eNodeKind::CallFunc:
+		{
+			stCallFunc* pCall = NewNode<stCallFunc>(arena, nNode);
+			PushChild(A(nNode), &pCall->stSubExp);
+			NewExpressionList(B(nNode), pCall->vArgsExp, vTask);
+			return pCall;
+		}
+		case eNodeKind::Convert:
+		{
+			stConvert* pConv = NewNode<stConvert>(arena, nNode);
+			pConv->eValType = static_cast<eValueType>(m_pOp[nNode]);
+			PushChild(A(nNode), &pConv->stSubExp);
+			return pConv;
+		}
+		default:
+			return nullptr;
+	}
+}
+
+/**
+@brief		Size a block and push its statements as tasks
+@param		nList		List of the statements
+@param		vBlock		(out) Block (not resized again, so the task slots stay valid)
+@param		vTask		Nodes that are not made yet
+@return
+*/
+void CFlatAST::NewBlock(unsigned int nList, vstStatement& vBlock, std::vector<stRebuildTask>& vTask) const
+{
+	stList listState = List(nList);
+
+	vBlock.resize(listState.nCount, nullptr);
+	for (unsigned int i = 0; i < listState.nCount; ++i)
+		vTask.push_back(stRebuildTask{ listState[i], &vBlock[i], nullptr });
+}
+
+/**
+@brief		Size an expression list and push its expressions as tasks
+@param		nList		List of the expressions
+@param		vExp		(out) Expressions
+@param		vTask		Nodes that are not made yet
+@return
+*/
+void CFlatAST::NewExpressionList(unsigned int nList, vstExpression& vExp, std::vector<stRebuildTask>& vTask) const
+{
+	stList listExp = List(nList);
+
+	vExp.resize(listExp.nCount, nullptr);
+	for (unsigned int i = 0; i < listExp.nCount; ++i)
+		vTask.push_back(stRebuildTask{ listExp[i], nullptr, &vExp[i] });
+}
\ No newline at end of file
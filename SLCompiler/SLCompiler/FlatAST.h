@@ -0,0 +1,308 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "SourceFile.h"
+#include "Structures.h"
+
+// Node handle (index into a CFlatAST)
+typedef unsigned int NodeID;
+
+// Flat AST (struct-of-arrays)
+// Every node is a kind byte, an operator/type byte, three 32-bit operands and a source
+// offset, each in its own contiguous array. Children are NodeIDs. Child lists live in one list pool as
+// [count, item...], and strings live in one string pool, so the whole AST is a handful
+// of flat arrays that can be walked linearly and written out as they are.
+// Nodes are numbered in pre-order (a parent comes before its children). Build() walks the
+// tree with an explicit stack, so any nesting depth the parser accepts can be flattened.
+// Save() writes the arrays to a file as they are, and Load() maps the file and points the
+// arrays into the mapping (see stFileHeader), so a loaded AST is used without deserialization.
+// ToProgram() rebuilds the node tree when a pass needs a stProgram.
+//
+// Operands by kind (missing children and unused operands are INVALID_NODE, EMPTY_LIST is the empty list):
+//   Function		Op = return type, A = symbol, B = parameter list (symbols, then their types past the count), C = block list
+//   Variable		Op = type, A = symbol, B = init expression
+//   ExpStatement	A = expression
+//   Return			A = expression
+//   For			A = variable, B = list [condition, loop expression], C = block list
+//   While			A = condition, B = block list
+//   If				A = condition list, B = list of block lists, C = else block list
+//   Switch			A = expression, B = case condition list, C = list of block lists (in source order; the default has INVALID_NODE as its condition)
+//   Print			A = string offset, B = string length, C = argument list
+//   BoolData		A = 0 or 1
+//   IntData		A = value
+//   DoubleData		A = low 32 bits, B = high 32 bits
+//   StringData		A = string offset, B = string length
+//   Array			A = size
+//   And, Or		A = left, B = right
+//   Relational, Arithmetic		Op = operator, A = left, B = right
+//   Unary			Op = operator, A = sub expression
+//   GetVariable	A = symbol
+//   SetVariable	A = symbol, B = init expression
+//   GetElement		A = container, B = index
+//   SetElement		A = container, B = index, C = init expression
+//   CallFunc		A = callee, B = argument list
+//   Convert		Op = target type (eValueType), A = sub expression
+//   Break, Continue, NullData, VoidData		(no operands)
+class CFlatAST
+{
+// Enums and Classes, Structures ==========================================================
+public:
+	// Child list view
+	struct stList
+	{
+	public:
+		const unsigned int* pItem;
+		unsigned int nCount;
+
+		inline const unsigned int* begin() const
+		{
+			return pItem;
+		}
+
+		inline const unsigned int* end() const
+		{
+			return pItem + nCount;
+		}
+
+		inline unsigned int operator[](unsigned int nIdx) const
+		{
+			return pItem[nIdx];
+		}
+	};
+
+private:
+	// Operand (or list item) that receives the NodeID of a child
+	enum class eSlot : unsigned char
+	{
+		A,
+		B,
+		C,
+		List,
+	};
+
+	// Child that is not added yet (one of pState and pExp is set)
+	struct stTask
+	{
+	public:
+		const stStatement* pState;
+		const stExpression* pExp;
+		eSlot eTarget;
+		unsigned int nIndex;
+	};
+
+	// Node that ToProgram() has not made yet (one of ppState and ppExp is set)
+	struct stRebuildTask
+	{
+	public:
+		NodeID nNode;
+		stStatement** ppState;
+		stExpression** ppExp;
+	};
+
+	// File layout: the header, then the arrays A, B, C, source offset, list pool and symbol name offsets
+	// (32-bit), then kind, op, string pool, symbol names and a copy of the source (bytes).
+	// Symbol operands are written as indices into the file's own name table (first-use order);
+	// Load() interns the names and patches a copy of A and the list pool only when the global
+	// IDs differ from the indices.
+	struct stFileHeader
+	{
+	public:
+		char arrMagic[4];
+		unsigned int nVersion;
+		unsigned long long nSourceHash;
+		unsigned long long nSourceSize;
+		unsigned int nNodes;
+		unsigned int nListSize;
+		unsigned int nStringSize;
+		unsigned int nSymbols;
+		unsigned int nNameBytes;
+		unsigned int nFuncList;
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+public:
+	static constexpr NodeID INVALID_NODE = 0xFFFFFFFFu;
+	static constexpr unsigned int EMPTY_LIST = 0;
+
+private:
+	static constexpr unsigned int FILE_VERSION = 5;
+
+	// Node kinds (eNodeKind)
+	std::vector<unsigned char> m_vKind;
+	// Operator or data type (CLexer::eLexEnum)
+	std::vector<unsigned char> m_vOp;
+	// Operands
+	std::vector<unsigned int> m_vA;
+	std::vector<unsigned int> m_vB;
+	std::vector<unsigned int> m_vC;
+	// Source offsets (stStatement::nOffset, stExpression::nOffset)
+	std::vector<unsigned int> m_vOffset;
+	// List pool ([count, item...])
+	std::vector<unsigned int> m_vList;
+	// String pool
+	std::vector<char> m_vString;
+	// Function list (the root)
+	unsigned int m_nFuncList;
+	// Children that are waiting to be added (last in, first out)
+	std::vector<stTask> m_vTask;
+	// Arrays the accessors read (the vectors above, or the mapped file of Load())
+	const unsigned char* m_pKind;
+	const unsigned char* m_pOp;
+	const unsigned int* m_pA;
+	const unsigned int* m_pB;
+	const unsigned int* m_pC;
+	const unsigned int* m_pOffset;
+	const unsigned int* m_pList;
+	const char* m_pString;
+	size_t m_nNodes;
+	size_t m_nListSize;
+	size_t m_nStringSize;
+	// Mapped file of Load()
+	std::unique_ptr<CSourceFile> m_pFile;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CFlatAST();
+	CFlatAST(const CFlatAST&) = delete;
+	CFlatAST& operator=(const CFlatAST&) = delete;
+
+	void Build(const stProgram& prog);
+	void Clear();
+	size_t GetBytes() const;
+
+	bool Save(const std::string& strPath, unsigned long long nSourceHash, std::string_view strSource) const;
+	bool Load(const std::string& strPath, unsigned long long nSourceHash, std::string_view strSource);
+	void ToProgram(stProgram& prog) const;
+
+	// Node count
+	inline size_t Size() const
+	{
+		return m_nNodes;
+	}
+
+	inline const unsigned char* KindData() const
+	{
+		return m_pKind;
+	}
+
+	// Whether the arrays are read from a mapped file as they are
+	inline bool IsMapped() const
+	{
+		return m_pFile != nullptr &&
+			   m_pFile->IsMapped() &&
+			   m_pA != m_vA.data();
+	}
+
+	inline eNodeKind Kind(NodeID nNode) const
+	{
+		return static_cast<eNodeKind>(m_pKind[nNode]);
+	}
+
+	inline CLexer::eLexEnum Op(NodeID nNode) const
+	{
+		return static_cast<CLexer::eLexEnum>(m_pOp[nNode]);
+	}
+
+	inline unsigned int A(NodeID nNode) const
+	{
+		return m_pA[nNode];
+	}
+
+	inline unsigned int B(NodeID nNode) const
+	{
+		return m_pB[nNode];
+	}
+
+	inline unsigned int C(NodeID nNode) const
+	{
+		return m_pC[nNode];
+	}
+
+	inline unsigned int Offset(NodeID nNode) const
+	{
+		return m_pOffset[nNode];
+	}
+
+	inline stList List(unsigned int nList) const
+	{
+		return stList{ m_pList + nList + 1, m_pList[nList] };
+	}
+
+	inline stList Functions() const
+	{
+		return List(m_nFuncList);
+	}
+
+	inline std::string_view String(unsigned int nOffset, unsigned int nLength) const
+	{
+		return std::string_view(m_pString + nOffset, nLength);
+	}
+
+	inline int Int(NodeID nNode) const
+	{
+		return (int)m_pA[nNode];
+	}
+
+	double Double(NodeID nNode) const;
+
+private:
+	NodeID AddNode(eNodeKind eKind, CLexer::eLexEnum eOp = CLexer::eLexEnum::Unknown);
+	unsigned int AddList(size_t nCount);
+	unsigned int AddBlock(const vstStatement& vBlock);
+	unsigned int AddExpressionList(const vstExpression& vExp);
+	unsigned int AddString(std::string_view strString);
+	NodeID AddStatement(const stStatement* pState);
+	NodeID AddExpression(const stExpression* pExp);
+	void SetSlot(const stTask& stChild, NodeID nNode);
+	void BindVectors();
+	stStatement* NewStatement(CArena& arena, NodeID nNode, std::vector<stRebuildTask>& vTask) const;
+	stExpression* NewExpression(CArena& arena, NodeID nNode, std::vector<stRebuildTask>& vTask) const;
+	void NewBlock(unsigned int nList, vstStatement& vBlock, std::vector<stRebuildTask>& vTask) const;
+	void NewExpressionList(unsigned int nList, vstExpression& vExp, std::vector<stRebuildTask>& vTask) const;
+
+	inline static bool IsSymbolNode(eNodeKind eKind)
+	{
+		return eKind == eNodeKind::Function ||
+			   eKind == eNodeKind::Variable ||
+			   eKind == eNodeKind::GetVariable ||
+			   eKind == eNodeKind::SetVariable;
+	}
+
+	// Node of ToProgram() with the source offset of nNode
+	template<typename T, typename... Args>
+	inline T* NewNode(CArena& arena, NodeID nNode, Args&&... args) const
+	{
+		T* pNode = arena.New<T>(std::forward<Args>(args)...);
+		pNode->nOffset = m_pOffset[nNode];
+		return pNode;
+	}
+
+	inline void PushStatement(const stStatement* pState, eSlot eTarget, unsigned int nIndex)
+	{
+		if (pState != nullptr)
+			m_vTask.push_back(stTask{ pState, nullptr, eTarget, nIndex });
+	}
+
+	inline void PushExpression(const stExpression* pExp, eSlot eTarget, unsigned int nIndex)
+	{
+		if (pExp != nullptr)
+			m_vTask.push_back(stTask{ nullptr, pExp, eTarget, nIndex });
+	}
+
+	inline void SetOperands(NodeID nNode, unsigned int nA, unsigned int nB = INVALID_NODE, unsigned int nC = INVALID_NODE)
+	{
+		m_vA[nNode] = nA;
+		m_vB[nNode] = nB;
+		m_vC[nNode] = nC;
+	}
+
+// ========================================================================================
+
+};
\ No newline at end of file
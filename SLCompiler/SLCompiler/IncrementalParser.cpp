@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <iterator>
+#include "IncrementalParser.h"
+
+// First block of a unit's arena (a function is a few KB of nodes; blocks double from here)
+static const size_t UNIT_FIRST_BLOCK_SIZE = 2 * 1024;
+
+CIncrementalParser::CIncrementalParser(CParser::eParseMode eMode)
+	: m_eMode(eMode)
+{
+	Open(std::string());
+}
+
+/**
+@brief		Parse a whole source
+@param		strSource		Source code
+@return
+*/
+void CIncrementalParser::Open(std::string strSource)
+{
+	m_strSource = std::move(strSource);
+	m_stStats = stEditStats();
+
+	ParseWindow(0, m_strSource.size(), true, m_vUnit);
+}
+
+/**
+@brief		Apply an edit and re-parse the units it touches
+@param		nOffset			Start of the replaced range
+@param		nRemove			Length of the replaced range
+@param		strInsert		Text put in its place
+@return		false if the range is out of the source (nothing is changed)
+@details	The window starts at the unit of nOffset and ends at the end of the unit of the
+			last replaced charactor. If the new text does not close its last function there
+			(e.g. a "}" was removed or a string literal was opened), the window takes in the
+			next units, twice as many each time, up to the end of the source.
+*/
+bool CIncrementalParser::Edit(size_t nOffset, size_t nRemove, std::string_view strInsert)
+{
+	if (nOffset > m_strSource.size() ||
+		nRemove > m_strSource.size() - nOffset)
+		return false;
+
+	// Units are found by their old offsets
+	size_t nFirst = FindUnit(nOffset);
+	size_t nLast = FindUnit(nRemove > 0 ? nOffset + nRemove - 1 : nOffset);
+	ptrdiff_t nDelta = (ptrdiff_t)strInsert.size() - (ptrdiff_t)nRemove;
+
+	m_strSource.replace(nOffset, nRemove, strInsert.data(), strInsert.size());
+	m_stStats = stEditStats();
+
+	std::vector<stUnit> vNew;
+	size_t nGrow = 1;
+
+	for (;;)
+	{
+		bool bToEnd = nLast + 1 >= m_vUnit.size();
+		size_t nEnd = bToEnd ? m_strSource.size() : m_vUnit[nLast + 1].nOffset + nDelta;
+
+		if (ParseWindow(m_vUnit[nFirst].nOffset, nEnd, bToEnd, vNew))
+			break;
+
+		nLast = std::min(nLast + nGrow, m_vUnit.size() - 1);
+		nGrow *= 2;
+	}
+
+	for (size_t i = nLast + 1; i < m_vUnit.size(); ++i)
+		m_vUnit[i].nOffset += nDelta;
+
+	m_vUnit.erase(m_vUnit.begin() + nFirst, m_vUnit.begin() + nLast + 1);
+	m_vUnit.insert(m_vUnit.begin() + nFirst, std::make_move_iterator(vNew.begin()), std::make_move_iterator(vNew.end()));
+	m_stStats.nReusedUnits = m_vUnit.size() - vNew.size();
+
+	return true;
+}
+
+/**
+@brief		Functions of the source (in source order)
+@param		vFunc		(out) Functions (valid until the next Open() or an Edit() of their unit)
+@return
+*/
+void CIncrementalParser::GetFunctions(std::vector<stFunction*>& vFunc) const
+{
+	vFunc.clear();
+	for (const stUnit& stUnitData : m_vUnit)
+		vFunc.insert(vFunc.end(), stUnitData.stChunkData.vFunc.begin(), stUnitData.stChunkData.vFunc.end());
+}
+
+/**
+@brief		Diagnostics of the source (lexer and parser, offsets from the start of the source)
+@param		diag		(out) Diagnostics (appended)
+@return
+*/
+void CIncrementalParser::GetDiagnostics(CDiagnostics& diag) const
+{
+	for (const stUnit& stUnitData : m_vUnit)
+	{
+		for (const stDiagnostic& stDiag : stUnitData.diag.Get())
+			diag.Add(stDiag.eLv, stUnitData.nOffset + stDiag.nOffset, stDiag.strMessage);
+	}
+}
+
+/**
+@brief		Node count (same as stProgram::nNodeCount of a full parse)
+@return		Node count
+*/
+size_t CIncrementalParser::GetNodeCount() const
+{
+	size_t nNodeCount = 1;
+
+	for (const stUnit& stUnitData : m_vUnit)
+		nNodeCount += stUnitData.stChunkData.nNodeCount;
+
+	return nNodeCount;
+}
+
+/**
+@brief		Find the unit of a source offset
+@param		nOffset		Source offset
+@return		Unit index
+*/
+size_t CIncrementalParser::FindUnit(size_t nOffset) const
+{
+	std::vector<stUnit>::const_iterator iter = std::upper_bound(m_vUnit.begin(), m_vUnit.end(), nOffset,
+		[](size_t nValue, const stUnit& stUnitData) {
+			return nValue < stUnitData.nOffset;
+		});
+
+	return iter == m_vUnit.begin() ? 0 : (size_t)(iter - m_vUnit.begin()) - 1;
+}
+
+/**
+@brief		Lex and parse a window of the source into units
+@param		nBegin		Start of the window (a unit boundary)
+@param		nEnd		End of the window
+@param		bToEnd		Whether the window ends at the end of the source
+@param		vNew		(out) Units of the window
+@return		false if the window does not end after a function (and is not the end of the source)
+*/
+bool CIncrementalParser::ParseWindow(size_t nBegin, size_t nEnd, bool bToEnd, std::vector<stUnit>& vNew)
+{
+	CDiagnostics diagLex;
+
+	// The lexer reads a '\0' terminated source
+	m_strWindow.assign(m_strSource, nBegin, nEnd - nBegin);
+	CLexer::Scan(m_strWindow, m_tokens, &diagLex);
+
+	m_stStats.nLexedBytes += m_strWindow.size();
+	m_stStats.nTokens += m_tokens.Size() - 1;
+
+	// A unit ends at the "}" that brings the brace depth back to 0
+	const unsigned char* pKind = m_tokens.KindData();
+	size_t nTokens = m_tokens.Size() - 1;
+	size_t nDepth = 0;
+	size_t nClosed = 0;
+
+	m_vBoundary.clear();
+	m_vBoundary.push_back(0);
+
+	for (size_t i = 0; i < nTokens; ++i)
+	{
+		CLexer::eLexEnum eLex = static_cast<CLexer::eLexEnum>(pKind[i]);
+
+		if (eLex == CLexer::eLexEnum::LeftBrace)
+		{
+			++nDepth;
+		}
+		else if (eLex == CLexer::eLexEnum::RightBrace &&
+				 nDepth > 0 &&
+				 --nDepth == 0)
+		{
+			nClosed = i + 1;
+			if (nClosed < nTokens)
+				m_vBoundary.push_back(nClosed);
+		}
+	}
+
+	// The text after the window could still belong to the last function
+	if (bToEnd == false &&
+		nClosed != nTokens)
+		return false;
+
+	m_vBoundary.push_back(nTokens);
+
+	vNew.clear();
+	vNew.resize(m_vBoundary.size() - 1);
+
+	size_t nLexDiag = 0;
+
+	for (size_t i = 0; i < vNew.size(); ++i)
+	{
+		stUnit& stUnitData = vNew[i];
+		// Units start after the "}" of the previous one
+		size_t nStart = i == 0 ? 0 : m_tokens.Offset(m_vBoundary[i] - 1) + 1;
+		size_t nNext = i + 1 < vNew.size() ? m_tokens.Offset(m_vBoundary[i + 1] - 1) + 1 : m_strWindow.size() + 1;
+		CDiagnostics diagParse;
+
+		// Node and parser diagnostic offsets are made relative to the unit
+		stUnitData.nOffset = nBegin + nStart;
+		stUnitData.stChunkData.pArena.reset(new CArena(CArena::eMode::Block, UNIT_FIRST_BLOCK_SIZE));
+		CParser::ParseChunk(m_tokens, m_vBoundary[i], m_vBoundary[i + 1], stUnitData.stChunkData, &diagParse, m_eMode, (size_t)0 - nStart);
+
+		// Lexer diagnostics are in source order
+		const std::vector<stDiagnostic>& vLexDiag = diagLex.Get();
+		for (; nLexDiag < vLexDiag.size() && vLexDiag[nLexDiag].nOffset < nNext; ++nLexDiag)
+			stUnitData.diag.Add(vLexDiag[nLexDiag].eLv, vLexDiag[nLexDiag].nOffset - nStart, vLexDiag[nLexDiag].strMessage);
+
+		stUnitData.diag.Append(diagParse);
+	}
+
+	m_stStats.nParsedUnits += vNew.size();
+
+	return true;
+}
\ No newline at end of file
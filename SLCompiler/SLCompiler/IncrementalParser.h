@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Parser.h"
+
+// Incremental parser (editor integration)
+// The source is kept as a list of units, split after the "}" that closes each top-level
+// function (the same split as the streaming parser). Each unit has its own arena, so an
+// edit re-lexes and re-parses only the units it touches; the nodes of the other
+// functions are not rebuilt and do not move.
+class CIncrementalParser
+{
+// Enums and Classes, Structures ==========================================================
+public:
+	// Source range [nOffset, nOffset of the next unit) and its functions
+	struct stUnit
+	{
+	public:
+		size_t nOffset = 0;
+		// Functions (node offsets are relative to nOffset)
+		CParser::stChunk stChunkData;
+		// Diagnostics (offsets are relative to nOffset)
+		CDiagnostics diag;
+	};
+
+	// Work of the last Open() or Edit()
+	struct stEditStats
+	{
+	public:
+		size_t nLexedBytes = 0;
+		size_t nTokens = 0;
+		size_t nParsedUnits = 0;
+		size_t nReusedUnits = 0;
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	std::string m_strSource;
+	std::vector<stUnit> m_vUnit;
+	CParser::eParseMode m_eMode;
+	stEditStats m_stStats;
+	// Reused buffers of the re-lexed window
+	std::string m_strWindow;
+	CTokenBuffer m_tokens;
+	std::vector<size_t> m_vBoundary;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CIncrementalParser(CParser::eParseMode eMode = CParser::eParseMode::Auto);
+
+	void Open(std::string strSource);
+	bool Edit(size_t nOffset, size_t nRemove, std::string_view strInsert);
+
+	void GetFunctions(std::vector<stFunction*>& vFunc) const;
+	void GetDiagnostics(CDiagnostics& diag) const;
+	size_t GetNodeCount() const;
+
+	inline const std::string& Source() const
+	{
+		return m_strSource;
+	}
+
+	inline size_t GetUnitCount() const
+	{
+		return m_vUnit.size();
+	}
+
+	inline const stEditStats& GetLastEdit() const
+	{
+		return m_stStats;
+	}
+
+private:
+	size_t FindUnit(size_t nOffset) const;
+	bool ParseWindow(size_t nBegin, size_t nEnd, bool bToEnd, std::vector<stUnit>& vNew);
+
+// ========================================================================================
+
+};
\ No newline at end of file
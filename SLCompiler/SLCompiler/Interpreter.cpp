@@ -0,0 +1,989 @@
+#include <algorithm>
+#include <climits>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "Interpreter.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+/**
+@brief		Result of an int operation as a 32-bit machine gives it (wraps around, as CConstantFolder folds it)
+@param		nValue		Exact result
+@return		Result
+*/
+static int WrapInt(long long nValue)
+{
+	return (int)(unsigned int)(unsigned long long)nValue;
+}
+
+/**
+@brief		Compare two values of one type
+@param		eOp			Relational operator
+@param		left		Left side
+@param		right		Right side
+@return		Result
+*/
+template <typename T>
+static bool Compare(CLexer::eLexEnum eOp, const T& left, const T& right)
+{
+	switch (eOp)
+	{
+		case CLexer::eLexEnum::RelOpEqual:				return left == right;
+		case CLexer::eLexEnum::RelOpNotEqual:			return left != right;
+		case CLexer::eLexEnum::RelOpLessThan:			return left < right;
+		case CLexer::eLexEnum::RelOpGreaterThan:		return left > right;
+		case CLexer::eLexEnum::RelOpLessOrEqual:		return left <= right;
+		case CLexer::eLexEnum::RelOpGreaterOrEqual:		return left >= right;
+		default:										return false;
+	}
+}
+
+/**
+@brief		Append one printf conversion of a value
+@param		strOut		(in/out) Output
+@param		pSpec		Conversion (flags, width, precision and the conversion character)
+@param		data		Value
+@return
+*/
+template <typename T>
+static void AppendFormat(std::string& strOut, const char* pSpec, T data)
+{
+	int nSize = snprintf(nullptr, 0, pSpec, data);
+	if (nSize <= 0)
+		return;
+
+	size_t nLength = strOut.size();
+	strOut.resize(nLength + nSize + 1);
+	snprintf(&strOut[nLength], nSize + 1, pSpec, data);
+	strOut.resize(nLength + nSize);
+}
+
+// Function that runs on a thread of its own
+struct stThreadProc
+{
+public:
+	void (*pProc)(void*);
+	void* pArg;
+};
+
+#ifdef _WIN32
+static unsigned __stdcall ThreadEntry(void* pArg)
+{
+	stThreadProc* pThreadProc = static_cast<stThreadProc*>(pArg);
+	pThreadProc->pProc(pThreadProc->pArg);
+	return 0;
+}
+#else
+static void* ThreadEntry(void* pArg)
+{
+	stThreadProc* pThreadProc = static_cast<stThreadProc*>(pArg);
+	pThreadProc->pProc(pThreadProc->pArg);
+	return nullptr;
+}
+#endif
+
+/**
+@brief		Run a function on a new thread with a stack of the given size and wait for it
+			(std::thread cannot set the stack size)
+@param		nStackSize	Stack size
+@param		pProc		Function
+@param		pArg		Argument of the function
+@return		false if the thread could not be made (the function did not run)
+*/
+static bool RunOnStack(size_t nStackSize, void (*pProc)(void*), void* pArg)
+{
+	stThreadProc stProc{ pProc, pArg };
+
+#ifdef _WIN32
+	HANDLE hThread = reinterpret_cast<HANDLE>(_beginthreadex(nullptr, (unsigned int)nStackSize, ThreadEntry, &stProc, STACK_SIZE_PARAM_IS_A_RESERVATION, nullptr));
+	if (hThread == nullptr)
+		return false;
+
+	WaitForSingleObject(hThread, INFINITE);
+	CloseHandle(hThread);
+	return true;
+#else
+	pthread_attr_t stAttr;
+	pthread_t hThread;
+
+	if (pthread_attr_init(&stAttr) != 0)
+		return false;
+
+	bool bRun = pthread_attr_setstacksize(&stAttr, nStackSize) == 0 &&
+				pthread_create(&hThread, &stAttr, ThreadEntry, &stProc) == 0;
+	pthread_attr_destroy(&stAttr);
+
+	if (bRun)
+		pthread_join(hThread, nullptr);
+	return bRun;
+#endif
+}
+
+CInterpreter::CInterpreter(size_t nMaxDepth)
+	: m_pProg(nullptr), m_pDiag(nullptr), m_nBase(0), m_pOut(nullptr), m_nDepth(0), m_nCalls(0), m_nMaxDepth(nMaxDepth), m_nOps(0), m_bFault(false)
+{
+}
+
+/**
+@brief		Run main of a program
+@param		prog		Program (resolved and type checked without errors)
+@param		valResult	(out) Return value of main (Void if it returns nothing)
+@param		pDiag		Diagnostics (nullptr: dropped)
+@return		false if there is no main or the program stopped at a runtime error
+*/
+bool CInterpreter::Run(const stProgram& prog, stValue& valResult, CDiagnostics* pDiag)
+{
+	CDiagnostics diagLocal;
+	m_pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+	m_pProg = &prog;
+	m_vStack.clear();
+	m_mapLiteral.clear();
+	m_nBase = 0;
+	m_nDepth = 0;
+	m_nCalls = 0;
+	m_nOps = 0;
+	m_bFault = false;
+	valResult = stValue();
+
+	SymbolID nMain = CSymbolTable::Global().Find("main");
+	const stFunction* pMain = nullptr;
+	for (const stFunction* pFunc : prog.vFunc)
+	{
+		if (nMain != CSymbolTable::INVALID_SYMBOL &&
+			pFunc->nSymbol == nMain)
+		{
+			pMain = pFunc;
+			break;
+		}
+	}
+
+	if (pMain == nullptr)
+		Fault(0, "Program has no main function.");
+	else if (pMain->vParams.empty() == false)
+		Fault(pMain->nOffset, "Function 'main' cannot take parameters.");
+	else
+		RunMain(pMain, valResult);
+
+	bool bRun = m_bFault == false;
+	// The literals are keyed by node address, so they must not outlive the program
+	m_vStack.clear();
+	m_mapLiteral.clear();
+	m_valReturn = stValue();
+	m_pDiag = nullptr;
+	m_pProg = nullptr;
+
+	return bRun;
+}
+
+/**
+@brief		Call main on a thread with a STACK_SIZE stack
+@param		pMain		Function main
+@param		valResult	(out) Return value of main
+@return
+*/
+void CInterpreter::RunMain(const stFunction* pMain, stValue& valResult)
+{
+	struct stMain
+	{
+	public:
+		CInterpreter* pThis;
+		const stFunction* pMain;
+		stValue* pResult;
+	};
+
+	stMain stArg{ this, pMain, &valResult };
+	bool bThread = RunOnStack(STACK_SIZE, [](void* pArg) {
+		stMain* pArgMain = static_cast<stMain*>(pArg);
+		*pArgMain->pResult = pArgMain->pThis->Call(pArgMain->pMain, vstExpression(), pArgMain->pMain->nOffset);
+	}, &stArg);
+
+	if (bThread == false)
+		Fault(pMain->nOffset, "Cannot make the thread that runs the program.");
+}
+
+/**
+@brief		Call a function
+@param		pFunc		Function
+@param		vArgs		Arguments (run in the frame of the caller)
+@param		nOffset		Source offset of the call (for the runtime errors)
+@return		Return value (Void if it returns nothing)
+*/
+stValue CInterpreter::Call(const stFunction* pFunc, const vstExpression& vArgs, size_t nOffset)
+{
+	if (vArgs.size() != pFunc->vParams.size())
+	{
+		std::string_view strName = CSymbolTable::Global().GetName(pFunc->nSymbol);
+		Fault(nOffset, "Function '%.*s' takes %zu arguments, not %zu.", (int)strName.size(), strName.data(), pFunc->vParams.size(), vArgs.size());
+		return stValue();
+	}
+	if (m_nCalls >= m_nMaxDepth)
+	{
+		Fault(nOffset, "Stack overflow (calls nest deeper than %zu).", m_nMaxDepth);
+		return stValue();
+	}
+
+	// The arguments are the first slots of the new frame (a call in an argument makes its frame
+	// above them and takes it down before the next argument)
+	size_t nBase = m_vStack.size();
+	for (const stExpression* pArg : vArgs)
+	{
+		stValue val = Eval(pArg);
+		m_vStack.push_back(std::move(val));
+	}
+
+	if (m_bFault)
+	{
+		m_vStack.resize(nBase);
+		return stValue();
+	}
+
+	m_vStack.resize(nBase + std::max<size_t>(pFunc->nFrameSize, vArgs.size()));
+	size_t nCallerBase = m_nBase;
+	m_nBase = nBase;
+	++m_nCalls;
+
+	stValue valResult;
+	if (ExecBlock(pFunc->vBlock) == eFlow::Return)
+		valResult = std::move(m_valReturn);
+
+	--m_nCalls;
+	m_nBase = nCallerBase;
+	m_vStack.resize(nBase);
+
+	return valResult;
+}
+
+/**
+@brief		Run the statements of a block
+@param		vBlock		Block
+@return		How control left the block
+*/
+CInterpreter::eFlow CInterpreter::ExecBlock(const vstStatement& vBlock)
+{
+	for (const stStatement* pState : vBlock)
+	{
+		eFlow eResult = Exec(pState);
+		if (eResult != eFlow::Normal)
+			return eResult;
+	}
+
+	return eFlow::Normal;
+}
+
+/**
+@brief		Run a statement
+@param		pState		Statement
+@return		How control left the statement
+*/
+CInterpreter::eFlow CInterpreter::Exec(const stStatement* pState)
+{
+	++m_nOps;
+	if (++m_nDepth > MAX_NESTING)
+	{
+		--m_nDepth;
+		Fault(pState->nOffset, "Stack overflow (statements and expressions nest deeper than %zu).", MAX_NESTING);
+		return eFlow::Fault;
+	}
+
+	eFlow eResult = eFlow::Normal;
+	switch (pState->eKind)
+	{
+		case eNodeKind::Variable:
+		{
+			// A variable without an initializer starts at the zero of its type
+			const stVariable* pVar = static_cast<const stVariable*>(pState);
+			stValue val;
+
+			if (pVar->stExp != nullptr)
+				val = Eval(pVar->stExp);
+			else if (pVar->eType == CLexer::eLexEnum::Double)
+				val = stValue::Double(0.0);
+			else if (pVar->eType == CLexer::eLexEnum::String)
+				val = stValue::String(std::string());
+			else
+				val = stValue::Int(0);
+
+			Slot(pVar->nSlot) = std::move(val);
+			break;
+		}
+		case eNodeKind::ExpStatement:
+		{
+			const stExpStatement* pExpState = static_cast<const stExpStatement*>(pState);
+			if (pExpState->stExp != nullptr)
+				Eval(pExpState->stExp);
+			break;
+		}
+		case eNodeKind::Return:
+		{
+			const stReturn* pReturn = static_cast<const stReturn*>(pState);
+			m_valReturn = pReturn->stExp != nullptr ? Eval(pReturn->stExp) : stValue();
+			eResult = eFlow::Return;
+			break;
+		}
+		case eNodeKind::For:
+			eResult = ExecFor(static_cast<const stFor*>(pState));
+			break;
+		case eNodeKind::While:
+			eResult = ExecWhile(static_cast<const stWhile*>(pState));
+			break;
+		case eNodeKind::If:
+		{
+			const stIf* pIf = static_cast<const stIf*>(pState);
+			size_t nArm = 0;
+
+			while (nArm < pIf->stCondStm.size() &&
+				   Truth(pIf->stCondStm[nArm]) == false &&
+				   m_bFault == false)
+				++nArm;
+
+			if (m_bFault == false)
+				eResult = ExecBlock(nArm < pIf->vIfBlock.size() ? pIf->vIfBlock[nArm] : pIf->vElseBlock);
+			break;
+		}
+		case eNodeKind::Switch:
+			eResult = ExecSwitch(static_cast<const stSwitch*>(pState));
+			break;
+		case eNodeKind::Break:
+			eResult = eFlow::Break;
+			break;
+		case eNodeKind::Continue:
+			eResult = eFlow::Continue;
+			break;
+		case eNodeKind::Print:
+			ExecPrint(static_cast<const stPrint*>(pState));
+			break;
+		default:
+			break;
+	}
+
+	--m_nDepth;
+	return m_bFault ? eFlow::Fault : eResult;
+}
+
+/**
+@brief		Run a for statement
+@param		pFor		For statement
+@return		How control left the loop (Normal after a break)
+*/
+CInterpreter::eFlow CInterpreter::ExecFor(const stFor* pFor)
+{
+	if (pFor->stVar != nullptr &&
+		Exec(pFor->stVar) == eFlow::Fault)
+		return eFlow::Fault;
+
+	while (pFor->stCondExp == nullptr ||
+		   Truth(pFor->stCondExp))
+	{
+		if (m_bFault)
+			return eFlow::Fault;
+
+		eFlow eResult = ExecBlock(pFor->stBlock);
+		if (eResult == eFlow::Break)
+			break;
+		if (eResult == eFlow::Return ||
+			eResult == eFlow::Fault)
+			return eResult;
+
+		if (pFor->stLoopExp != nullptr)
+			Eval(pFor->stLoopExp);
+	}
+
+	return m_bFault ? eFlow::Fault : eFlow::Normal;
+}
+
+/**
+@brief		Run a while statement
+@param		pWhile		While statement
+@return		How control left the loop (Normal after a break)
+*/
+CInterpreter::eFlow CInterpreter::ExecWhile(const stWhile* pWhile)
+{
+	while (Truth(pWhile->stCondExp))
+	{
+		if (m_bFault)
+			return eFlow::Fault;
+
+		eFlow eResult = ExecBlock(pWhile->stBlock);
+		if (eResult == eFlow::Break)
+			break;
+		if (eResult == eFlow::Return ||
+			eResult == eFlow::Fault)
+			return eResult;
+	}
+
+	return m_bFault ? eFlow::Fault : eFlow::Normal;
+}
+
+/**
+@brief		Run a switch statement (from the matching case, or the default if none matches, through
+			the labels that follow it in the source, until a break)
+@param		pSwitch		Switch statement
+@return		How control left the switch (Normal after a break; a continue goes to the enclosing loop)
+*/
+CInterpreter::eFlow CInterpreter::ExecSwitch(const stSwitch* pSwitch)
+{
+	stValue valSwitch = Eval(pSwitch->stExp);
+	size_t nCase = 0;
+
+	for (; nCase < pSwitch->stCondStm.size() && m_bFault == false; ++nCase)
+	{
+		if (IsEqual(valSwitch, Eval(pSwitch->stCondStm[nCase])))
+			break;
+	}
+
+	if (m_bFault)
+		return eFlow::Fault;
+
+	// Arms in source order: the default comes right before the case at nDefaultIdx
+	size_t nDefault = pSwitch->nDefaultIdx == -1 ? SIZE_MAX : (size_t)pSwitch->nDefaultIdx;
+	size_t nArms = pSwitch->vCaseBlock.size() + (nDefault == SIZE_MAX ? 0 : 1);
+	size_t nArm = nDefault;
+
+	if (nCase < pSwitch->stCondStm.size())
+		nArm = nCase >= nDefault ? nCase + 1 : nCase;
+
+	for (; nArm < nArms; ++nArm)
+	{
+		const vstStatement& vBlock = nArm == nDefault ? pSwitch->vDefaultBlock :
+			pSwitch->vCaseBlock[nArm > nDefault ? nArm - 1 : nArm];
+
+		eFlow eResult = ExecBlock(vBlock);
+		if (eResult == eFlow::Break)
+			return eFlow::Normal;
+		if (eResult != eFlow::Normal)
+			return eResult;
+	}
+
+	return eFlow::Normal;
+}
+
+/**
+@brief		Run a printf statement
+@param		pPrint		Print statement
+@return
+*/
+void CInterpreter::ExecPrint(const stPrint* pPrint)
+{
+	std::vector<stValue> vArgs;
+	vArgs.reserve(pPrint->stArgs.size());
+	for (const stExpression* pArg : pPrint->stArgs)
+		vArgs.push_back(Eval(pArg));
+
+	if (m_bFault)
+		return;
+
+	std::string_view strFormat = pPrint->strFormat;
+	std::string strOut;
+	std::string strSpec;
+	size_t nArg = 0;
+
+	for (size_t i = 0; i < strFormat.size(); ++i)
+	{
+		char ch = strFormat[i];
+
+		// String literals have no escapes, so the ones of a format are written here
+		if (ch == '\\' &&
+			i + 1 < strFormat.size())
+		{
+			char chNext = strFormat[i + 1];
+			if (chNext == 'n' || chNext == 't' || chNext == '\\')
+			{
+				strOut += chNext == 'n' ? '\n' : chNext == 't' ? '\t' : '\\';
+				++i;
+				continue;
+			}
+		}
+
+		if (ch != '%')
+		{
+			strOut += ch;
+			continue;
+		}
+
+		// Flags, width and precision are kept; length modifiers are dropped (the value sets the length)
+		strSpec.assign(1, '%');
+		++i;
+		while (i < strFormat.size() &&
+			   strchr("-+ #0123456789.", strFormat[i]) != nullptr)
+			strSpec += strFormat[i++];
+		while (i < strFormat.size() &&
+			   (strFormat[i] == 'l' || strFormat[i] == 'h'))
+			++i;
+
+		if (i >= strFormat.size())
+			break;
+
+		char chConv = strFormat[i];
+		if (chConv == '%')
+		{
+			strOut += '%';
+			continue;
+		}
+
+		if (nArg >= vArgs.size())
+		{
+			Fault(pPrint->nOffset, "printf has fewer arguments than its format.");
+			return;
+		}
+
+		const stValue& val = vArgs[nArg++];
+		strSpec += chConv;
+
+		switch (chConv)
+		{
+			case 'd':
+			case 'i':
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+			case 'c':
+			{
+				int nData = val.eType == eValueType::Int ? val.nData :
+							val.eType == eValueType::Bool ? (val.bData ? 1 : 0) :
+							val.eType == eValueType::Double ? (int)val.dData : 0;
+				AppendFormat(strOut, strSpec.c_str(), nData);
+				break;
+			}
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			{
+				double dData = val.eType == eValueType::Double ? val.dData :
+							   val.eType == eValueType::Int ? (double)val.nData : 0.0;
+				AppendFormat(strOut, strSpec.c_str(), dData);
+				break;
+			}
+			case 's':
+				AppendFormat(strOut, strSpec.c_str(), val.eType == eValueType::String ? val.pString->str.c_str() : "(null)");
+				break;
+			default:
+				Fault(pPrint->nOffset, "Unknown printf conversion '%%%c'.", chConv);
+				return;
+		}
+	}
+
+	Write(strOut.data(), strOut.size());
+}
+
+/**
+@brief		Evaluate an expression
+@param		pExp		Expression
+@return		Value (Void after a runtime error)
+*/
+stValue CInterpreter::Eval(const stExpression* pExp)
+{
+	++m_nOps;
+	if (++m_nDepth > MAX_NESTING)
+	{
+		--m_nDepth;
+		Fault(pExp->nOffset, "Stack overflow (statements and expressions nest deeper than %zu).", MAX_NESTING);
+		return stValue();
+	}
+
+	stValue valResult;
+	switch (pExp->eKind)
+	{
+		case eNodeKind::NullData:
+			valResult = stValue::Null();
+			break;
+		case eNodeKind::BoolData:
+			valResult = stValue::Bool(static_cast<const stBoolData*>(pExp)->bData);
+			break;
+		case eNodeKind::IntData:
+			valResult = stValue::Int(static_cast<const stIntData*>(pExp)->nData);
+			break;
+		case eNodeKind::DoubleData:
+			valResult = stValue::Double(static_cast<const stDoubleData*>(pExp)->dData);
+			break;
+		case eNodeKind::StringData:
+			valResult = EvalLiteral(static_cast<const stStringData*>(pExp));
+			break;
+		case eNodeKind::And:
+		{
+			const stAnd* pAnd = static_cast<const stAnd*>(pExp);
+			valResult = stValue::Bool(Truth(pAnd->stLeft) && Truth(pAnd->stRight));
+			break;
+		}
+		case eNodeKind::Or:
+		{
+			const stOr* pOr = static_cast<const stOr*>(pExp);
+			valResult = stValue::Bool(Truth(pOr->stLeft) || Truth(pOr->stRight));
+			break;
+		}
+		case eNodeKind::Relational:
+			valResult = EvalRelational(static_cast<const stRelational*>(pExp));
+			break;
+		case eNodeKind::Arithmetic:
+			valResult = EvalArithmetic(static_cast<const stArithmetic*>(pExp));
+			break;
+		case eNodeKind::Unary:
+		{
+			const stUnary* pUn = static_cast<const stUnary*>(pExp);
+			valResult = Eval(pUn->stSubExp);
+
+			if (pUn->eType != CLexer::eLexEnum::OpSubtract)
+				break;
+			if (valResult.eType == eValueType::Int)
+				valResult.nData = WrapInt(-(long long)valResult.nData);
+			else if (valResult.eType == eValueType::Double)
+				valResult.dData = -valResult.dData;
+			else if (m_bFault == false)
+				Fault(pUn->nOffset, "Operator '-' cannot be applied to '%s'.", GetValueTypeName(valResult.eType));
+			break;
+		}
+		case eNodeKind::Convert:
+			valResult = EvalConvert(static_cast<const stConvert*>(pExp));
+			break;
+		case eNodeKind::GetVariable:
+		{
+			const stGetVariable* pGetVar = static_cast<const stGetVariable*>(pExp);
+			if (pGetVar->stBind.eKind == eBindKind::Local)
+			{
+				valResult = Slot(pGetVar->stBind.nSlot);
+			}
+			else if (pGetVar->stBind.eKind == eBindKind::Function)
+			{
+				valResult.eType = eValueType::Function;
+				valResult.nData = (int)pGetVar->stBind.nSlot;
+			}
+			else
+			{
+				std::string_view strName = CSymbolTable::Global().GetName(pGetVar->nSymbol);
+				Fault(pGetVar->nOffset, "Unknown name '%.*s'.", (int)strName.size(), strName.data());
+			}
+			break;
+		}
+		case eNodeKind::SetVariable:
+		{
+			const stSetVariable* pSetVar = static_cast<const stSetVariable*>(pExp);
+			valResult = Eval(pSetVar->stInitExp);
+			if (pSetVar->stBind.eKind == eBindKind::Local)
+				Slot(pSetVar->stBind.nSlot) = valResult;
+			else if (m_bFault == false)
+			{
+				std::string_view strName = CSymbolTable::Global().GetName(pSetVar->nSymbol);
+				Fault(pSetVar->nOffset, "Cannot assign to '%.*s'.", (int)strName.size(), strName.data());
+			}
+			break;
+		}
+		case eNodeKind::GetElement:
+		{
+			// A string index is a one-character string
+			const stGetElement* pGetElem = static_cast<const stGetElement*>(pExp);
+			stValue valMems = Eval(pGetElem->stMemsExp);
+			stValue valIndex = Eval(pGetElem->stIndexExp);
+
+			if (m_bFault)
+				break;
+			if (valMems.eType != eValueType::String ||
+				valIndex.eType != eValueType::Int)
+			{
+				Fault(pGetElem->nOffset, "Type '%s' cannot be indexed.", GetValueTypeName(valMems.eType));
+				break;
+			}
+			if (valIndex.nData < 0 ||
+				(size_t)valIndex.nData >= valMems.pString->str.size())
+			{
+				Fault(pGetElem->nOffset, "String index %d is out of range.", valIndex.nData);
+				break;
+			}
+			valResult = stValue::String(std::string(1, valMems.pString->str[valIndex.nData]));
+			break;
+		}
+		case eNodeKind::CallFunc:
+			valResult = EvalCall(static_cast<const stCallFunc*>(pExp));
+			break;
+		default:
+			Fault(pExp->nOffset, "Expression cannot be run.");
+			break;
+	}
+
+	--m_nDepth;
+	return valResult;
+}
+
+/**
+@brief		Evaluate an arithmetic expression
+@param		pArith		Arithmetic expression
+@return		Value
+*/
+stValue CInterpreter::EvalArithmetic(const stArithmetic* pArith)
+{
+	stValue valLeft = Eval(pArith->stLeft);
+	stValue valRight = Eval(pArith->stRight);
+	CLexer::eLexEnum eOp = pArith->eType;
+
+	if (m_bFault)
+		return stValue();
+
+	if (valLeft.eType == eValueType::Int &&
+		valRight.eType == eValueType::Int)
+	{
+		long long nLeft = valLeft.nData;
+		long long nRight = valRight.nData;
+
+		switch (eOp)
+		{
+			case CLexer::eLexEnum::OpAdd:		return stValue::Int(WrapInt(nLeft + nRight));
+			case CLexer::eLexEnum::OpSubtract:	return stValue::Int(WrapInt(nLeft - nRight));
+			case CLexer::eLexEnum::OpMultiply:	return stValue::Int(WrapInt(nLeft * nRight));
+			default:							break;
+		}
+
+		if (nRight == 0)
+		{
+			Fault(pArith->nOffset, eOp == CLexer::eLexEnum::OpDivide ? "Integer division by zero." : "Integer modulo by zero.");
+			return stValue();
+		}
+		if (nLeft == INT_MIN &&
+			nRight == -1)
+		{
+			Fault(pArith->nOffset, "Integer division overflows.");
+			return stValue();
+		}
+		return stValue::Int((int)(eOp == CLexer::eLexEnum::OpDivide ? nLeft / nRight : nLeft % nRight));
+	}
+
+	bool bNumber = (valLeft.eType == eValueType::Int || valLeft.eType == eValueType::Double) &&
+				   (valRight.eType == eValueType::Int || valRight.eType == eValueType::Double);
+	if (bNumber &&
+		eOp != CLexer::eLexEnum::OpModulo)
+	{
+		double dLeft = valLeft.eType == eValueType::Int ? valLeft.nData : valLeft.dData;
+		double dRight = valRight.eType == eValueType::Int ? valRight.nData : valRight.dData;
+
+		switch (eOp)
+		{
+			case CLexer::eLexEnum::OpAdd:		return stValue::Double(dLeft + dRight);
+			case CLexer::eLexEnum::OpSubtract:	return stValue::Double(dLeft - dRight);
+			case CLexer::eLexEnum::OpMultiply:	return stValue::Double(dLeft * dRight);
+			default:							return stValue::Double(dLeft / dRight);
+		}
+	}
+
+	if (eOp == CLexer::eLexEnum::OpAdd &&
+		valLeft.eType == eValueType::String &&
+		valRight.eType == eValueType::String)
+	{
+		std::string str;
+		str.reserve(valLeft.pString->str.size() + valRight.pString->str.size());
+		str += valLeft.pString->str;
+		str += valRight.pString->str;
+		return stValue::String(std::move(str));
+	}
+
+	Fault(pArith->nOffset, "Operator cannot be applied to '%s' and '%s'.", GetValueTypeName(valLeft.eType), GetValueTypeName(valRight.eType));
+	return stValue();
+}
+
+/**
+@brief		Evaluate a relational expression
+@param		pRel		Relational expression
+@return		Bool value
+*/
+stValue CInterpreter::EvalRelational(const stRelational* pRel)
+{
+	stValue valLeft = Eval(pRel->stLeft);
+	stValue valRight = Eval(pRel->stRight);
+	CLexer::eLexEnum eOp = pRel->eType;
+
+	if (m_bFault)
+		return stValue();
+
+	if (valLeft.eType == eValueType::Int &&
+		valRight.eType == eValueType::Int)
+		return stValue::Bool(Compare(eOp, valLeft.nData, valRight.nData));
+
+	bool bNumber = (valLeft.eType == eValueType::Int || valLeft.eType == eValueType::Double) &&
+				   (valRight.eType == eValueType::Int || valRight.eType == eValueType::Double);
+	if (bNumber)
+	{
+		double dLeft = valLeft.eType == eValueType::Int ? valLeft.nData : valLeft.dData;
+		double dRight = valRight.eType == eValueType::Int ? valRight.nData : valRight.dData;
+		return stValue::Bool(Compare(eOp, dLeft, dRight));
+	}
+
+	if (valLeft.eType == eValueType::String &&
+		valRight.eType == eValueType::String)
+		return stValue::Bool(Compare(eOp, valLeft.pString->str, valRight.pString->str));
+
+	// Bools and null (a string variable can hold null) are only compared for equality
+	if (eOp == CLexer::eLexEnum::RelOpEqual)
+		return stValue::Bool(IsEqual(valLeft, valRight));
+	if (eOp == CLexer::eLexEnum::RelOpNotEqual)
+		return stValue::Bool(IsEqual(valLeft, valRight) == false);
+
+	Fault(pRel->nOffset, "Operator cannot compare '%s' and '%s'.", GetValueTypeName(valLeft.eType), GetValueTypeName(valRight.eType));
+	return stValue();
+}
+
+/**
+@brief		Evaluate a conversion (eValType is the target type)
+@param		pConv		Conversion
+@return		Value of the target type
+*/
+stValue CInterpreter::EvalConvert(const stConvert* pConv)
+{
+	stValue val = Eval(pConv->stSubExp);
+
+	if (m_bFault)
+		return stValue();
+
+	switch (pConv->eValType)
+	{
+		case eValueType::Double:
+			if (val.eType == eValueType::Int)
+				return stValue::Double(val.nData);
+			break;
+		case eValueType::Int:
+			if (val.eType == eValueType::Bool)
+				return stValue::Int(val.bData ? 1 : 0);
+			if (val.eType == eValueType::Double)
+			{
+				// Truncated as C does
+				if (val.dData > -2147483649.0 &&
+					val.dData < 2147483648.0)
+					return stValue::Int((int)val.dData);
+
+				Fault(pConv->nOffset, "Double is out of the int range.");
+				return stValue();
+			}
+			break;
+		case eValueType::Bool:
+			if (val.eType == eValueType::Int)
+				return stValue::Bool(val.nData != 0);
+			if (val.eType == eValueType::Double)
+				return stValue::Bool(val.dData != 0.0);
+			break;
+		default:
+			break;
+	}
+
+	return val;
+}
+
+/**
+@brief		Evaluate a call expression
+@param		pCall		Call expression
+@return		Return value
+*/
+stValue CInterpreter::EvalCall(const stCallFunc* pCall)
+{
+	stValue valCallee = Eval(pCall->stSubExp);
+
+	if (m_bFault)
+		return stValue();
+
+	if (valCallee.eType != eValueType::Function ||
+		(size_t)valCallee.nData >= m_pProg->vFunc.size())
+	{
+		Fault(pCall->nOffset, "Type '%s' cannot be called.", GetValueTypeName(valCallee.eType));
+		return stValue();
+	}
+
+	return Call(m_pProg->vFunc[valCallee.nData], pCall->vArgsExp, pCall->nOffset);
+}
+
+/**
+@brief		Value of a string literal (the string is made at its first run and shared after it)
+@param		pData		String literal
+@return		String value
+*/
+stValue CInterpreter::EvalLiteral(const stStringData* pData)
+{
+	std::unordered_map<const stStringData*, stValue>::iterator iter = m_mapLiteral.find(pData);
+
+	if (iter == m_mapLiteral.end())
+		iter = m_mapLiteral.emplace(pData, stValue::String(std::string(pData->strData))).first;
+
+	return iter->second;
+}
+
+/**
+@brief		Evaluate a condition
+@param		pExp		Condition (bool; an int is taken as C does)
+@return		Whether it holds (false after a runtime error)
+*/
+bool CInterpreter::Truth(const stExpression* pExp)
+{
+	stValue val = Eval(pExp);
+
+	if (val.eType == eValueType::Bool)
+		return val.bData;
+	if (val.eType == eValueType::Int)
+		return val.nData != 0;
+
+	if (m_bFault == false)
+		Fault(pExp->nOffset, "Condition cannot be '%s'.", GetValueTypeName(val.eType));
+	return false;
+}
+
+/**
+@brief		Whether two values are equal (switch cases, == and != of bools and null)
+@param		valLeft		Value
+@param		valRight	Value
+@return		Result
+*/
+bool CInterpreter::IsEqual(const stValue& valLeft, const stValue& valRight) const
+{
+	if (valLeft.eType != valRight.eType)
+		return false;
+
+	switch (valLeft.eType)
+	{
+		case eValueType::Bool:		return valLeft.bData == valRight.bData;
+		case eValueType::Int:
+		case eValueType::Function:	return valLeft.nData == valRight.nData;
+		case eValueType::Double:	return valLeft.dData == valRight.dData;
+		case eValueType::String:	return valLeft.pString->str == valRight.pString->str;
+		default:					return true;
+	}
+}
+
+/**
+@brief		Write printf output
+@param		pData		Text
+@param		nSize		Text size
+@return
+*/
+void CInterpreter::Write(const char* pData, size_t nSize)
+{
+	if (m_pOut != nullptr)
+		m_pOut->append(pData, nSize);
+	else
+		fwrite(pData, 1, nSize, stdout);
+}
+
+/**
+@brief		Stop the program at a runtime error (only the first one is reported)
+@param		nOffset		Source offset
+@param		pFormat		Message (printf format; the message is made here, so the recursive
+						functions that report keep small frames)
+@return
+*/
+void CInterpreter::Fault(size_t nOffset, const char* pFormat, ...)
+{
+	if (m_bFault)
+		return;
+
+	char chMessage[256];
+	va_list args;
+	va_start(args, pFormat);
+	vsnprintf(chMessage, sizeof(chMessage), pFormat, args);
+	va_end(args);
+
+	m_bFault = true;
+	m_pDiag->Error(nOffset, chMessage);
+}
\ No newline at end of file
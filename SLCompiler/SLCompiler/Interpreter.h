@@ -0,0 +1,230 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Diagnostics.h"
+#include "Structures.h"
+
+// String of a runtime value (shared by reference count)
+struct stRuntimeString
+{
+public:
+	unsigned int nRef;
+	std::string str;
+};
+
+// Runtime value (a type tag and a payload, 16 bytes)
+// Int, Double and Bool are held by value; a String holds a reference to its stRuntimeString,
+// and a Function holds the index of the function in stProgram::vFunc.
+struct stValue
+{
+public:
+	eValueType eType;
+	union
+	{
+		bool bData;
+		int nData;
+		double dData;
+		stRuntimeString* pString;
+	};
+
+	stValue()
+		: eType(eValueType::Void), dData(0.0)
+	{}
+
+	stValue(const stValue& other)
+		: eType(other.eType), dData(other.dData)
+	{
+		if (eType == eValueType::String)
+			++pString->nRef;
+	}
+
+	stValue(stValue&& other) noexcept
+		: eType(other.eType), dData(other.dData)
+	{
+		other.eType = eValueType::Void;
+	}
+
+	~stValue()
+	{
+		Release();
+	}
+
+	stValue& operator=(const stValue& other)
+	{
+		if (other.eType == eValueType::String)
+			++other.pString->nRef;
+		Release();
+		eType = other.eType;
+		dData = other.dData;
+		return *this;
+	}
+
+	stValue& operator=(stValue&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			eType = other.eType;
+			dData = other.dData;
+			other.eType = eValueType::Void;
+		}
+		return *this;
+	}
+
+	inline static stValue Int(int nData)
+	{
+		stValue val;
+		val.eType = eValueType::Int;
+		val.nData = nData;
+		return val;
+	}
+
+	inline static stValue Double(double dData)
+	{
+		stValue val;
+		val.eType = eValueType::Double;
+		val.dData = dData;
+		return val;
+	}
+
+	inline static stValue Bool(bool bData)
+	{
+		stValue val;
+		val.eType = eValueType::Bool;
+		val.bData = bData;
+		return val;
+	}
+
+	inline static stValue Null()
+	{
+		stValue val;
+		val.eType = eValueType::Null;
+		return val;
+	}
+
+	inline static stValue String(std::string str)
+	{
+		stValue val;
+		val.eType = eValueType::String;
+		val.pString = new stRuntimeString{ 1, std::move(str) };
+		return val;
+	}
+
+private:
+	inline void Release()
+	{
+		if (eType == eValueType::String &&
+			--pString->nRef == 0)
+			delete pString;
+	}
+};
+
+// Reference interpreter (tree-walking, runs main of a checked program)
+// Runs a program that is resolved and type checked (and optionally folded and eliminated), so
+// faster engines have an oracle to compare with. Locals live in a value stack, one frame of
+// stFunction::nFrameSize values per call, addressed by the slots of CResolver. Operations
+// dispatch on the tags of their operands and follow the rules of CTypeChecker: int arithmetic
+// wraps around, int / 0 is a runtime error, string + string concatenates, and a switch runs from
+// the matching case until a break (then the default).
+// printf prints to stdout or to a string (SetOutput); "\n", "\t" and "\\" in the format are
+// written as the characters.
+// Statements and expressions are run by recursion, on a thread of its own with a STACK_SIZE stack.
+// The depth of calls (nMaxDepth) and the nesting of nodes (MAX_NESTING) are limited, so a deeper
+// program stops with a runtime error instead of overflowing the stack.
+// A runtime error stops the program and is reported at the offset of the node.
+class CInterpreter
+{
+// Enums and Classes, Structures ==========================================================
+private:
+	// How control leaves a statement
+	enum class eFlow : unsigned char
+	{
+		Normal,
+		Break,
+		Continue,
+		Return,
+		Fault,
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+public:
+	// Depth of calls up to which a program runs
+	static constexpr size_t DEFAULT_MAX_DEPTH = 20000;
+	// Stack of the thread that runs the program (reserved; pages are committed as they are used)
+	static constexpr size_t STACK_SIZE = 128 * 1024 * 1024;
+	// Nesting of statements and expressions up to which a program runs
+	// (a level takes 100 to 400 bytes of stack in an optimized build and about 1 KB in a debug
+	//  build; a call takes at least three levels)
+	static constexpr size_t MAX_NESTING = STACK_SIZE / 2048;
+
+private:
+	const stProgram* m_pProg;
+	CDiagnostics* m_pDiag;
+	// Frames of the running calls
+	std::vector<stValue> m_vStack;
+	// First slot of the running frame
+	size_t m_nBase;
+	// Value of the last return statement
+	stValue m_valReturn;
+	// Strings of the literals (made once per Run)
+	std::unordered_map<const stStringData*, stValue> m_mapLiteral;
+	// printf output (nullptr: stdout)
+	std::string* m_pOut;
+	// Nesting of the running node
+	size_t m_nDepth;
+	// Depth of the running call
+	size_t m_nCalls;
+	size_t m_nMaxDepth;
+	// Statements and expressions run by the last Run()
+	size_t m_nOps;
+	bool m_bFault;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CInterpreter(size_t nMaxDepth = DEFAULT_MAX_DEPTH);
+
+	bool Run(const stProgram& prog, stValue& valResult, CDiagnostics* pDiag = nullptr);
+
+	inline void SetOutput(std::string* pOut)
+	{
+		m_pOut = pOut;
+	}
+
+	inline size_t GetOpCount() const
+	{
+		return m_nOps;
+	}
+
+private:
+	void RunMain(const stFunction* pMain, stValue& valResult);
+	stValue Call(const stFunction* pFunc, const vstExpression& vArgs, size_t nOffset);
+	eFlow ExecBlock(const vstStatement& vBlock);
+	eFlow Exec(const stStatement* pState);
+	eFlow ExecFor(const stFor* pFor);
+	eFlow ExecWhile(const stWhile* pWhile);
+	eFlow ExecSwitch(const stSwitch* pSwitch);
+	void ExecPrint(const stPrint* pPrint);
+	stValue Eval(const stExpression* pExp);
+	stValue EvalArithmetic(const stArithmetic* pArith);
+	stValue EvalRelational(const stRelational* pRel);
+	stValue EvalConvert(const stConvert* pConv);
+	stValue EvalCall(const stCallFunc* pCall);
+	stValue EvalLiteral(const stStringData* pData);
+	bool Truth(const stExpression* pExp);
+	bool IsEqual(const stValue& valLeft, const stValue& valRight) const;
+	void Write(const char* pData, size_t nSize);
+	void Fault(size_t nOffset, const char* pFormat, ...);
+
+	inline stValue& Slot(unsigned int nSlot)
+	{
+		return m_vStack[m_nBase + nSlot];
+	}
+
+// ========================================================================================
+
+};
\ No newline at end of file
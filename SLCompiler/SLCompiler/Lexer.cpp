@@ -1,54 +1,10 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
 #include "Lexer.h"
-
-// Lexer Map initialize
-std::unordered_map<std::string, CLexer::eLexEnum> CLexer::m_LexMap =
-{
-	std::make_pair("unknown", eLexEnum::Unknown),
-	std::make_pair("null", eLexEnum::Null),
-	std::make_pair("true", eLexEnum::True),
-	std::make_pair("false", eLexEnum::False),
-	std::make_pair("int", eLexEnum::Int),
-	std::make_pair("double", eLexEnum::Double),
-	std::make_pair("string", eLexEnum::String),
-	std::make_pair("void", eLexEnum::Void),
-	std::make_pair("$identifier", eLexEnum::Identifier),
-	std::make_pair("return", eLexEnum::Return),
-	std::make_pair("for", eLexEnum::For),
-	std::make_pair("while", eLexEnum::While),
-	std::make_pair("if", eLexEnum::If),
-	std::make_pair("elif", eLexEnum::Elif),
-	std::make_pair("else", eLexEnum::Else),
-	std::make_pair("switch", eLexEnum::Switch),
-	std::make_pair("case", eLexEnum::Case),
-	std::make_pair("default", eLexEnum::Default),
-	std::make_pair("break", eLexEnum::Break),
-	std::make_pair("continue", eLexEnum::Continue),
-	std::make_pair("printf", eLexEnum::Printf),
-	std::make_pair("&&", eLexEnum::LogicOpAnd),
-	std::make_pair("||", eLexEnum::LogicOpOr),
-	std::make_pair("==", eLexEnum::RelOpEqual),
-	std::make_pair("!=", eLexEnum::RelOpNotEqual),
-	std::make_pair("<", eLexEnum::RelOpLessThan),
-	std::make_pair(">", eLexEnum::RelOpGreaterThan),
-	std::make_pair("<=", eLexEnum::RelOpLessOrEqual),
-	std::make_pair(">=", eLexEnum::RelOpGreaterOrEqual),
-	std::make_pair("+", eLexEnum::OpAdd),
-	std::make_pair("-", eLexEnum::OpSubtract),
-	std::make_pair("*", eLexEnum::OpMultiply),
-	std::make_pair("/", eLexEnum::OpDivide),
-	std::make_pair("%", eLexEnum::OpModulo),
-	std::make_pair("=", eLexEnum::Assignment),
-	std::make_pair(".", eLexEnum::Period),
-	std::make_pair(",", eLexEnum::Comma),
-	std::make_pair(":", eLexEnum::Colon),
-	std::make_pair(";", eLexEnum::Semicolon),
-	std::make_pair("(", eLexEnum::LeftParent),
-	std::make_pair(")", eLexEnum::RightParent),
-	std::make_pair("{", eLexEnum::LeftBrace),
-	std::make_pair("}", eLexEnum::RightBrace),
-	std::make_pair("[", eLexEnum::LeftBraket),
-	std::make_pair("]", eLexEnum::RightBraket),
-};
+#include "ThreadPool.h"
+#include "TokenBuffer.h"
 
 // Lex string
 std::string CLexer::m_strArrLex[static_cast<int>(CLexer::eLexEnum::EndOfLine)] =
@@ -102,115 +58,689 @@ std::string CLexer::m_strArrLex[static_cast<int>(CLexer::eLexEnum::EndOfLine)] =
 	"$Function",
 };
 
+/**
+@brief		Build the charactor type table
+@return		Charactor Type of each of the 256 byte values
+*/
+static constexpr std::array<CLexer::eCharType, 256> MakeCharTypeTable()
+{
+	std::array<CLexer::eCharType, 256> arrTable = {};
+
+	for (int ch = 0; ch < 256; ++ch)
+	{
+		CLexer::eCharType eType = CLexer::eCharType::Unknown;
+
+		// Check End Of Source
+		if (ch == '\0')
+			eType = CLexer::eCharType::EndOfSource;
+		// Check Whitespace
+		else if (ch == ' ' ||
+				 ch == '\t' ||
+				 ch == '\r' ||
+				 ch == '\n')
+			eType = CLexer::eCharType::Whitespace;
+		// Check Number (int, double)
+		else if (ch >= '0' &&
+				 ch <= '9')
+			eType = CLexer::eCharType::Number;
+		// Check String (string)
+		else if (ch == '\"')
+			eType = CLexer::eCharType::String;
+		// Check Identifier or Keyword
+		else if ((ch >= 'a' && ch <= 'z') ||
+				 (ch >= 'A' && ch <= 'Z'))
+			eType = CLexer::eCharType::IdentifierKeyword;
+		// Check Operator or Punctuator
+		else if ((ch >= 33/* ! */ && ch <= 47/* / */) ||
+				 (ch >= 58/* : */ && ch <= 64/* @ */) ||
+				 (ch >= 91/* [ */ && ch <= 96/* ` */) ||
+				 (ch >= 123/* { */ && ch <= 126/*~*/))
+			eType = CLexer::eCharType::OperatorPuncutator;
+
+		arrTable[ch] = eType;
+	}
+
+	return arrTable;
+}
+
+// Charactor type table (indexed by unsigned char)
+static constexpr std::array<CLexer::eCharType, 256> CHAR_TYPE_TABLE = MakeCharTypeTable();
+
+// Operator trie node (indexed by the first charactor)
+struct stOperNode
+{
+	// Operator made of the first charactor alone
+	CLexer::eLexEnum eSingle = CLexer::eLexEnum::Unknown;
+	// Second charactor of the two-charactor operator ('\0' if there is none)
+	char chNext = '\0';
+	// Two-charactor operator
+	CLexer::eLexEnum eDouble = CLexer::eLexEnum::Unknown;
+};
+
+/**
+@brief		Build the operator trie
+@return		Operator trie node of each of the 256 byte values
+*/
+static constexpr std::array<stOperNode, 256> MakeOperTrie()
+{
+	struct stOper
+	{
+		const char* pOper;
+		CLexer::eLexEnum eLex;
+	};
+	const stOper arrOper[] =
+	{
+		{ "&&", CLexer::eLexEnum::LogicOpAnd },
+		{ "||", CLexer::eLexEnum::LogicOpOr },
+		{ "==", CLexer::eLexEnum::RelOpEqual },
+		{ "!=", CLexer::eLexEnum::RelOpNotEqual },
+		{ "<", CLexer::eLexEnum::RelOpLessThan },
+		{ ">", CLexer::eLexEnum::RelOpGreaterThan },
+		{ "<=", CLexer::eLexEnum::RelOpLessOrEqual },
+		{ ">=", CLexer::eLexEnum::RelOpGreaterOrEqual },
+		{ "+", CLexer::eLexEnum::OpAdd },
+		{ "-", CLexer::eLexEnum::OpSubtract },
+		{ "*", CLexer::eLexEnum::OpMultiply },
+		{ "/", CLexer::eLexEnum::OpDivide },
+		{ "%", CLexer::eLexEnum::OpModulo },
+		{ "=", CLexer::eLexEnum::Assignment },
+		{ ".", CLexer::eLexEnum::Period },
+		{ ",", CLexer::eLexEnum::Comma },
+		{ ":", CLexer::eLexEnum::Colon },
+		{ ";", CLexer::eLexEnum::Semicolon },
+		{ "(", CLexer::eLexEnum::LeftParent },
+		{ ")", CLexer::eLexEnum::RightParent },
+		{ "{", CLexer::eLexEnum::LeftBrace },
+		{ "}", CLexer::eLexEnum::RightBrace },
+		{ "[", CLexer::eLexEnum::LeftBraket },
+		{ "]", CLexer::eLexEnum::RightBraket },
+	};
+	std::array<stOperNode, 256> arrTrie = {};
+
+	for (const stOper& stOp : arrOper)
+	{
+		stOperNode& stNode = arrTrie[static_cast<unsigned char>(stOp.pOper[0])];
+
+		if (stOp.pOper[1] == '\0')
+		{
+			stNode.eSingle = stOp.eLex;
+		}
+		else
+		{
+			// A first charactor has at most one continuation (otherwise this is not a constant expression)
+			if (stNode.chNext != '\0')
+				throw "Operator trie supports one continuation per first charactor";
+
+			stNode.chNext = stOp.pOper[1];
+			stNode.eDouble = stOp.eLex;
+		}
+	}
+
+	return arrTrie;
+}
+
+// Operator trie (indexed by unsigned char)
+static constexpr std::array<stOperNode, 256> OPER_TRIE = MakeOperTrie();
+
+/**
+@brief		Check Charactor Type
+@param		ch		Charactor
+@return		Charactor Type (enum eCharType)
+*/
+inline CLexer::eCharType CLexer::CheckCharType(char ch)
+{
+	return CHAR_TYPE_TABLE[static_cast<unsigned char>(ch)];
+}
+
+/**
+@brief		Match a keyword or operator candidate
+@param		strLex		Candidate string
+@param		strWord		Keyword or operator
+@param		eLex		Result if matched
+@return		eLex if strLex is strWord, otherwise eLexEnum::Unknown
+*/
+static inline CLexer::eLexEnum MatchLex(std::string_view strLex, std::string_view strWord, CLexer::eLexEnum eLex)
+{
+	return strLex == strWord ? eLex : CLexer::eLexEnum::Unknown;
+}
+
+/**
+@brief		Find keyword or operator
+@param		strLex		Keyword or operator candidate
+@return		Keyword or operator lex (eLexEnum::Unknown if strLex is neither)
+@details	(Length, first charactor) is a perfect hash of the keyword and operator set,
+			so every candidate is compared against at most two words without allocation.
+*/
+CLexer::eLexEnum CLexer::FindLex(std::string_view strLex)
+{
+	if (strLex.empty())
+		return eLexEnum::Unknown;
+
+	switch (strLex.size())
+	{
+		case 1:
+			switch (strLex[0])
+			{
+				case '<': return eLexEnum::RelOpLessThan;
+				case '>': return eLexEnum::RelOpGreaterThan;
+				case '+': return eLexEnum::OpAdd;
+				case '-': return eLexEnum::OpSubtract;
+				case '*': return eLexEnum::OpMultiply;
+				case '/': return eLexEnum::OpDivide;
+				case '%': return eLexEnum::OpModulo;
+				case '=': return eLexEnum::Assignment;
+				case '.': return eLexEnum::Period;
+				case ',': return eLexEnum::Comma;
+				case ':': return eLexEnum::Colon;
+				case ';': return eLexEnum::Semicolon;
+				case '(': return eLexEnum::LeftParent;
+				case ')': return eLexEnum::RightParent;
+				case '{': return eLexEnum::LeftBrace;
+				case '}': return eLexEnum::RightBrace;
+				case '[': return eLexEnum::LeftBraket;
+				case ']': return eLexEnum::RightBraket;
+			}
+			break;
+		case 2:
+			switch (strLex[0])
+			{
+				case 'i': return MatchLex(strLex, "if", eLexEnum::If);
+				case '&': return MatchLex(strLex, "&&", eLexEnum::LogicOpAnd);
+				case '|': return MatchLex(strLex, "||", eLexEnum::LogicOpOr);
+				case '=': return MatchLex(strLex, "==", eLexEnum::RelOpEqual);
+				case '!': return MatchLex(strLex, "!=", eLexEnum::RelOpNotEqual);
+				case '<': return MatchLex(strLex, "<=", eLexEnum::RelOpLessOrEqual);
+				case '>': return MatchLex(strLex, ">=", eLexEnum::RelOpGreaterOrEqual);
+			}
+			break;
+		case 3:
+			switch (strLex[0])
+			{
+				case 'i': return MatchLex(strLex, "int", eLexEnum::Int);
+				case 'f': return MatchLex(strLex, "for", eLexEnum::For);
+			}
+			break;
+		case 4:
+			switch (strLex[0])
+			{
+				case 'n': return MatchLex(strLex, "null", eLexEnum::Null);
+				case 't': return MatchLex(strLex, "true", eLexEnum::True);
+				case 'v': return MatchLex(strLex, "void", eLexEnum::Void);
+				case 'c': return MatchLex(strLex, "case", eLexEnum::Case);
+				case 'e':
+					if (strLex[1] == 'l' && strLex[2] == 'i')
+						return MatchLex(strLex, "elif", eLexEnum::Elif);
+					return MatchLex(strLex, "else", eLexEnum::Else);
+			}
+			break;
+		case 5:
+			switch (strLex[0])
+			{
+				case 'f': return MatchLex(strLex, "false", eLexEnum::False);
+				case 'w': return MatchLex(strLex, "while", eLexEnum::While);
+				case 'b': return MatchLex(strLex, "break", eLexEnum::Break);
+			}
+			break;
+		case 6:
+			switch (strLex[0])
+			{
+				case 'd': return MatchLex(strLex, "double", eLexEnum::Double);
+				case 'r': return MatchLex(strLex, "return", eLexEnum::Return);
+				case 'p': return MatchLex(strLex, "printf", eLexEnum::Printf);
+				case 's':
+					if (strLex[1] == 't')
+						return MatchLex(strLex, "string", eLexEnum::String);
+					return MatchLex(strLex, "switch", eLexEnum::Switch);
+			}
+			break;
+		case 7:
+			return MatchLex(strLex, "default", eLexEnum::Default);
+		case 8:
+			return MatchLex(strLex, "continue", eLexEnum::Continue);
+	}
+
+	return eLexEnum::Unknown;
+}
+
+/**
+@brief		Print the diagnostics the caller did not collect
+@param		diag			Diagnostics
+@param		iterSource		Start of the source
+@return
+*/
+static void PrintDiagnostics(const CDiagnostics& diag, siter iterSource)
+{
+	if (diag.Get().empty() == false)
+		diag.Print(iterSource);
+}
+
 /**
 @brief		Lexer Scanner
-@param		strSourceCode		Source Code
+@param		strSourceCode		Source Code (Tokens refer to this buffer, so it must outlive them)
+@param		pDiag				Diagnostics (nullptr: printed after the scan)
+@return		Source Code to token
+*/
+std::vector<CLexer::stToken> CLexer::Scan(const std::string& strSourceCode, CDiagnostics* pDiag)
+{
+	// std::string is always terminated by '\0' (End Of Source Character)
+	return ScanSource(strSourceCode.c_str(), pDiag);
+}
+
+/**
+@brief		Lexer Scanner (Source file)
+@param		source		Mapped source file (Tokens refer to its text, so it must outlive them)
+@param		pDiag		Diagnostics (nullptr: printed after the scan)
 @return		Source Code to token
 */
-std::vector<CLexer::stToken> CLexer::Scan(std::string strSourceCode)
+std::vector<CLexer::stToken> CLexer::Scan(const CSourceFile& source, CDiagnostics* pDiag)
 {
-	// Add End Of Source Character
-	strSourceCode += '\0';
+	// CSourceFile text is always terminated by '\0' (End Of Source Character)
+	return ScanSource(source.Data(), pDiag);
+}
 
+/**
+@brief		Lexer Scanner (Token buffer)
+@param		strSourceCode		Source Code (Tokens refer to this buffer, so it must outlive them)
+@param		buffer				Token buffer (ends with the EndOfLine sentinel)
+@param		pDiag				Diagnostics (nullptr: printed after the scan)
+@return
+*/
+void CLexer::Scan(const std::string& strSourceCode, CTokenBuffer& buffer, CDiagnostics* pDiag)
+{
+	ScanSource(strSourceCode.c_str(), buffer, pDiag);
+}
+
+/**
+@brief		Lexer Scanner (Source file, Token buffer)
+@param		source		Mapped source file (Tokens refer to its text, so it must outlive them)
+@param		buffer		Token buffer (ends with the EndOfLine sentinel)
+@param		pDiag		Diagnostics (nullptr: printed after the scan)
+@return
+*/
+void CLexer::Scan(const CSourceFile& source, CTokenBuffer& buffer, CDiagnostics* pDiag)
+{
+	ScanSource(source.Data(), buffer, pDiag);
+}
+
+/**
+@brief		Scan the whole source
+@param		iter		Start of the '\0' terminated source
+@param		pDiag		Diagnostics (nullptr: printed after the scan)
+@return		Source Code to token
+*/
+std::vector<CLexer::stToken> CLexer::ScanSource(siter iter, CDiagnostics* pDiag)
+{
 	std::vector<stToken> vResult;
-	siter iter = strSourceCode.begin();
-	bool bIsEndOfSource = false;
-	eCharType eType = eCharType::Unknown;
+	stToken stTokenData;
 	int nPrevIdentifierIdx = -1;
-	int nCurChIdx = -1;
-	
-	while (iter != strSourceCode.end() &&
-		   bIsEndOfSource == false)
+	CDiagnostics diagLocal;
+	stScanContext stContext;
+	stContext.iterSource = iter;
+	stContext.pSymbols = &CSymbolTable::Global();
+	stContext.pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+
+	while (ScanNext(iter, stTokenData, stContext))
+	{
+		vResult.push_back(stTokenData);
+
+		if (stTokenData.eLex == eLexEnum::Identifier)
+		{
+			nPrevIdentifierIdx = (int)vResult.size() - 1;
+		}
+		else if (nPrevIdentifierIdx != -1 &&
+				 IsOperPunc(stTokenData.eLex))
+		{
+			vResult[nPrevIdentifierIdx].eLex = stTokenData.eLex == eLexEnum::LeftParent ? eLexEnum::Function : eLexEnum::Variable;
+			nPrevIdentifierIdx = -1;
+		}
+	}
+
+	PrintDiagnostics(diagLocal, stContext.iterSource);
+	return vResult;
+}
+
+// Sources smaller than this are scanned serially
+static const size_t PARALLEL_MIN_CHUNK_SIZE = 256 * 1024;
+// Chunks per thread (for load balancing)
+static const int PARALLEL_CHUNKS_PER_THREAD = 4;
+
+/**
+@brief		Parallel Lexer Scanner
+@param		strSourceCode		Source Code (Tokens refer to this buffer, so it must outlive them)
+@param		pool				Thread pool
+@param		pDiag				Diagnostics (nullptr: printed after the scan)
+@return		Source Code to token (same as Scan)
+*/
+std::vector<CLexer::stToken> CLexer::ScanParallel(const std::string& strSourceCode, CThreadPool& pool, CDiagnostics* pDiag)
+{
+	return ScanParallelSource(strSourceCode.c_str(), strSourceCode.size(), pool, pDiag);
+}
+
+/**
+@brief		Parallel Lexer Scanner (Source file)
+@param		source		Mapped source file (Tokens refer to its text, so it must outlive them)
+@param		pool		Thread pool
+@param		pDiag		Diagnostics (nullptr: printed after the scan)
+@return		Source Code to token (same as Scan)
+*/
+std::vector<CLexer::stToken> CLexer::ScanParallel(const CSourceFile& source, CThreadPool& pool, CDiagnostics* pDiag)
+{
+	return ScanParallelSource(source.Data(), source.Size(), pool, pDiag);
+}
+
+/**
+@brief		Scan the source in chunks on the thread pool and stitch the tokens together
+@param		iterSource		Start of the '\0' terminated source
+@param		nSize			Source size
+@param		pool			Thread pool
+@param		pDiag			Diagnostics (nullptr: printed after the scan)
+@return		Source Code to token
+*/
+std::vector<CLexer::stToken> CLexer::ScanParallelSource(siter iterSource, size_t nSize, CThreadPool& pool, CDiagnostics* pDiag)
+{
+	// The serial scanner stops at the first '\0'
+	siter iterNull = static_cast<siter>(memchr(iterSource, '\0', nSize));
+	if (iterNull != nullptr)
+		nSize = iterNull - iterSource;
+
+	int nChunks = (int)std::min<size_t>(nSize / PARALLEL_MIN_CHUNK_SIZE, (size_t)pool.GetThreadCount() * PARALLEL_CHUNKS_PER_THREAD);
+	if (nChunks <= 1 ||
+		pool.GetThreadCount() == 1)
+		return ScanSource(iterSource, pDiag);
+
+	std::vector<siter> vBoundary = SplitSource(iterSource, nSize, nChunks, pool);
+	std::vector<stChunk> vChunk(vBoundary.size() - 1);
+	for (size_t i = 0; i < vChunk.size(); ++i)
 	{
-		eType = CheckCharType(*iter);
-		++nCurChIdx;
+		vChunk[i].iterBegin = vBoundary[i];
+		vChunk[i].iterEnd = vBoundary[i + 1];
+	}
+
+	pool.Run((int)vChunk.size(), [&vChunk, iterSource](int nIdx) {
+		ScanChunk(vChunk[nIdx], iterSource);
+	});
 
-		switch (eType)
+	// Stitch: a trailing identifier is decided by the first identifier or operator of a following chunk
+	std::vector<std::pair<size_t, eLexEnum>> vRetag;
+	size_t nTotal = 0;
+	long long nCarryIdx = -1;
+	CSymbolTable& symbols = CSymbolTable::Global();
+	CDiagnostics diagLocal;
+	CDiagnostics& diag = pDiag != nullptr ? *pDiag : diagLocal;
+
+	for (stChunk& stChunkData : vChunk)
+	{
+		stChunkData.nOffset = nTotal;
+		diag.Append(stChunkData.diag);
+
+		// Chunk symbols are merged in source order, so the IDs are the same as the serial scanner's
+		size_t nSymbols = stChunkData.pSymbols->Size();
+		stChunkData.vSymbolRemap.resize(nSymbols);
+		for (size_t i = 0; i < nSymbols; ++i)
+			stChunkData.vSymbolRemap[i] = symbols.Intern(stChunkData.pSymbols->GetName((SymbolID)i));
+
+		if (nCarryIdx != -1 &&
+			stChunkData.nFirstDecideIdx != -1)
+		{
+			eLexEnum eDecide = stChunkData.vTokens[stChunkData.nFirstDecideIdx].eLex;
+			if (IsOperPunc(eDecide))
+				vRetag.emplace_back((size_t)nCarryIdx, eDecide == eLexEnum::LeftParent ? eLexEnum::Function : eLexEnum::Variable);
+			nCarryIdx = -1;
+		}
+
+		if (stChunkData.nPendingIdx != -1)
+			nCarryIdx = (long long)(nTotal + stChunkData.nPendingIdx);
+
+		nTotal += stChunkData.vTokens.size();
+	}
+
+	std::vector<stToken> vResult(nTotal);
+	pool.Run((int)vChunk.size(), [&vChunk, &vResult](int nIdx) {
+		stChunk& stChunkData = vChunk[nIdx];
+		std::vector<stToken>::iterator iterOut = vResult.begin() + stChunkData.nOffset;
+
+		for (const stToken& stTokenData : stChunkData.vTokens)
+		{
+			*iterOut = stTokenData;
+			if (IsIdentifier(stTokenData.eLex))
+				iterOut->uValue.nSymbol = stChunkData.vSymbolRemap[stTokenData.uValue.nSymbol];
+			++iterOut;
+		}
+
+		std::vector<stToken>().swap(stChunkData.vTokens);
+		stChunkData.pSymbols.reset();
+	});
+
+	for (const std::pair<size_t, eLexEnum>& retag : vRetag)
+		vResult[retag.first].eLex = retag.second;
+
+	PrintDiagnostics(diagLocal, iterSource);
+	return vResult;
+}
+
+/**
+@brief		Find chunk boundaries that no token crosses
+@param		iterSource		Start of the source
+@param		nSize			Source size
+@param		nChunks			Wanted chunk count
+@param		pool			Thread pool (counts the '"' of each nominal chunk)
+@return		Chunk boundaries (first is the start, last is the end of source)
+@details	A boundary is a whitespace charactor outside of string literals, which is
+			known from the parity of the '"' before it (string literals have no escapes).
+*/
+std::vector<siter> CLexer::SplitSource(siter iterSource, size_t nSize, int nChunks, CThreadPool& pool)
+{
+	// Pre-pass: '"' parity of every nominal chunk
+	std::vector<size_t> vNominal(nChunks + 1);
+	std::vector<int> vParity(nChunks, 0);
+	for (int i = 0; i <= nChunks; ++i)
+		vNominal[i] = nSize / nChunks * i;
+	vNominal[nChunks] = nSize;
+
+	pool.Run(nChunks, [iterSource, &vNominal, &vParity](int nIdx) {
+		siter iter = iterSource + vNominal[nIdx];
+		siter iterEnd = iterSource + vNominal[nIdx + 1];
+		int nParity = 0;
+		while ((iter = static_cast<siter>(memchr(iter, '\"', iterEnd - iter))) != nullptr)
+		{
+			nParity ^= 1;
+			++iter;
+		}
+		vParity[nIdx] = nParity;
+	});
+
+	// Parity of the '"' before each nominal boundary
+	std::vector<int> vPrefixParity(nChunks + 1, 0);
+	for (int i = 0; i < nChunks; ++i)
+		vPrefixParity[i + 1] = vPrefixParity[i] ^ vParity[i];
+
+	std::vector<siter> vBoundary;
+	vBoundary.push_back(iterSource);
+
+	size_t nPos = 0;
+	int nParity = 0;
+	for (int i = 1; i < nChunks; ++i)
+	{
+		// Jump to the nominal boundary unless the previous search already passed it
+		if (vNominal[i] > nPos)
+		{
+			nPos = vNominal[i];
+			nParity = vPrefixParity[i];
+		}
+
+		while (nPos < nSize)
+		{
+			char ch = iterSource[nPos];
+			if (nParity == 0 &&
+				CheckCharType(ch) == eCharType::Whitespace)
+				break;
+
+			if (ch == '\"')
+				nParity ^= 1;
+			++nPos;
+		}
+
+		if (nPos >= nSize)
+			break;
+
+		vBoundary.push_back(iterSource + nPos);
+
+		// The boundary whitespace belongs to the next chunk
+		++nPos;
+	}
+
+	vBoundary.push_back(iterSource + nSize);
+	return vBoundary;
+}
+
+/**
+@brief		Scan one chunk of the source
+@param		stChunkData		Chunk (range in, tokens out)
+@param		iterSource		Start of the source (diagnostic offsets are relative to it)
+@return
+*/
+void CLexer::ScanChunk(stChunk& stChunkData, siter iterSource)
+{
+	siter iter = stChunkData.iterBegin;
+	stToken stTokenData;
+
+	stChunkData.pSymbols = std::make_unique<CSymbolTable>();
+
+	stScanContext stContext;
+	stContext.iterSource = iterSource;
+	stContext.pSymbols = stChunkData.pSymbols.get();
+	stContext.pDiag = &stChunkData.diag;
+
+	while (true)
+	{
+		// ScanNext stops at the chunk end (also after skipping an unknown charactor or operator),
+		// so the first token of the next chunk is left to it
+		if (ScanNext(iter, stTokenData, stContext, stChunkData.iterEnd) == false)
+			break;
+
+		stChunkData.vTokens.push_back(stTokenData);
+
+		bool bIsIdentifier = stTokenData.eLex == eLexEnum::Identifier;
+		if (stChunkData.nFirstDecideIdx == -1 &&
+			(bIsIdentifier || IsOperPunc(stTokenData.eLex)))
+			stChunkData.nFirstDecideIdx = (int)stChunkData.vTokens.size() - 1;
+
+		if (bIsIdentifier)
+		{
+			stChunkData.nPendingIdx = (int)stChunkData.vTokens.size() - 1;
+		}
+		else if (stChunkData.nPendingIdx != -1 &&
+				 IsOperPunc(stTokenData.eLex))
+		{
+			stChunkData.vTokens[stChunkData.nPendingIdx].eLex = stTokenData.eLex == eLexEnum::LeftParent ? eLexEnum::Function : eLexEnum::Variable;
+			stChunkData.nPendingIdx = -1;
+		}
+	}
+}
+
+/**
+@brief		Scan the whole source into a token buffer
+@param		iter		Start of the '\0' terminated source
+@param		buffer		Token buffer (ends with the EndOfLine sentinel)
+@param		pDiag		Diagnostics (nullptr: printed after the scan)
+@return
+*/
+void CLexer::ScanSource(siter iter, CTokenBuffer& buffer, CDiagnostics* pDiag)
+{
+	stToken stTokenData;
+	long long nPrevIdentifierIdx = -1;
+	CDiagnostics diagLocal;
+	stScanContext stContext;
+	stContext.iterSource = iter;
+	stContext.pSymbols = &CSymbolTable::Global();
+	stContext.pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+
+	buffer.Reset(iter);
+
+	while (ScanNext(iter, stTokenData, stContext))
+	{
+		buffer.Push(stTokenData);
+
+		if (stTokenData.eLex == eLexEnum::Identifier)
+		{
+			nPrevIdentifierIdx = (long long)buffer.Size() - 1;
+		}
+		else if (nPrevIdentifierIdx != -1 &&
+				 IsOperPunc(stTokenData.eLex))
+		{
+			buffer.SetKind((size_t)nPrevIdentifierIdx, stTokenData.eLex == eLexEnum::LeftParent ? eLexEnum::Function : eLexEnum::Variable);
+			nPrevIdentifierIdx = -1;
+		}
+	}
+
+	buffer.Finish();
+	PrintDiagnostics(diagLocal, stContext.iterSource);
+}
+
+/**
+@brief		Scan the next token
+@param		iter			Scanning point (moved past the token)
+@param		stTokenData		Scanned token (Identifiers are not retagged yet)
+@param		stContext		Scan context
+@param		iterEnd			End of the scan (nullptr: the end of source; a token that starts before it is scanned whole)
+@return		false if the end of source (or iterEnd) was reached
+*/
+bool CLexer::ScanNext(siter& iter, stToken& stTokenData, stScanContext& stContext, siter iterEnd)
+{
+	// Each iteration starts at a token boundary; the charactor class of the
+	// first charactor selects the state that consumes the whole token.
+	while (true)
+	{
+		if (iterEnd != nullptr &&
+			iter >= iterEnd)
+			return false;
+
+		switch (CheckCharType(*iter))
 		{
 			case eCharType::Whitespace:
-				++iter;
+				// Skip the whole whitespace run
+				do
+				{
+					++iter;
+				} while (CheckCharType(*iter) == eCharType::Whitespace);
 				break;
 			case eCharType::Number:
-				vResult.push_back(ScanNumber(iter));
-				break;
+				stTokenData = ScanNumber(iter);
+				DecodeNumber(stTokenData, stContext);
+				return true;
 			case eCharType::String:
-				vResult.push_back(ScanString(iter));
-				break;
+				stTokenData = ScanString(iter);
+
+				// The closing '"' is missing when the literal runs to the end of source
+				if (stTokenData.strString.data() + stTokenData.strString.size() == iter)
+					stContext.pDiag->Error(stTokenData.strString.data() - 1 - stContext.iterSource, "Unterminated string literal");
+				return true;
 			case eCharType::IdentifierKeyword:
-			{
-				stToken stTokenData = ScanIdentifierKeyword(iter);
-				vResult.push_back(stTokenData);
+				stTokenData = ScanIdentifierKeyword(iter);
 
 				if (stTokenData.eLex == eLexEnum::Identifier)
-					nPrevIdentifierIdx = (int)vResult.size() - 1;
-				break;
-			}
+					stTokenData.uValue.nSymbol = stContext.pSymbols->Intern(stTokenData.strString);
+				return true;
 			case eCharType::OperatorPuncutator:
-			{
-				stToken stTokenData = ScanOperPunc(iter);
-				vResult.push_back(stTokenData);
+				stTokenData = ScanOperPunc(iter);
 
-				if (nPrevIdentifierIdx != -1)
+				// Unknown operator: report it and go on with the next charactor
+				if (stTokenData.eLex == eLexEnum::Unknown)
 				{
-					vResult.at(nPrevIdentifierIdx).eLex = stTokenData.eLex == eLexEnum::LeftParent ? eLexEnum::Function : eLexEnum::Variable;
-					nPrevIdentifierIdx = -1;
+					stContext.pDiag->Error(stTokenData.strString.data() - stContext.iterSource, "Unknown operator '" + std::string(stTokenData.strString) + "'");
+					break;
 				}
-				break;
-			}
+				return true;
 			case eCharType::EndOfSource:
-				bIsEndOfSource = true;
-				break;
+				return false;
 			case eCharType::Unknown:
 			default:
-				printf("Unknown Type : Error Position %s <<-\n", strSourceCode.substr(nCurChIdx).c_str());
-				exit(1);
+				// Unknown charactor: report it and skip it
+				stContext.pDiag->Error(iter - stContext.iterSource, "Unknown charactor '" + std::string(1, *iter) + "'");
+				++iter;
 				break;
 		}
 	}
-
-	return vResult;
-}
-
-/**
-@brief		Check Charactor Type
-@param		ch		Charactor
-@return		Charactor Type (enum eCharType)
-*/
-CLexer::eCharType CLexer::CheckCharType(char ch)
-{
-	// Check End Of Source
-	if (ch == '\0')
-		return eCharType::EndOfSource;
-
-	// Check Whitespace
-	if (ch == ' ' ||
-		ch == '\t' ||
-		ch == '\r' ||
-		ch == '\n')
-		return eCharType::Whitespace;
-
-	// Check Number (int, double)
-	if (ch >= '0' &&
-		ch <= '9')
-		return eCharType::Number;
-
-	// Check String (string)
-	if (ch == '\"')
-		return eCharType::String;
-
-	// Check Identifier or Keyword
-	if ((ch >= 'a' && ch <= 'z') ||
-		(ch >= 'A' && ch <= 'Z'))
-		return eCharType::IdentifierKeyword;
-
-	// Check Operator or Punctuator
-	if ((ch >= 33/* ! */ && ch <= 47/* / */ && ch != '\"' /* 34 */) ||
-		(ch >= 58/* : */ && ch <= 64/* @ */) ||
-		(ch >= 91/* [ */ && ch <= 96/* ` */) ||
-		(ch >= 123/* { */ && ch <= 126/*~*/))
-		return eCharType::OperatorPuncutator;
-
-	return eCharType::Unknown;
 }
 
 /**
@@ -220,35 +750,65 @@ CLexer::eCharType CLexer::CheckCharType(char ch)
 */
 CLexer::stToken CLexer::ScanNumber(siter& iter)
 {
-	std::string strString = "";
+	siter iterStart = iter;
 	eLexEnum eLex = eLexEnum::Unknown;
 
 	while (CheckCharType(*iter) == eCharType::Number)
 	{
 		eLex = eLexEnum::Int;
-		strString += *iter;
 		++iter;
 	}
 
 	// Decimal Point
 	if (*iter == '.')
 	{
-		strString += *iter;
 		++iter;
 
-		while (CheckCharType(*iter) == eCharType::Number);
+		while (CheckCharType(*iter) == eCharType::Number)
 		{
 			eLex = eLexEnum::Double;
-			strString += *iter;
 			++iter;
 		}
 	}
 
 	// If the value of A is empty, it is not a numeric type.
-	if (strString[strString.size() - 1] == '.')
+	if (*(iter - 1) == '.')
 		eLex = eLexEnum::Unknown;
 	
-	return stToken(eLex, strString);
+	return stToken(eLex, std::string_view(iterStart, iter - iterStart));
+}
+
+/**
+@brief		Decode the value of a number token
+@param		stTokenData		Number token (the value is stored in its payload)
+@param		stContext		Scan context (malformed and out of range numbers are reported to it)
+@return
+*/
+void CLexer::DecodeNumber(stToken& stTokenData, stScanContext& stContext)
+{
+	const char* pBegin = stTokenData.strString.data();
+	const char* pEnd = pBegin + stTokenData.strString.size();
+	size_t nOffset = pBegin - stContext.iterSource;
+	std::from_chars_result result;
+
+	// from_chars does not depend on the locale and leaves the value untouched on failure
+	switch (stTokenData.eLex)
+	{
+		case eLexEnum::Int:
+			stTokenData.uValue.nInt = 0;
+			result = std::from_chars(pBegin, pEnd, stTokenData.uValue.nInt);
+			break;
+		case eLexEnum::Double:
+			stTokenData.uValue.dDouble = 0.0;
+			result = std::from_chars(pBegin, pEnd, stTokenData.uValue.dDouble, std::chars_format::fixed);
+			break;
+		default:
+			stContext.pDiag->Error(nOffset, "Malformed number '" + std::string(stTokenData.strString) + "'");
+			return;
+	}
+
+	if (result.ec == std::errc::result_out_of_range)
+		stContext.pDiag->Error(nOffset, "Number out of range '" + std::string(stTokenData.strString) + "'");
 }
 
 /**
@@ -258,7 +818,8 @@ CLexer::stToken CLexer::ScanNumber(siter& iter)
 */
 CLexer::stToken CLexer::ScanString(siter& iter)
 {
-	std::string strString = "";
+	siter iterStart = iter;
+	siter iterEnd = iter;
 	eLexEnum eLex = eLexEnum::Unknown;
 	eCharType eType = eCharType::Unknown;
 
@@ -267,6 +828,7 @@ CLexer::stToken CLexer::ScanString(siter& iter)
 	{
 		eLex = eLexEnum::String;
 		++iter;
+		iterStart = iter;
 
 		// Except for the first and last characters, the rest of the characters are A.
 		while (true)
@@ -274,19 +836,22 @@ CLexer::stToken CLexer::ScanString(siter& iter)
 			eType = CheckCharType(*iter);
 			if (eType == eCharType::String)
 			{
+				iterEnd = iter;
 				++iter;
 				break;
 			}
 
 			if (eType == eCharType::EndOfSource)
+			{
+				iterEnd = iter;
 				break;
+			}
 
-			strString += *iter;
 			++iter;
 		}
 	}
 
-	return stToken(eLex, strString);
+	return stToken(eLex, std::string_view(iterStart, iterEnd - iterStart));
 }
 
 /**
@@ -296,15 +861,13 @@ CLexer::stToken CLexer::ScanString(siter& iter)
 */
 CLexer::stToken CLexer::ScanIdentifierKeyword(siter& iter)
 {
-	std::string strString = "";
+	siter iterStart = iter;
 	eLexEnum eLex = eLexEnum::Unknown;
 
 	while (CheckCharType(*iter) == eCharType::IdentifierKeyword)
-	{
-		strString += *iter;
 		++iter;
-	}
 
+	std::string_view strString(iterStart, iter - iterStart);
 	eLex = FindLex(strString);
 	if (eLex == eLexEnum::Unknown)
 		eLex = eLexEnum::Identifier;
@@ -319,25 +882,85 @@ CLexer::stToken CLexer::ScanIdentifierKeyword(siter& iter)
 */
 CLexer::stToken CLexer::ScanOperPunc(siter& iter)
 {
-	std::string strString = "";
-	eLexEnum eLex = eLexEnum::Unknown;
+	const stOperNode& stNode = OPER_TRIE[static_cast<unsigned char>(*iter)];
+	siter iterStart = iter;
 
-	while (CheckCharType(*iter) == eCharType::OperatorPuncutator)
+	// One charactor of lookahead decides between the two-charactor and the single operator
+	if (stNode.chNext != '\0' &&
+		iter[1] == stNode.chNext)
 	{
-		strString += *iter;
-		++iter;
+		iter += 2;
+		return stToken(stNode.eDouble, std::string_view(iterStart, 2));
 	}
 
-	while (strString.empty() == false)
+	++iter;
+	return stToken(stNode.eSingle, std::string_view(iterStart, 1));
+}
+
+CLexerStream::CLexerStream(const std::string& strSourceCode, CDiagnostics* pDiag)
+	: m_iter(strSourceCode.c_str()), m_nWaitIdx(-1), m_bEndOfSource(false)
+{
+	m_stContext.iterSource = m_iter;
+	m_stContext.pSymbols = &CSymbolTable::Global();
+	m_stContext.pDiag = pDiag != nullptr ? pDiag : &m_diag;
+}
+
+CLexerStream::CLexerStream(const CSourceFile& source, CDiagnostics* pDiag)
+	: m_iter(source.Data()), m_nWaitIdx(-1), m_bEndOfSource(false)
+{
+	m_stContext.iterSource = m_iter;
+	m_stContext.pSymbols = &CSymbolTable::Global();
+	m_stContext.pDiag = pDiag != nullptr ? pDiag : &m_diag;
+}
+
+/**
+@brief		Pull the next token
+@param		stTokenData		Next token
+@return		false if there are no more tokens
+*/
+bool CLexerStream::NextToken(CLexer::stToken& stTokenData)
+{
+	while (true)
 	{
-		if (FindLex(strString) != eLexEnum::Unknown)
-			break;
+		// Tokens before the waiting identifier are final
+		if (m_dqPending.empty() == false &&
+			m_nWaitIdx != 0)
+		{
+			stTokenData = m_dqPending.front();
+			m_dqPending.pop_front();
+			if (m_nWaitIdx > 0)
+				--m_nWaitIdx;
+			return true;
+		}
 
-		strString.pop_back();
-		--iter;
-	}
+		CLexer::stToken stNext;
+		if (m_bEndOfSource ||
+			CLexer::ScanNext(m_iter, stNext, m_stContext) == false)
+		{
+			if (m_bEndOfSource == false)
+				PrintDiagnostics(m_diag, m_stContext.iterSource);
 
-	eLex = strString.empty() ? eLexEnum::Unknown : FindLex(strString);
+			// Identifier at the end of source is not followed by an operator
+			m_bEndOfSource = true;
+			m_nWaitIdx = -1;
 
-	return stToken(eLex, strString);
+			if (m_dqPending.empty())
+				return false;
+			continue;
+		}
+
+		m_dqPending.push_back(stNext);
+
+		if (stNext.eLex == CLexer::eLexEnum::Identifier)
+		{
+			// A previously waiting identifier stays Identifier
+			m_nWaitIdx = (int)m_dqPending.size() - 1;
+		}
+		else if (m_nWaitIdx != -1 &&
+				 CLexer::IsOperPunc(stNext.eLex))
+		{
+			m_dqPending[m_nWaitIdx].eLex = stNext.eLex == CLexer::eLexEnum::LeftParent ? CLexer::eLexEnum::Function : CLexer::eLexEnum::Variable;
+			m_nWaitIdx = -1;
+		}
+	}
 }
\ No newline at end of file
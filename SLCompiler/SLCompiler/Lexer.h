@@ -1,9 +1,17 @@
 #pragma once
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <deque>
 #include <vector>
+#include "Diagnostics.h"
+#include "SourceFile.h"
+#include "SymbolTable.h"
 
-typedef std::string::iterator siter;
+class CThreadPool;
+class CTokenBuffer;
+
+// Scanning point (Points into the source buffer, which is always '\0' terminated)
+typedef const char* siter;
 
 static class CLexer
 {
@@ -83,47 +91,153 @@ public:
 		EndOfSource,
 	};
 
+	// Token payload (decoded once by the lexer)
+	union uTokenValue
+	{
+		// Interned name of Identifier, Variable and Function tokens
+		SymbolID nSymbol;
+		// Value of Int literals
+		int nInt;
+		// Value of Double literals
+		double dDouble;
+	};
+
+	// Token (strString refers to the source buffer, so the source must outlive the tokens)
 	struct stToken
 	{
 	public:
 		eLexEnum eLex = eLexEnum::Null;
-		std::string strString = "";
+		std::string_view strString;
+		uTokenValue uValue = { CSymbolTable::INVALID_SYMBOL };
 
 		stToken() {}
-		stToken(eLexEnum eLex, std::string strString)
+		stToken(eLexEnum eLex, std::string_view strString)
 			: eLex(eLex), strString(strString) {}
 	};
+
+private:
+	// Scan context (shared by every token of one scan)
+	struct stScanContext
+	{
+	public:
+		// Start of the source (diagnostic offsets are relative to it)
+		siter iterSource = nullptr;
+		// Symbol table the identifiers are interned into
+		CSymbolTable* pSymbols = nullptr;
+		// Diagnostics of the scan
+		CDiagnostics* pDiag = nullptr;
+	};
+
+	// Source chunk of the parallel scanner
+	struct stChunk
+	{
+	public:
+		// Chunk range (iterEnd is whitespace or the end of source)
+		siter iterBegin = nullptr;
+		siter iterEnd = nullptr;
+		// Tokens of the chunk (retagged within the chunk)
+		std::vector<stToken> vTokens;
+		// First identifier or operator token; decides the previous chunk's trailing identifier (-1 if none)
+		int nFirstDecideIdx = -1;
+		// Trailing identifier that waits for an operator in a following chunk (-1 if none)
+		int nPendingIdx = -1;
+		// Position of the first token in the stitched result
+		size_t nOffset = 0;
+		// Symbols of the chunk (merged into the global table in source order)
+		std::unique_ptr<CSymbolTable> pSymbols;
+		// Chunk symbol ID to global symbol ID
+		std::vector<SymbolID> vSymbolRemap;
+		// Diagnostics of the chunk (appended in source order)
+		CDiagnostics diag;
+	};
 // ========================================================================================
 
 
 // Variables ==============================================================================
 private:
-	static std::unordered_map<std::string, eLexEnum> m_LexMap;
 	static std::string m_strArrLex[static_cast<int>(eLexEnum::EndOfLine)];
 // ========================================================================================
 
 
 // Functions ==============================================================================
 public:
-	static std::vector<stToken> Scan(std::string strSourceCode);
-	inline static std::string FindLexToString(eLexEnum eLex)
+	static std::vector<stToken> Scan(const std::string& strSourceCode, CDiagnostics* pDiag = nullptr);
+	static std::vector<stToken> Scan(const CSourceFile& source, CDiagnostics* pDiag = nullptr);
+	static void Scan(const std::string& strSourceCode, CTokenBuffer& buffer, CDiagnostics* pDiag = nullptr);
+	static void Scan(const CSourceFile& source, CTokenBuffer& buffer, CDiagnostics* pDiag = nullptr);
+	static std::vector<stToken> ScanParallel(const std::string& strSourceCode, CThreadPool& pool, CDiagnostics* pDiag = nullptr);
+	static std::vector<stToken> ScanParallel(const CSourceFile& source, CThreadPool& pool, CDiagnostics* pDiag = nullptr);
+	inline static const std::string& FindLexToString(eLexEnum eLex)
 	{
 		return m_strArrLex[static_cast<int>(eLex)];
 	}
-
-private:
-	inline static eLexEnum FindLex(std::string strLex)
+	inline static bool IsOperPunc(eLexEnum eLex)
+	{
+		return eLex >= eLexEnum::LogicOpAnd && eLex <= eLexEnum::RightBraket;
+	}
+	inline static bool IsIdentifier(eLexEnum eLex)
 	{
-		if (m_LexMap.find(strLex) != m_LexMap.end())
-			return m_LexMap.at(strLex);
-		return eLexEnum::Unknown;
+		return eLex == eLexEnum::Identifier || eLex == eLexEnum::Variable || eLex == eLexEnum::Function;
 	}
+
+private:
+	friend class CLexerStream;
+
+	static std::vector<stToken> ScanSource(siter iter, CDiagnostics* pDiag);
+	static void ScanSource(siter iter, CTokenBuffer& buffer, CDiagnostics* pDiag);
+	static bool ScanNext(siter& iter, stToken& stTokenData, stScanContext& stContext, siter iterEnd = nullptr);
+	static std::vector<stToken> ScanParallelSource(siter iterSource, size_t nSize, CThreadPool& pool, CDiagnostics* pDiag);
+	static std::vector<siter> SplitSource(siter iterSource, size_t nSize, int nChunks, CThreadPool& pool);
+	static void ScanChunk(stChunk& stChunkData, siter iterSource);
+	static eLexEnum FindLex(std::string_view strLex);
 	static eCharType CheckCharType(char c);
 	static stToken ScanNumber(siter& iter);
+	static void DecodeNumber(stToken& stTokenData, stScanContext& stContext);
 	static stToken ScanString(siter& iter);
 	static stToken ScanIdentifierKeyword(siter& iter);
 	static stToken ScanOperPunc(siter& iter);
 
 // ========================================================================================
 
+};
+
+
+// Pull-style lexer
+// Tokens are produced one at a time, so only the few tokens held back while an
+// identifier waits for its Function/Variable retag are kept in memory.
+// The source buffer must outlive the stream and the tokens it returns.
+class CLexerStream
+{
+// Variables ==============================================================================
+private:
+	// Scanning point
+	siter m_iter;
+	// Scanned tokens that are not returned yet
+	std::deque<CLexer::stToken> m_dqPending;
+	// Index (in m_dqPending) of the identifier waiting for the next operator (-1 if none)
+	int m_nWaitIdx;
+	// Whether the end of source was reached
+	bool m_bEndOfSource;
+	// Scan context
+	CLexer::stScanContext m_stContext;
+	// Diagnostics (used when the caller gives none; printed at the end of source)
+	CDiagnostics m_diag;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CLexerStream(const std::string& strSourceCode, CDiagnostics* pDiag = nullptr);
+	CLexerStream(const CSourceFile& source, CDiagnostics* pDiag = nullptr);
+
+	bool NextToken(CLexer::stToken& stTokenData);
+
+	// Start of the source (token offsets of diagnostics are relative to it)
+	inline siter Source() const
+	{
+		return m_stContext.iterSource;
+	}
+
+// ========================================================================================
+
 };
\ No newline at end of file
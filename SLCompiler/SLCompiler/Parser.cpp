@@ -1,4 +1,6 @@
+#include <algorithm>
 #include "Parser.h"
+#include "ThreadPool.h"
 
 // Log type
 const std::string CParser::LOG_TYPE[static_cast<int>(eLogType::LogTypeMax)] =
@@ -8,44 +10,375 @@ const std::string CParser::LOG_TYPE[static_cast<int>(eLogType::LogTypeMax)] =
 	"Error"
 };
 
-// Relational operator set
-std::unordered_set<CLexer::eLexEnum> CParser::m_setRelOp = 
+/**
+@brief		Make the operator table
+			(A new operator is one more entry here; precedence climbing needs no new function)
+@return		Operator table
+*/
+static constexpr CParser::arrOperator MakeOperatorTable()
 {
-	CLexer::eLexEnum::RelOpEqual,
-	CLexer::eLexEnum::RelOpNotEqual,
-	CLexer::eLexEnum::RelOpLessThan,
-	CLexer::eLexEnum::RelOpGreaterThan,
-	CLexer::eLexEnum::RelOpLessOrEqual,
-	CLexer::eLexEnum::RelOpGreaterOrEqual,
-};
+	CParser::arrOperator arrOper{};
+	auto SetBinary = [&arrOper](CLexer::eLexEnum eLex, unsigned char nPrec, eNodeKind eKind) {
+		arrOper[static_cast<int>(eLex)].nPrec = nPrec;
+		arrOper[static_cast<int>(eLex)].eKind = eKind;
+	};
+
+	SetBinary(CLexer::eLexEnum::LogicOpOr, 1, eNodeKind::Or);
+	SetBinary(CLexer::eLexEnum::LogicOpAnd, 2, eNodeKind::And);
+	SetBinary(CLexer::eLexEnum::RelOpEqual, 3, eNodeKind::Relational);
+	SetBinary(CLexer::eLexEnum::RelOpNotEqual, 3, eNodeKind::Relational);
+	SetBinary(CLexer::eLexEnum::RelOpLessThan, 3, eNodeKind::Relational);
+	SetBinary(CLexer::eLexEnum::RelOpGreaterThan, 3, eNodeKind::Relational);
+	SetBinary(CLexer::eLexEnum::RelOpLessOrEqual, 3, eNodeKind::Relational);
+	SetBinary(CLexer::eLexEnum::RelOpGreaterOrEqual, 3, eNodeKind::Relational);
+	SetBinary(CLexer::eLexEnum::OpAdd, 4, eNodeKind::Arithmetic);
+	SetBinary(CLexer::eLexEnum::OpSubtract, 4, eNodeKind::Arithmetic);
+	SetBinary(CLexer::eLexEnum::OpMultiply, 5, eNodeKind::Arithmetic);
+	SetBinary(CLexer::eLexEnum::OpDivide, 5, eNodeKind::Arithmetic);
+	SetBinary(CLexer::eLexEnum::OpModulo, 5, eNodeKind::Arithmetic);
+
+	arrOper[static_cast<int>(CLexer::eLexEnum::OpAdd)].bPrefix = true;
+	arrOper[static_cast<int>(CLexer::eLexEnum::OpSubtract)].bPrefix = true;
+
+	return arrOper;
+}
 
-// Calculational operator set
-std::unordered_set<CLexer::eLexEnum> CParser::m_setCalOp1 =
+// Operator table
+constexpr CParser::arrOperator CParser::m_arrOperator = MakeOperatorTable();
+
+// Node count of the running parse
+thread_local size_t CParser::m_nNodeCount = 0;
+// Whether the running parse uses the explicit-stack functions
+thread_local bool CParser::m_bIterative = false;
+// Diagnostics of the running parse
+thread_local CDiagnostics* CParser::m_pDiag = nullptr;
+// Source offset of the first token of the buffer
+thread_local size_t CParser::m_nOffsetBase = 0;
+// Whether the running parse is in panic mode
+thread_local bool CParser::m_bPanic = false;
+// Stacks of the explicit-stack parser
+thread_local std::vector<CParser::stBlockFrame> CParser::m_vBlockFrame;
+thread_local std::vector<CParser::stExpFrame> CParser::m_vExpFrame;
+thread_local std::vector<CParser::stPendingOper> CParser::m_vOper;
+thread_local std::vector<stExpression*> CParser::m_vValue;
+
+/**
+@brief		Print the diagnostics the caller did not collect
+@param		diag			Diagnostics
+@param		pSource			Start of the source
+@return
+*/
+static void PrintDiagnostics(const CDiagnostics& diag, const char* pSource)
 {
-	CLexer::eLexEnum::OpMultiply,
-	CLexer::eLexEnum::OpDivide,
-	CLexer::eLexEnum::OpModulo,
-};
-std::unordered_set<CLexer::eLexEnum> CParser::m_setCalOp2 =
+	if (diag.Get().empty() == false)
+		diag.Print(pSource);
+}
+
+/**
+@brief		Whether two case values are the same constant
+@param		pLeft			Case value
+@param		pRight			Case value
+@return		Whether both are literals (numbers may have a sign) of the same type and value
+*/
+static bool IsSameCaseValue(const stExpression* pLeft, const stExpression* pRight)
 {
-	CLexer::eLexEnum::OpAdd,
-	CLexer::eLexEnum::OpSubtract,
-};
+	bool arrNegative[2] = { false, false };
+	const stExpression* arrExp[2] = { pLeft, pRight };
+
+	// "- - 1" is 1
+	for (int i = 0; i < 2; ++i)
+	{
+		while (arrExp[i] != nullptr && arrExp[i]->eKind == eNodeKind::Unary)
+		{
+			const stUnary* pUn = static_cast<const stUnary*>(arrExp[i]);
+			if (pUn->eType == CLexer::eLexEnum::OpSubtract)
+				arrNegative[i] = !arrNegative[i];
+			arrExp[i] = pUn->stSubExp;
+		}
+		if (arrExp[i] == nullptr)
+			return false;
+	}
+
+	if (arrExp[0]->eKind != arrExp[1]->eKind)
+		return false;
+
+	switch (arrExp[0]->eKind)
+	{
+		case eNodeKind::IntData:
+		{
+			long long nLeft = static_cast<const stIntData*>(arrExp[0])->nData;
+			long long nRight = static_cast<const stIntData*>(arrExp[1])->nData;
+			return (arrNegative[0] ? -nLeft : nLeft) == (arrNegative[1] ? -nRight : nRight);
+		}
+		case eNodeKind::DoubleData:
+		{
+			double dLeft = static_cast<const stDoubleData*>(arrExp[0])->dData;
+			double dRight = static_cast<const stDoubleData*>(arrExp[1])->dData;
+			return (arrNegative[0] ? -dLeft : dLeft) == (arrNegative[1] ? -dRight : dRight);
+		}
+		case eNodeKind::StringData:
+			return static_cast<const stStringData*>(arrExp[0])->strData == static_cast<const stStringData*>(arrExp[1])->strData;
+		case eNodeKind::BoolData:
+			return static_cast<const stBoolData*>(arrExp[0])->bData == static_cast<const stBoolData*>(arrExp[1])->bData;
+		case eNodeKind::NullData:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+@brief		Parser
+@param		vTokens			Token (read in place; tokens after an EndOfLine are ignored)
+@param		pDiag			Diagnostics (nullptr: printed after the parse; offsets are from the first token)
+@return		Token to "Program" structure
+*/
+stProgram* CParser::Parser(const vstToken& vTokens, CDiagnostics* pDiag)
+{
+	CTokenBuffer tokens;
+	tokens.Assign(vTokens);
+
+	return Parser(tokens, CArena::eMode::Block, eParseMode::Auto, pDiag);
+}
+
+/**
+@brief		Streaming parser
+			(Tokens are pulled one top-level function at a time into a reused buffer, so only
+			 the tokens of the largest function are held in memory)
+@param		stream			Lexer stream
+@param		eMode			Recursive or explicit-stack parsing (Auto picks by the nesting depth of each function)
+@param		pDiag			Diagnostics (nullptr: printed after the parse)
+@return		Token to "Program" structure (same as Parser)
+*/
+stProgram* CParser::Parser(CLexerStream& stream, eParseMode eMode, CDiagnostics* pDiag)
+{
+	stProgram* pProg = new stProgram();
+	CArena::CScope scope(pProg->arena);
+	CTokenBuffer tokens;
+	CLexer::stToken stTokenData;
+	CDiagnostics diagLocal;
+
+	m_nNodeCount = 1;
+	m_pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+
+	while (stream.NextToken(stTokenData))
+	{
+		// Offsets of the buffer are relative to the first token of the function
+		tokens.Reset(stTokenData.strString.data());
+
+		// Pull up to the "}" that brings the brace depth back to 0 (or the end of input)
+		size_t nDepth = 0;
+		do
+		{
+			tokens.Push(stTokenData);
+
+			if (stTokenData.eLex == CLexer::eLexEnum::LeftBrace)
+				++nDepth;
+			else if (stTokenData.eLex == CLexer::eLexEnum::RightBrace &&
+					 nDepth > 0 &&
+					 --nDepth == 0)
+				break;
+		} while (stream.NextToken(stTokenData));
+
+		// End of input of the function
+		tokens.Finish();
+
+		CTokenReader iter(tokens);
+		m_bIterative = eMode == eParseMode::Iterative ||
+			(eMode == eParseMode::Auto && MeasureNesting(tokens) > RECURSION_LIMIT);
+		m_nOffsetBase = tokens.Source() - stream.Source();
+		m_bPanic = false;
+
+		ParseFunctions(iter, tokens.Size() - 1, pProg->vFunc);
+	}
+
+	pProg->nNodeCount = m_nNodeCount;
+	m_pDiag = nullptr;
+	PrintDiagnostics(diagLocal, stream.Source());
+
+	return pProg;
+}
 
 /**
 @brief		Parser
-@param		vTokens			Token
+@param		tokens			Token buffer (ends with the EndOfLine sentinel)
+@param		eArenaMode		Node allocation of the program
+@param		eMode			Recursive or explicit-stack parsing (Auto picks by the nesting depth)
+@param		pDiag			Diagnostics (nullptr: printed after the parse)
 @return		Token to "Program" structure
+			(Syntax errors do not stop the parse: the statements and functions with errors are
+			 left out and the rest is returned; check pDiag->HasError())
 */
-stProgram* CParser::Parser(vstToken vTokens)
+stProgram* CParser::Parser(const CTokenBuffer& tokens, CArena::eMode eArenaMode, eParseMode eMode, CDiagnostics* pDiag)
 {
+	stProgram* pProg = new stProgram(eArenaMode);
+	// Nodes and their child vectors are allocated from the program's arena
+	CArena::CScope scope(pProg->arena);
+	CTokenReader iter(tokens);
+	CDiagnostics diagLocal;
+
+	m_nNodeCount = 1;
+	m_bIterative = eMode == eParseMode::Iterative ||
+		(eMode == eParseMode::Auto && MeasureNesting(tokens) > RECURSION_LIMIT);
+	m_pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+	m_nOffsetBase = 0;
+	m_bPanic = false;
+
+	ParseFunctions(iter, tokens.Size() - 1, pProg->vFunc);
+
+	pProg->nNodeCount = m_nNodeCount;
+	m_pDiag = nullptr;
+	PrintDiagnostics(diagLocal, tokens.Source());
+
+	return pProg;
+}
+
+// Token buffers smaller than this are parsed serially
+static const size_t PARALLEL_MIN_TOKENS = 64 * 1024;
+// Chunks per thread (for load balancing)
+static const int PARALLEL_CHUNKS_PER_THREAD = 4;
+
+/**
+@brief		Parallel parser
+			(Top-level functions are independent; they are split into chunks at the braces that
+			 close them and each chunk is parsed into its own arena)
+@param		tokens			Token buffer (ends with the EndOfLine sentinel)
+@param		pool			Thread pool
+@param		eMode			Recursive or explicit-stack parsing (Auto picks by the nesting depth of each chunk)
+@param		pDiag			Diagnostics (nullptr: printed after the parse)
+@return		Token to "Program" structure (same as Parser)
+*/
+stProgram* CParser::ParserParallel(const CTokenBuffer& tokens, CThreadPool& pool, eParseMode eMode, CDiagnostics* pDiag)
+{
+	int nChunks = (int)std::min<size_t>(tokens.Size() / PARALLEL_MIN_TOKENS, (size_t)pool.GetThreadCount() * PARALLEL_CHUNKS_PER_THREAD);
+	if (nChunks <= 1 ||
+		pool.GetThreadCount() == 1)
+		return Parser(tokens, CArena::eMode::Block, eMode, pDiag);
+
+	std::vector<size_t> vBoundary = SplitFunctions(tokens, nChunks);
+	std::vector<stChunk> vChunk(vBoundary.size() - 1);
+
+	pool.Run((int)vChunk.size(), [&tokens, &vBoundary, &vChunk, eMode](int nIdx) {
+		// Errors are reported by the serial parse below
+		ParseChunk(tokens, vBoundary[nIdx], vBoundary[nIdx + 1], vChunk[nIdx], nullptr, eMode);
+	});
+
+	// Merge in source order
 	stProgram* pProg = new stProgram();
-	vstToken::iterator iter = vTokens.begin();
+	pProg->nNodeCount = 1;
+
+	for (stChunk& stChunkData : vChunk)
+	{
+		// A broken function can end past its chunk; the serial parser decides what it is
+		// (and recovers across the chunk boundaries)
+		if (stChunkData.bFailed)
+		{
+			DeletePtr<stProgram>(pProg);
+			return Parser(tokens, CArena::eMode::Block, eMode, pDiag);
+		}
+
+		pProg->vFunc.insert(pProg->vFunc.end(), stChunkData.vFunc.begin(), stChunkData.vFunc.end());
+		pProg->vChunkArena.push_back(std::move(stChunkData.pArena));
+		pProg->nNodeCount += stChunkData.nNodeCount;
+	}
+
+	return pProg;
+}
+
+/**
+@brief		Parse the functions of a token range into the arena of a chunk
+@param		tokens			Token buffer
+@param		nBegin			First token (a function boundary)
+@param		nEnd			End token (a function boundary or the EndOfLine sentinel)
+@param		stChunkData		(out) Chunk (a new arena is made if it has none)
+@param		pDiag			Diagnostics (nullptr: dropped)
+@param		eMode			Recursive or explicit-stack parsing (Auto picks by the nesting depth of the range)
+@param		nOffsetBase		Added to the token offsets of the buffer (node and diagnostic offsets; wraps
+							around, so it can also move the offsets back)
+@return
+@details	bFailed is set if there were errors or the last function ran past nEnd.
+*/
+void CParser::ParseChunk(const CTokenBuffer& tokens, size_t nBegin, size_t nEnd, stChunk& stChunkData, CDiagnostics* pDiag, eParseMode eMode, size_t nOffsetBase)
+{
+	if (stChunkData.pArena == nullptr)
+		stChunkData.pArena.reset(new CArena());
+
+	CArena::CScope scope(*stChunkData.pArena);
+	CTokenReader iter(tokens, nBegin);
+	CDiagnostics diagLocal;
+
+	m_nNodeCount = 0;
+	m_bIterative = eMode == eParseMode::Iterative ||
+		(eMode == eParseMode::Auto && MeasureNesting(tokens, nBegin, nEnd) > RECURSION_LIMIT);
+	m_pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+	m_nOffsetBase = nOffsetBase;
+	m_bPanic = false;
+
+	stChunkData.bFailed = ParseFunctions(iter, nEnd, stChunkData.vFunc) == false ||
+		iter.Position() != nEnd;
+	stChunkData.nNodeCount = m_nNodeCount;
+	m_pDiag = nullptr;
+}
+
+/**
+@brief		Find chunk boundaries between top-level functions
+@param		tokens			Token buffer
+@param		nChunks			Wanted chunk count
+@return		Chunk boundaries (token indices; first is 0, last is the EndOfLine sentinel)
+@details	A function ends at the "}" that brings the brace depth back to 0. Chunks are cut
+			at the first function end after each nominal (equal token count) boundary.
+*/
+std::vector<size_t> CParser::SplitFunctions(const CTokenBuffer& tokens, int nChunks)
+{
+	const unsigned char* pKind = tokens.KindData();
+	size_t nEnd = tokens.Size() - 1;
+	size_t nDepth = 0;
+	std::vector<size_t> vBoundary;
+
+	vBoundary.push_back(0);
+	size_t nTarget = nEnd / nChunks;
+
+	for (size_t i = 0; i < nEnd; ++i)
+	{
+		CLexer::eLexEnum eLex = static_cast<CLexer::eLexEnum>(pKind[i]);
+
+		if (eLex == CLexer::eLexEnum::LeftBrace)
+		{
+			++nDepth;
+		}
+		else if (eLex == CLexer::eLexEnum::RightBrace &&
+				 nDepth > 0 &&
+				 --nDepth == 0 &&
+				 i + 1 >= nTarget &&
+				 i + 1 < nEnd &&
+				 vBoundary.size() < (size_t)nChunks)
+		{
+			vBoundary.push_back(i + 1);
+			nTarget = nEnd / nChunks * vBoundary.size();
+		}
+	}
+
+	vBoundary.push_back(nEnd);
+
+	return vBoundary;
+}
+
+/**
+@brief		Top-level parser ("type Function(...) {...}" up to nEnd)
+@param		iter		Token iterator
+@param		nEnd		End token index (a function boundary or the EndOfLine sentinel)
+@param		vFunc		(out) Functions
+@return		Whether every function was parsed without errors
+*/
+bool CParser::ParseFunctions(CTokenReader& iter, size_t nEnd, std::vector<stFunction*>& vFunc)
+{
 	CLexer::eLexEnum eType = CLexer::eLexEnum::Unknown;
+	size_t nErrors = m_pDiag->ErrorCount();
 
-	while (iter->eLex != CLexer::eLexEnum::EndOfLine)
+	while (iter.Position() < nEnd &&
+		   iter.Lex() != CLexer::eLexEnum::EndOfLine)
 	{
-		switch (iter->eLex)
+		switch (iter.Lex())
 		{
 			case CLexer::eLexEnum::True:
 			case CLexer::eLexEnum::False:
@@ -53,29 +386,37 @@ stProgram* CParser::Parser(vstToken vTokens)
 			case CLexer::eLexEnum::Double:
 			case CLexer::eLexEnum::String:
 			case CLexer::eLexEnum::Void:
-				eType = iter->eLex;
+				eType = iter.Lex();
+				NextIter(eType, iter);
 				break;
 			case CLexer::eLexEnum::Function:
+			{
 				if (eType == CLexer::eLexEnum::Unknown)
 				{
-					// Error
+					ReportError(iter, "Function return type is missing.");
+					SkipToFunction(iter);
 					break;
 				}
-				pProg->vFunc.push_back(ParseFunction(eType, iter));
+
+				// A function with a broken header is left out; one that runs into the end of
+				// input keeps the statements parsed so far
+				stFunction* pFunc = ParseFunction(eType, iter);
 				eType = CLexer::eLexEnum::Unknown;
+
+				if (pFunc != nullptr)
+					vFunc.push_back(pFunc);
+				if (m_bPanic)
+					SkipToFunction(iter);
 				break;
+			}
 			default:
+				ReportError(iter, "Unexpected token '" + std::string(iter.String()) + "'.");
+				SkipToFunction(iter);
 				break;
 		}
-
-		if (pProg->vFunc[pProg->vFunc.size() - 1] == nullptr)
-		{
-			DeletePtr<stProgram>(pProg);
-			return nullptr;
-		}
 	}
 
-	return pProg;
+	return m_pDiag->ErrorCount() == nErrors;
 }
 
 /**
@@ -95,50 +436,48 @@ inline void CParser::PrintLog(eLogType eType, std::string strLog)
 @param		iter		Token iterator
 @return		Token to "Function" structure
 */
-stFunction* CParser::ParseFunction(CLexer::eLexEnum eType, vstToken::iterator& iter)
+stFunction* CParser::ParseFunction(CLexer::eLexEnum eType, CTokenReader& iter)
 {
-	stFunction* pFunc = new stFunction();
+	stFunction* pFunc = NewNode<stFunction>(NodeOffset(iter));
+	pFunc->eType = eType;
 
-	// Check Function
+	// Check function name (function name is 'Function' type)
+	pFunc->nSymbol = iter.Symbol();
 	NextIter(CLexer::eLexEnum::Function, iter);
 
-	// Check function name (function name is 'Identifier' type)
-	pFunc->strName = iter->strString;
-	NextIter(CLexer::eLexEnum::Identifier, iter);
-
 	// Check function parameters
 	// Check "("
 	NextIter(CLexer::eLexEnum::LeftParent, iter);
 	{
 		// if parameter is not empty
-		if (iter->eLex != CLexer::eLexEnum::RightParent)
+		if (iter.Lex() != CLexer::eLexEnum::RightParent)
 		{
-			// Check next parameters
-			// Check comma
-			while (NextIter(CLexer::eLexEnum::Comma, iter, false))
+			do
 			{
+				// Check parameter type (optional)
+				CLexer::eLexEnum eParamType = CLexer::eLexEnum::Unknown;
+				if (IsDeclaration(iter))
+				{
+					eParamType = iter.Lex();
+					NextIter(eParamType, iter);
+				}
+
 				// Check parameter name
-				pFunc->vParams.push_back(iter->strString);
-				NextIter(CLexer::eLexEnum::Identifier, iter);
-			}
+				pFunc->vParams.push_back(NextName(iter));
+				pFunc->vParamTypes.push_back(eParamType);
+			} while (NextIter(CLexer::eLexEnum::Comma, iter, false));
 		}
 	}
 	// Check ")"
 	NextIter(CLexer::eLexEnum::RightParent, iter);
 
 	// Check function block
-	// Check "{"
-	NextIter(CLexer::eLexEnum::LeftBrace, iter);
+	// Check "{" (the caller skips the function if its header is broken)
+	if (m_bPanic ||
+		NextIter(CLexer::eLexEnum::LeftBrace, iter) == false)
+		return nullptr;
 	{
-		pFunc->vBlock = ParseBlock(eType, iter);
-
-		if (pFunc->vBlock.size() == 1 &&
-			pFunc->vBlock[0] == nullptr)
-		{
-			PrintLog(eLogType::Error, "Block parse failed.");
-			DeletePtr<stFunction>(pFunc);
-			return nullptr;
-		}
+		pFunc->vBlock = m_bIterative ? ParseBlockIterative(iter) : ParseBlock(iter);
 	}
 	// Check "}"
 	NextIter(CLexer::eLexEnum::RightBrace, iter);
@@ -151,30 +490,29 @@ stFunction* CParser::ParseFunction(CLexer::eLexEnum eType, vstToken::iterator& i
 @param		iter		Token iterator
 @return		Token to "Variable" structure
 */
-stVariable* CParser::ParseVariable(vstToken::iterator& iter)
+stVariable* CParser::ParseVariable(CTokenReader& iter)
 {
-	stVariable* pVar = new stVariable();
-	CLexer::eLexEnum eArrType[] = { CLexer::eLexEnum::Void, CLexer::eLexEnum::Int, CLexer::eLexEnum::Double, CLexer::eLexEnum::String };
-	int nSize = sizeof(eArrType) / sizeof(CLexer::eLexEnum);
+	stVariable* pVar = NewNode<stVariable>(NodeOffset(iter));
 
-	for (int i = 0; i < nSize; ++i)
+	// Check data type
+	pVar->eType = iter.Lex();
+	NextIter(pVar->eType, iter);
+
+	// Check variable name
+	pVar->nSymbol = NextName(iter);
+
+	// Check assignment and expression (optional)
+	if (NextIter(CLexer::eLexEnum::Assignment, iter, false))
 	{
-		// Check Variable
-		if (NextIter(eArrType[i], iter, false))
-		{
-			pVar->eType = eArrType[i];
+		pVar->stExp = ParseExpression(iter);
 
-			// Check variable name
-			pVar->strName = iter->strString;
-			NextIter(CLexer::eLexEnum::Identifier, iter);
-			break;
+		if (pVar->stExp == nullptr)
+		{
+			ReportError(iter, "Variable expression is null.");
+			return nullptr;
 		}
 	}
 
-	// Check assignment and expression
-	NextIter(CLexer::eLexEnum::Assignment, iter);
-	pVar->stExp = ParseExpression(iter);
-
 	// Check semicolon
 	NextIter(CLexer::eLexEnum::Semicolon, iter);
 
@@ -186,9 +524,9 @@ stVariable* CParser::ParseVariable(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Expression statement" structure
 */
-stExpStatement* CParser::ParseExpStatement(vstToken::iterator& iter)
+stExpStatement* CParser::ParseExpStatement(CTokenReader& iter)
 {
-	stExpStatement* pExp = new stExpStatement();
+	stExpStatement* pExp = NewNode<stExpStatement>(NodeOffset(iter));
 
 	// Check expression
 	pExp->stExp = ParseExpression(iter);
@@ -204,9 +542,9 @@ stExpStatement* CParser::ParseExpStatement(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Expression" structure
 */
-stExpression* CParser::ParseExpression(vstToken::iterator& iter)
+stExpression* CParser::ParseExpression(CTokenReader& iter)
 {
-	stExpression* pExp = ParseOr(iter);
+	stExpression* pExp = m_bIterative ? ParseExpressionIterative(iter) : ParseBinary(1, iter);
 	
 	// TODO Input Code ParseExpression
 
@@ -215,27 +553,25 @@ stExpression* CParser::ParseExpression(vstToken::iterator& iter)
 
 /**
 @brief		Return parser
-@param		eType		Return type
 @param		iter		Token iterator
 @return		Token to "Return statement" structure
 */
-stStatement* CParser::ParseReturn(CLexer::eLexEnum eType, vstToken::iterator& iter)
+stStatement* CParser::ParseReturn(CTokenReader& iter)
 {
-	stReturn* pReturn = new stReturn();
+	stReturn* pReturn = NewNode<stReturn>(NodeOffset(iter));
 
 	// Check Return
 	NextIter(CLexer::eLexEnum::Return, iter);
 
-	// Check return type
-	// if function's return
-	if (eType != CLexer::eLexEnum::Unknown)
+	// Check return expression
+	// (empty if "return;")
+	if (iter.Lex() != CLexer::eLexEnum::Semicolon)
 	{
 		pReturn->stExp = ParseExpression(iter);
 
 		if (pReturn->stExp == nullptr)
 		{
-			PrintLog(eLogType::Error, "Return expression is null.");
-			DeletePtr<stReturn>(pReturn);
+			ReportError(iter, "Return expression is null.");
 			return nullptr;
 		}
 	}
@@ -247,13 +583,13 @@ stStatement* CParser::ParseReturn(CLexer::eLexEnum eType, vstToken::iterator& it
 }
 
 /**
-@brief		For parser
+@brief		For header parser ("for (init; condition; loop)")
 @param		iter		Token iterator
-@return		Token to "For statement" structure
+@return		Token to "For statement" structure (without the block)
 */
-stStatement* CParser::ParseFor(vstToken::iterator& iter)
+stFor* CParser::ParseForHeader(CTokenReader& iter)
 {
-	stFor* pFor = new stFor();
+	stFor* pFor = NewNode<stFor>(NodeOffset(iter));
 
 	// Check For
 	NextIter(CLexer::eLexEnum::For, iter);
@@ -266,48 +602,60 @@ stStatement* CParser::ParseFor(vstToken::iterator& iter)
 		// (if init expression is empty)
 		if (NextIter(CLexer::eLexEnum::Semicolon, iter, false) == false)
 		{
-			// Check "int"
+			// Check "int" variable
 			// (For statement factor must be integer type)
-			NextIter(CLexer::eLexEnum::Int, iter);
-			pFor->stVar = new stVariable();
-
-			// Check variable name
-			pFor->stVar->strName = iter->strString;
-			NextIter(CLexer::eLexEnum::Identifier, iter);
-
-			// Check variable expression
-			NextIter(CLexer::eLexEnum::Assignment, iter);
-			pFor->stVar->stExp = ParseExpression(iter);
-			if (pFor->stVar->stExp == nullptr)
+			if (iter.Lex() != CLexer::eLexEnum::Int ||
+				IsDeclaration(iter) == false)
 			{
-				PrintLog(eLogType::Error, "For expression is null.");
-				DeletePtr<stFor>(pFor);
+				ReportError(iter, "For init-statement is not an int variable.");
 				return nullptr;
 			}
 
-			// Check semicolon
-			NextIter(CLexer::eLexEnum::Semicolon, iter);
+			// Check variable (and semicolon)
+			pFor->stVar = ParseVariable(iter);
+			if (pFor->stVar == nullptr)
+			{
+				ReportError(iter, "For expression is null.");
+				return nullptr;
+			}
 		}
 
-		// Check semicolon
+		// Check condition expression
 		// (if condition expression is empty)
-		if (NextIter(CLexer::eLexEnum::Semicolon, iter, false) == false)
-		{
-			// Check condition expression
+		if (iter.Lex() != CLexer::eLexEnum::Semicolon)
 			pFor->stCondExp = ParseExpression(iter);
-		}
+
+		// Check semicolon
+		NextIter(CLexer::eLexEnum::Semicolon, iter);
 
 		// Check loop expression
-		pFor->stLoopExp = ParseExpression(iter);
+		// (if loop expression is empty)
+		if (iter.Lex() != CLexer::eLexEnum::RightParent)
+			pFor->stLoopExp = ParseExpression(iter);
 	}
 	// Check ")"
 	NextIter(CLexer::eLexEnum::RightParent, iter);
 
-	// Check "{"
-	NextIter(CLexer::eLexEnum::LeftBrace, iter);
+	return pFor;
+}
+
+/**
+@brief		For parser
+@param		iter		Token iterator
+@return		Token to "For statement" structure
+*/
+stStatement* CParser::ParseFor(CTokenReader& iter)
+{
+	stFor* pFor = ParseForHeader(iter);
+
+	// Check "{" (the caller skips the block if the header is broken)
+	if (pFor == nullptr ||
+		m_bPanic ||
+		NextIter(CLexer::eLexEnum::LeftBrace, iter) == false)
+		return nullptr;
 	{
 		// Check for block
-		pFor->stBlock = ParseBlock(CLexer::eLexEnum::Unknown, iter);
+		pFor->stBlock = ParseBlock(iter);
 	}
 	// Check "}"
 	NextIter(CLexer::eLexEnum::RightBrace, iter);
@@ -316,13 +664,13 @@ stStatement* CParser::ParseFor(vstToken::iterator& iter)
 }
 
 /**
-@brief		While parser
+@brief		While header parser ("while (condition)")
 @param		iter		Token iterator
-@return		Token to "While statement" structure
+@return		Token to "While statement" structure (without the block)
 */
-stStatement* CParser::ParseWhile(vstToken::iterator& iter)
+stWhile* CParser::ParseWhileHeader(CTokenReader& iter)
 {
-	stWhile* pWhile = new stWhile();
+	stWhile* pWhile = NewNode<stWhile>(NodeOffset(iter));
 	
 	// Check While
 	NextIter(CLexer::eLexEnum::While, iter);
@@ -335,19 +683,33 @@ stStatement* CParser::ParseWhile(vstToken::iterator& iter)
 
 		if (pWhile->stCondExp == nullptr)
 		{
-			PrintLog(eLogType::Error, "While expression is null.");
-			DeletePtr<stWhile>(pWhile);
+			ReportError(iter, "While expression is null.");
 			return nullptr;
 		}
 	}
 	// Check ")"
 	NextIter(CLexer::eLexEnum::RightParent, iter);
 
-	// Check "{"
-	NextIter(CLexer::eLexEnum::LeftBrace, iter);
+	return pWhile;
+}
+
+/**
+@brief		While parser
+@param		iter		Token iterator
+@return		Token to "While statement" structure
+*/
+stStatement* CParser::ParseWhile(CTokenReader& iter)
+{
+	stWhile* pWhile = ParseWhileHeader(iter);
+
+	// Check "{" (the caller skips the block if the header is broken)
+	if (pWhile == nullptr ||
+		m_bPanic ||
+		NextIter(CLexer::eLexEnum::LeftBrace, iter) == false)
+		return nullptr;
 	{
-		// Check for block
-		pWhile->stBlock = ParseBlock(CLexer::eLexEnum::Unknown, iter);
+		// Check while block
+		pWhile->stBlock = ParseBlock(iter);
 	}
 	// Check "}"
 	NextIter(CLexer::eLexEnum::RightBrace, iter);
@@ -355,65 +717,69 @@ stStatement* CParser::ParseWhile(vstToken::iterator& iter)
 	return pWhile;
 }
 
+/**
+@brief		If condition parser ("(condition)" of if or else if)
+@param		pIf			If statement (the condition is added to it)
+@param		iter		Token iterator
+@return		Whether the condition was parsed
+*/
+bool CParser::ParseIfCondition(stIf* pIf, CTokenReader& iter)
+{
+	// Check "("
+	NextIter(CLexer::eLexEnum::LeftParent, iter);
+	{
+		pIf->stCondStm.push_back(ParseExpression(iter));
+
+		if (pIf->stCondStm[pIf->stCondStm.size() - 1] == nullptr)
+		{
+			ReportError(iter, "If expression is null.");
+			return false;
+		}
+	}
+	// Check ")"
+	NextIter(CLexer::eLexEnum::RightParent, iter);
+
+	return true;
+}
+
 /**
 @brief		If parser
 @param		iter		Token iterator
 @return		Token to "If statement" structure
 */
-stStatement* CParser::ParseIf(vstToken::iterator& iter)
+stStatement* CParser::ParseIf(CTokenReader& iter)
 {
-	stIf* pIf = new stIf();
+	stIf* pIf = NewNode<stIf>(NodeOffset(iter));
 
 	// Check If
 	NextIter(CLexer::eLexEnum::If, iter);
+	do
 	{
 		// Check if expression
-		// Check "("
-		NextIter(CLexer::eLexEnum::LeftParent, iter);
-		{
-			pIf->stCondStm.push_back(ParseExpression(iter));
-		}
-		// Check ")"
-		NextIter(CLexer::eLexEnum::RightParent, iter);
-
-		// Check "{"
-		NextIter(CLexer::eLexEnum::LeftBrace, iter);
+		// Check "{" (the caller skips the rest of the statement if the condition is broken)
+		if (ParseIfCondition(pIf, iter) == false ||
+			m_bPanic ||
+			NextIter(CLexer::eLexEnum::LeftBrace, iter) == false)
+			return nullptr;
 		{
-			// Check for block
-			pIf->vIfBlock.push_back(ParseBlock(CLexer::eLexEnum::Unknown, iter));
+			// Check if block
+			pIf->vIfBlock.push_back(ParseBlock(iter));
 		}
 		// Check "}"
 		NextIter(CLexer::eLexEnum::RightBrace, iter);
 	}
 	// Check "else if"
-	while (NextIter(CLexer::eLexEnum::Elif, iter, false))
-	{
-		// Check if expression
-		// Check "("
-		NextIter(CLexer::eLexEnum::LeftParent, iter);
-		{
-			pIf->stCondStm.push_back(ParseExpression(iter));
-		}
-		// Check ")"
-		NextIter(CLexer::eLexEnum::RightParent, iter);
+	while (NextIter(CLexer::eLexEnum::Elif, iter, false));
 
-		// Check "{"
-		NextIter(CLexer::eLexEnum::LeftBrace, iter);
-		{
-			// Check for block
-			pIf->vIfBlock.push_back(ParseBlock(CLexer::eLexEnum::Unknown, iter));
-		}
-		// Check "}"
-		NextIter(CLexer::eLexEnum::RightBrace, iter);
-	}
 	// Check "else"
-	if (NextIter(CLexer::eLexEnum::If, iter, false))
+	if (NextIter(CLexer::eLexEnum::Else, iter, false))
 	{
 		// Check "{"
-		NextIter(CLexer::eLexEnum::LeftBrace, iter);
+		if (NextIter(CLexer::eLexEnum::LeftBrace, iter) == false)
+			return nullptr;
 		{
-			// Check for block
-			pIf->vElseBlock = ParseBlock(CLexer::eLexEnum::Unknown, iter);
+			// Check else block
+			pIf->vElseBlock = ParseBlock(iter);
 		}
 		// Check "}"
 		NextIter(CLexer::eLexEnum::RightBrace, iter);
@@ -423,13 +789,13 @@ stStatement* CParser::ParseIf(vstToken::iterator& iter)
 }
 
 /**
-@brief		Switch parser
+@brief		Switch header parser ("switch (expression)")
 @param		iter		Token iterator
-@return		Token to "Switch statement" structure
+@return		Token to "Switch statement" structure (without the blocks)
 */
-stStatement* CParser::ParseSwitch(vstToken::iterator& iter)
+stSwitch* CParser::ParseSwitchHeader(CTokenReader& iter)
 {
-	stSwitch* pSwitch = new stSwitch();
+	stSwitch* pSwitch = NewNode<stSwitch>(NodeOffset(iter));
 
 	// Check Switch
 	NextIter(CLexer::eLexEnum::Switch, iter);
@@ -442,16 +808,107 @@ stStatement* CParser::ParseSwitch(vstToken::iterator& iter)
 	// Check ")"
 	NextIter(CLexer::eLexEnum::RightParent, iter);
 
-	// Check "{"
-	NextIter(CLexer::eLexEnum::LeftBrace, iter);
+	return pSwitch;
+}
+
+/**
+@brief		Case label parser ("case expression:" or "default:")
+@param		pSwitch		Switch statement (the case condition or the default position is added to it)
+@param		bDefault	(out) Whether the label is default
+@param		iter		Token iterator
+@return		Whether the label was parsed
+			(A broken or duplicate label is skipped with its statements up to the next label or "}")
+*/
+bool CParser::ParseCaseLabel(stSwitch* pSwitch, bool& bDefault, CTokenReader& iter)
+{
+	size_t nStart = iter.Position();
+	CTokenReader iterLabel = iter;
+
+	// Check Case
+	if (NextIter(CLexer::eLexEnum::Case, iter, false))
+	{
+		// Check codition statement
+		CTokenReader iterCond = iter;
+		stExpression* pCond = ParseExpression(iter);
+		if (pCond == nullptr)
+			ReportError(iter, "Case expression is null.");
+		NextIter(CLexer::eLexEnum::Colon, iter);
+
+		for (size_t i = 0; m_bPanic == false && i < pSwitch->stCondStm.size(); ++i)
+		{
+			if (IsSameCaseValue(pSwitch->stCondStm[i], pCond))
+				ReportError(iterCond, "Duplicate case value.");
+		}
+
+		if (m_bPanic == false)
+		{
+			pSwitch->stCondStm.push_back(pCond);
+			bDefault = false;
+			return true;
+		}
+	}
+	// Check Default
+	else if (NextIter(CLexer::eLexEnum::Default, iter, false))
+	{
+		NextIter(CLexer::eLexEnum::Colon, iter);
+
+		if (m_bPanic == false && pSwitch->nDefaultIdx != -1)
+			ReportError(iterLabel, "Duplicate default label.");
+
+		if (m_bPanic == false)
+		{
+			// The default runs before the cases that follow it when it falls through
+			pSwitch->nDefaultIdx = (int)pSwitch->stCondStm.size();
+			bDefault = true;
+			return true;
+		}
+	}
+	else
+	{
+		ReportError(iter, "Switch block is not case or default.");
+	}
+
+	do
+	{
+		Synchronize(iter, nStart, true);
+		nStart = iter.Position();
+	} while (iter.Lex() != CLexer::eLexEnum::Case &&
+			 iter.Lex() != CLexer::eLexEnum::Default &&
+			 iter.Lex() != CLexer::eLexEnum::RightBrace &&
+			 iter.Lex() != CLexer::eLexEnum::EndOfLine);
+
+	return false;
+}
+
+/**
+@brief		Switch parser
+@param		iter		Token iterator
+@return		Token to "Switch statement" structure
+*/
+stStatement* CParser::ParseSwitch(CTokenReader& iter)
+{
+	stSwitch* pSwitch = ParseSwitchHeader(iter);
+
+	// Check "{" (the caller skips the blocks if the header is broken)
+	if (m_bPanic ||
+		NextIter(CLexer::eLexEnum::LeftBrace, iter) == false)
+		return nullptr;
 	{
-		// Check Case
-		while (NextIter(CLexer::eLexEnum::Case, iter, false))
+		while (iter.Lex() != CLexer::eLexEnum::RightBrace &&
+			   iter.Lex() != CLexer::eLexEnum::EndOfLine)
 		{
-			// Check codition statement
-			pSwitch->stCondStm.push_back(ParseIntData(iter));
-			NextIter(CLexer::eLexEnum::Colon, iter);
-			pSwitch->vCaseBlock.push_back(ParseBlock(CLexer::eLexEnum::Unknown, iter));
+			bool bDefault = false;
+
+			// A broken label was skipped up to the next one
+			if (ParseCaseLabel(pSwitch, bDefault, iter) == false)
+				continue;
+
+			vstStatement vBlock = ParseBlock(iter, true);
+
+			if (bDefault)
+				pSwitch->vDefaultBlock = std::move(vBlock);
+			else
+				pSwitch->vCaseBlock.push_back(std::move(vBlock));
 		}
 	}
 	// Check "}"
@@ -460,14 +917,14 @@ stStatement* CParser::ParseSwitch(vstToken::iterator& iter)
 	return pSwitch;
 }
 
-/**	
+/**
 @brief		Break parser
 @param		iter		Token iterator
 @return		Token to "Break statement" structure
 */
-stStatement* CParser::ParseBreak(vstToken::iterator& iter)
+stStatement* CParser::ParseBreak(CTokenReader& iter)
 {
-	stBreak* pBreak = new stBreak();
+	stBreak* pBreak = NewNode<stBreak>(NodeOffset(iter));
 
 	// Check Break
 	NextIter(CLexer::eLexEnum::Break, iter);
@@ -483,9 +940,9 @@ stStatement* CParser::ParseBreak(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Continue statement" structure
 */
-stStatement* CParser::ParseContinue(vstToken::iterator& iter)
+stStatement* CParser::ParseContinue(CTokenReader& iter)
 {
-	stContinue* pContinue = new stContinue();
+	stContinue* pContinue = NewNode<stContinue>(NodeOffset(iter));
 
 	// Check Continue
 	NextIter(CLexer::eLexEnum::Continue, iter);
@@ -501,9 +958,9 @@ stStatement* CParser::ParseContinue(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Printf statement" structure
 */
-stStatement* CParser::ParsePrintf(vstToken::iterator& iter)
+stStatement* CParser::ParsePrintf(CTokenReader& iter)
 {
-	stPrint* pPrint = new stPrint();
+	stPrint* pPrint = NewNode<stPrint>(NodeOffset(iter));
 
 	// Check Printf
 	if (NextIter(CLexer::eLexEnum::Printf, iter, false))
@@ -513,18 +970,31 @@ stStatement* CParser::ParsePrintf(vstToken::iterator& iter)
 		{
 			// Type1: printf("String");
 			// Type2: printf("%d", num);
-			while (iter->eLex != CLexer::eLexEnum::RightParent)
+			pPrint->strFormat = CArena::Current()->CopyString(iter.String());
+			NextIter(CLexer::eLexEnum::String, iter);
+
+			// Check arguments
+			while (NextIter(CLexer::eLexEnum::Comma, iter, false))
 			{
-				// TODO print Ľ
+				stExpression* pArg = ParseExpression(iter);
+
+				if (pArg == nullptr)
+				{
+					ReportError(iter, "Print argument is null.");
+					return nullptr;
+				}
+				pPrint->stArgs.push_back(pArg);
 			}
 		}
 		// Check ")"
 		NextIter(CLexer::eLexEnum::RightParent, iter);
+
+		// Check semicolon
+		NextIter(CLexer::eLexEnum::Semicolon, iter);
 	}
 	else
 	{
-		PrintLog(eLogType::Error, "Print statement is null.");
-		DeletePtr<stPrint>(pPrint);
+		ReportError(iter, "Print statement is null.");
 		return nullptr;
 	}
 
@@ -536,11 +1006,11 @@ stStatement* CParser::ParsePrintf(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Data type expression" structure
 */
-stExpression* CParser::ParseDataType(vstToken::iterator& iter)
+stExpression* CParser::ParseDataType(CTokenReader& iter)
 {
 	stExpression* pExp = nullptr;
 
-	switch (iter->eLex)
+	switch (iter.Lex())
 	{
 		case CLexer::eLexEnum::Null:
 			pExp = ParseNullData(iter);
@@ -562,11 +1032,21 @@ stExpression* CParser::ParseDataType(vstToken::iterator& iter)
 			pExp = ParseVoidData(iter);
 			break;
 		case CLexer::eLexEnum::Identifier:
+		case CLexer::eLexEnum::Variable:
+		case CLexer::eLexEnum::Function:
 			pExp = ParseIdentifier(iter);
 			break;
+		case CLexer::eLexEnum::LeftParent:
+			pExp = ParseParenthesis(iter);
+			break;
 		case CLexer::eLexEnum::LeftBraket:	// <-- Array
 			pExp = ParseArrayData(iter);
 			break;
+		default:
+			ReportError(iter, iter.Lex() == CLexer::eLexEnum::EndOfLine ?
+				"Expression expected before the end of input." :
+				"Expression expected at '" + std::string(iter.String()) + "'.");
+			break;
 	}
 
 	return pExp;
@@ -577,9 +1057,9 @@ stExpression* CParser::ParseDataType(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Null data" structure
 */
-stExpression* CParser::ParseNullData(vstToken::iterator& iter)
+stExpression* CParser::ParseNullData(CTokenReader& iter)
 {
-	stNullData* pNull = new stNullData();
+	stNullData* pNull = NewNode<stNullData>(NodeOffset(iter));
 
 	// Check Null data
 	NextIter(CLexer::eLexEnum::Null, iter);
@@ -592,13 +1072,13 @@ stExpression* CParser::ParseNullData(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Boolean data" structure
 */
-stExpression* CParser::ParseBooleanData(vstToken::iterator& iter)
+stExpression* CParser::ParseBooleanData(CTokenReader& iter)
 {
-	stBoolData* pBool = new stBoolData();
+	stBoolData* pBool = NewNode<stBoolData>(NodeOffset(iter));
 
 	// Check Boolean (True or False) data
-	pBool->bData = iter->eLex == CLexer::eLexEnum::True;
-	NextIter(iter->eLex, iter);
+	pBool->bData = iter.Lex() == CLexer::eLexEnum::True;
+	NextIter(iter.Lex(), iter);
 
 	return pBool;
 }
@@ -608,12 +1088,12 @@ stExpression* CParser::ParseBooleanData(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Integer data" structure
 */
-stExpression* CParser::ParseIntData(vstToken::iterator& iter)
+stExpression* CParser::ParseIntData(CTokenReader& iter)
 {
-	stIntData* pInt = new stIntData();
+	stIntData* pInt = NewNode<stIntData>(NodeOffset(iter));
 
 	// Check Integer data
-	pInt->nData = std::stoi(iter->strString);
+	pInt->nData = iter.Int();
 	NextIter(CLexer::eLexEnum::Int, iter);
 
 	return pInt;
@@ -624,10 +1104,10 @@ stExpression* CParser::ParseIntData(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Double data" structure
 */
-stExpression* CParser::ParseDoubleData(vstToken::iterator& iter)
+stExpression* CParser::ParseDoubleData(CTokenReader& iter)
 {
-	stDoubleData* pDouble = new stDoubleData();
-	pDouble->dData = std::stod(iter->strString);
+	stDoubleData* pDouble = NewNode<stDoubleData>(NodeOffset(iter));
+	pDouble->dData = iter.Double();
 	NextIter(CLexer::eLexEnum::Double, iter);
 
 	return pDouble;
@@ -638,10 +1118,10 @@ stExpression* CParser::ParseDoubleData(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "String data" structure
 */
-stExpression* CParser::ParseStringData(vstToken::iterator& iter)
+stExpression* CParser::ParseStringData(CTokenReader& iter)
 {
-	stStringData* pString = new stStringData();
-	pString->strData = iter->strString;
+	stStringData* pString = NewNode<stStringData>(NodeOffset(iter));
+	pString->strData = CArena::Current()->CopyString(iter.String());
 	NextIter(CLexer::eLexEnum::String, iter);
 
 	return pString;
@@ -652,9 +1132,9 @@ stExpression* CParser::ParseStringData(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Void data" structure
 */
-stExpression* CParser::ParseVoidData(vstToken::iterator& iter)
+stExpression* CParser::ParseVoidData(CTokenReader& iter)
 {
-	stVoidData* pVoid = new stVoidData();
+	stVoidData* pVoid = NewNode<stVoidData>(NodeOffset(iter));
 	NextIter(CLexer::eLexEnum::Void, iter);
 
 	return pVoid;
@@ -665,21 +1145,24 @@ stExpression* CParser::ParseVoidData(vstToken::iterator& iter)
 @param		iter		Token iterator
 @return		Token to "Array data" structure
 */
-stExpression* CParser::ParseArrayData(vstToken::iterator& iter)
+stExpression* CParser::ParseArrayData(CTokenReader& iter)
 {
+	unsigned int nOffset = NodeOffset(iter);
 	NextIter(CLexer::eLexEnum::LeftBraket, iter);
 
-	if (iter->eLex != CLexer::eLexEnum::Int)
+	if (iter.Lex() != CLexer::eLexEnum::Int)
 		return nullptr;
 
-	int nSize = std::stoi(iter->strString);
+	int nSize = iter.Int();
+
 	if (nSize <= 0)
 		return nullptr;
 
-	stArray* pArray = new stArray(nSize);
+	stArray* pArray = NewNode<stArray>(nOffset, nSize);
 
 	NextIter(CLexer::eLexEnum::Int, iter);
-	if (iter->eLex != CLexer::eLexEnum::Semicolon)
+	NextIter(CLexer::eLexEnum::RightBraket, iter);
+	if (iter.Lex() != CLexer::eLexEnum::Semicolon)
 	{
 		// TODO 迭  ִ  
 	}
@@ -688,211 +1171,415 @@ stExpression* CParser::ParseArrayData(vstToken::iterator& iter)
 }
 
 /**
-@brief		And parser
+@brief		Binary expression parser (precedence climbing over m_arrOperator)
+@param		nMinPrec	Lowest operator precedence that is taken
 @param		iter		Token iterator
-@return		Token to "And expression" structure
+@return		Token to "And", "Or", "Relational" or "Arithmetic expression" structure
 */
-stExpression* CParser::ParseAnd(vstToken::iterator& iter)
+stExpression* CParser::ParseBinary(int nMinPrec, CTokenReader& iter)
 {
-	stExpression* pRel = ParseRelational(iter);
+	stExpression* pLeft = ParseUnary(iter);
 
-	while (NextIter(CLexer::eLexEnum::LogicOpAnd, iter, false))
+	for (;;)
 	{
-		stAnd* pAnd = new stAnd();
-		pAnd->stLeft = pRel;
-		pAnd->stRight = ParseRelational(iter);
-		pRel = pAnd;
+		CLexer::eLexEnum eOp = iter.Lex();
+		const stOperator& stOper = m_arrOperator[static_cast<int>(eOp)];
+
+		if (stOper.nPrec == 0 ||
+			stOper.nPrec < nMinPrec)
+			break;
+
+		unsigned int nOffset = NodeOffset(iter);
+		iter.Next();
+		stExpression* pRight = ParseBinary(stOper.bRightAssoc ? stOper.nPrec : stOper.nPrec + 1, iter);
+
+		pLeft = NewBinary(eOp, nOffset, pLeft, pRight);
 	}
 
-	return pRel;
+	return pLeft;
 }
 
 /**
-@brief		Or parser
-@param		iter		Token iterator
-@return		Token to "Or expression" structure
+@brief		Make a binary expression node
+@param		eOp			Operator (a binary entry of m_arrOperator)
+@param		nOffset		Source offset of the operator
+@param		pLeft		Left expression
+@param		pRight		Right expression
+@return		Token to "And", "Or", "Relational" or "Arithmetic expression" structure
 */
-stExpression* CParser::ParseOr(vstToken::iterator& iter)
+stExpression* CParser::NewBinary(CLexer::eLexEnum eOp, unsigned int nOffset, stExpression* pLeft, stExpression* pRight)
 {
-	stExpression* pAnd = ParseAnd(iter);
-
-	while (NextIter(CLexer::eLexEnum::LogicOpOr, iter, false))
+	switch (m_arrOperator[static_cast<int>(eOp)].eKind)
 	{
-		stOr* pOr = new stOr();
-		pOr->stLeft = pAnd;
-		pOr->stRight = ParseAnd(iter);
-		pAnd = pOr;
+		case eNodeKind::Or:
+		{
+			stOr* pOr = NewNode<stOr>(nOffset);
+			pOr->stLeft = pLeft;
+			pOr->stRight = pRight;
+			return pOr;
+		}
+		case eNodeKind::And:
+		{
+			stAnd* pAnd = NewNode<stAnd>(nOffset);
+			pAnd->stLeft = pLeft;
+			pAnd->stRight = pRight;
+			return pAnd;
+		}
+		case eNodeKind::Relational:
+		{
+			stRelational* pRel = NewNode<stRelational>(nOffset);
+			pRel->eType = eOp;
+			pRel->stLeft = pLeft;
+			pRel->stRight = pRight;
+			return pRel;
+		}
+		default:
+		{
+			stArithmetic* pArith = NewNode<stArithmetic>(nOffset);
+			pArith->eType = eOp;
+			pArith->stLeft = pLeft;
+			pArith->stRight = pRight;
+			return pArith;
+		}
 	}
-
-	return pAnd;
 }
 
 /**
-@brief		Relational parser
+@brief		Unary parser
 @param		iter		Token iterator
-@return		Token to "Relational expression" structure
+@return		Token to "Unary expression" structure
 */
-stExpression* CParser::ParseRelational(vstToken::iterator& iter)
+stExpression* CParser::ParseUnary(CTokenReader& iter)
 {
-	stExpression* pArith = ParseArithmetic(false, iter);
+	// Prefix chains ("- - x") are linked in a loop, not by recursion
+	stExpression* pExp = nullptr;
+	stUnary* pLast = nullptr;
 
-	while (m_setRelOp.count(iter->eLex))
+	while (m_arrOperator[static_cast<int>(iter.Lex())].bPrefix)
 	{
-		stRelational* pRel = new stRelational();
-		pRel->eType = iter->eLex;
-		NextIter(iter->eLex, iter);
-		pRel->stLeft = pArith;
-		pRel->stRight = ParseArithmetic(false, iter);
-		pArith = pRel;
+		stUnary* pUn = NewNode<stUnary>(NodeOffset(iter));
+		pUn->eType = iter.Lex();
+		NextIter(iter.Lex(), iter);
+
+		if (pLast == nullptr)
+			pExp = pUn;
+		else
+			pLast->stSubExp = pUn;
+		pLast = pUn;
 	}
 
-	return pArith;
+	if (pLast == nullptr)
+		return ParseDataType(iter);
+
+	pLast->stSubExp = ParseDataType(iter);
+	return pExp;
 }
 
 /**
-@brief		Arithmetic parser
+@brief		Identifier parser
 @param		iter		Token iterator
-@return		Token to "Arithmetic expression" structure
+@return		Token to "Identifier expression" structure
 */
-stExpression* CParser::ParseArithmetic(bool bIsPriority, vstToken::iterator& iter)
+stExpression* CParser::ParseIdentifier(CTokenReader& iter)
 {
-	std::unordered_set<CLexer::eLexEnum>* pOp = nullptr;
-	stExpression* pExp = nullptr;
+	// Every node of the identifier gets the offset of the name
+	unsigned int nOffset = NodeOffset(iter);
+	SymbolID nSymbol = NextName(iter);
 
-	if (bIsPriority)
+	// Check function call
+	if (NextIter(CLexer::eLexEnum::LeftParent, iter, false))
 	{
-		pOp = &m_setCalOp1;
-		pExp = ParseUnary(iter);
+		stCallFunc* pCall = NewNode<stCallFunc>(nOffset);
+		stGetVariable* pFunc = NewNode<stGetVariable>(nOffset);
+		pFunc->nSymbol = nSymbol;
+		pCall->stSubExp = pFunc;
+
+		// Check function arguments
+		if (iter.Lex() != CLexer::eLexEnum::RightParent)
+		{
+			do
+			{
+				pCall->vArgsExp.push_back(ParseExpression(iter));
+			} while (NextIter(CLexer::eLexEnum::Comma, iter, false));
+		}
+		// Check ")"
+		NextIter(CLexer::eLexEnum::RightParent, iter);
+
+		return pCall;
 	}
-	else 
+
+	// Check element
+	if (NextIter(CLexer::eLexEnum::LeftBraket, iter, false))
 	{
-		pOp = &m_setCalOp2;
-		pExp = ParseArithmetic(true, iter);
+		stGetVariable* pMems = NewNode<stGetVariable>(nOffset);
+		pMems->nSymbol = nSymbol;
+		stExpression* pIndex = ParseExpression(iter);
+		// Check "]"
+		NextIter(CLexer::eLexEnum::RightBraket, iter);
+
+		// Check assignment
+		if (NextIter(CLexer::eLexEnum::Assignment, iter, false))
+		{
+			stSetElement* pSetElem = NewNode<stSetElement>(nOffset);
+			pSetElem->stMemsExp = pMems;
+			pSetElem->stIndexExp = pIndex;
+			pSetElem->stInitExp = ParseExpression(iter);
+			return pSetElem;
+		}
+
+		stGetElement* pGetElem = NewNode<stGetElement>(nOffset);
+		pGetElem->stMemsExp = pMems;
+		pGetElem->stIndexExp = pIndex;
+		return pGetElem;
 	}
 
-	while (pOp->count(iter->eLex))
+	// Check assignment
+	if (NextIter(CLexer::eLexEnum::Assignment, iter, false))
 	{
-		stArithmetic* pArith = new stArithmetic();
-		pArith->eType = iter->eLex;
-		NextIter(iter->eLex, iter);
-		pArith->stLeft = pExp;
-		pArith->stRight = bIsPriority ? ParseUnary(iter) : ParseArithmetic(true, iter);
-		pExp = pArith;
+		stSetVariable* pSetVar = NewNode<stSetVariable>(nOffset);
+		pSetVar->nSymbol = nSymbol;
+		pSetVar->stInitExp = ParseExpression(iter);
+		return pSetVar;
 	}
 
+	stGetVariable* pGetVar = NewNode<stGetVariable>(nOffset);
+	pGetVar->nSymbol = nSymbol;
+
+	return pGetVar;
+}
+
+/**
+@brief		Parenthesis parser
+@param		iter		Token iterator
+@return		Token to the "Expression" structure in the parenthesis
+*/
+stExpression* CParser::ParseParenthesis(CTokenReader& iter)
+{
+	// Check "("
+	NextIter(CLexer::eLexEnum::LeftParent, iter);
+
+	stExpression* pExp = ParseExpression(iter);
+
+	// Check ")"
+	NextIter(CLexer::eLexEnum::RightParent, iter);
+
 	return pExp;
 }
 
 /**
-@brief		Unary parser
+@brief		Statement parser
 @param		iter		Token iterator
-@return		Token to "Unary expression" structure
+@return		Token to "Statement" structure
 */
-stExpression* CParser::ParseUnary(vstToken::iterator& iter)
+stStatement* CParser::ParseStatement(CTokenReader& iter)
 {
-	if (m_setCalOp2.count(iter->eLex))
+	// Check variable
+	if (IsDeclaration(iter))
+		return ParseVariable(iter);
+
+	switch (iter.Lex())
 	{
-		stUnary* pUn = new stUnary();
-		pUn->eType = iter->eLex;
-		NextIter(iter->eLex, iter);
-		pUn->stSubExp = ParseUnary(iter);
-		return pUn;
+		case CLexer::eLexEnum::Return:
+			return ParseReturn(iter);
+		case CLexer::eLexEnum::For:
+			return ParseFor(iter);
+		case CLexer::eLexEnum::While:
+			return ParseWhile(iter);
+		case CLexer::eLexEnum::If:
+			return ParseIf(iter);
+		case CLexer::eLexEnum::Switch:
+			return ParseSwitch(iter);
+		case CLexer::eLexEnum::Break:
+			return ParseBreak(iter);
+		case CLexer::eLexEnum::Continue:
+			return ParseContinue(iter);
+		case CLexer::eLexEnum::Printf:
+			return ParsePrintf(iter);
+		case CLexer::eLexEnum::EndOfLine:
+			ReportError(iter, "EndOfLine checked before RightBrace came.");
+			return nullptr;
+		default:
+			return ParseExpStatement(iter);
 	}
-
-	return ParseDataType(iter);
 }
 
 /**
-@brief		Identifier parser
+@brief		Block parser
 @param		iter		Token iterator
-@return		Token to "Identifier expression" structure
+@param		bIsCase		Whether the block is a switch case (ends at case or default too)
+@return		Token to "Block statements" structure (statements with errors are left out)
 */
-stExpression* CParser::ParseIdentifier(vstToken::iterator& iter)
+vstStatement CParser::ParseBlock(CTokenReader& iter, bool bIsCase)
 {
-	stGetVariable* pGetVar = new stGetVariable();
-	pGetVar->strName = iter->strString;
-	NextIter(CLexer::eLexEnum::Identifier, iter);
+	vstStatement vBlock;
 
-	return pGetVar;
+	while (iter.Lex() != CLexer::eLexEnum::RightBrace)
+	{
+		if (bIsCase &&
+			(iter.Lex() == CLexer::eLexEnum::Case || iter.Lex() == CLexer::eLexEnum::Default))
+			break;
+
+		if (iter.Lex() == CLexer::eLexEnum::EndOfLine)
+		{
+			ReportError(iter, "EndOfLine checked before RightBrace came.");
+			break;
+		}
+
+		size_t nStart = iter.Position();
+		stStatement* pState = ParseStatement(iter);
+
+		// Skip the rest of a broken statement and go on with the next one
+		if (pState == nullptr ||
+			m_bPanic)
+		{
+			Synchronize(iter, nStart, bIsCase);
+			continue;
+		}
+
+		vBlock.push_back(pState);
+	}
+
+	return vBlock;
 }
 
 /**
-@brief		Block parser
-@param		eType		Return type (use only Return)
+@brief		Skip the rest of a statement with an error (panic mode)
 @param		iter		Token iterator
-@return		Token to "Block statements" structure
+@param		nStart		First token of the statement
+@param		bIsCase		Whether the block is a switch case (case and default end it too)
+@return
+@details	Skips up to and including the next ";" of the block, or over the next "{...}"
+			(with the else if and else blocks after it), or up to the "}" that closes the
+			block. The panic ends here unless the input ended; then the enclosing blocks
+			stop without reporting the missing "}" again.
 */
-std::vector<stStatement*> CParser::ParseBlock(CLexer::eLexEnum eType, vstToken::iterator& iter)
+void CParser::Synchronize(CTokenReader& iter, size_t nStart, bool bIsCase)
 {
-	std::vector<stStatement*> vBlock;
+	size_t nDepth = 0;
+	// Nothing is skipped if the statement already ended at its ";"
+	bool bEnded = iter.Position() > nStart && iter.Prev() == CLexer::eLexEnum::Semicolon;
 
-	while (iter->eLex != CLexer::eLexEnum::RightBrace)
+	while (bEnded == false &&
+		   iter.Lex() != CLexer::eLexEnum::EndOfLine)
 	{
-		switch (iter->eLex)
+		CLexer::eLexEnum eLex = iter.Lex();
+
+		if (nDepth == 0)
 		{
-			case CLexer::eLexEnum::Variable:
-				vBlock.push_back(ParseVariable(iter));
+			if (eLex == CLexer::eLexEnum::RightBrace ||
+				(bIsCase && (eLex == CLexer::eLexEnum::Case || eLex == CLexer::eLexEnum::Default)))
 				break;
-			case CLexer::eLexEnum::Return:
-				vBlock.push_back(ParseReturn(eType, iter));
-				break;
-			case CLexer::eLexEnum::For:
-				vBlock.push_back(ParseFor(iter));
-				break;
-			case CLexer::eLexEnum::While:
-				vBlock.push_back(ParseWhile(iter));
-				break;
-			case CLexer::eLexEnum::If:
-				vBlock.push_back(ParseIf(iter));
-				break;
-			case CLexer::eLexEnum::Switch:
-				vBlock.push_back(ParseSwitch(iter));
-				break;
-			case CLexer::eLexEnum::Break:
-				vBlock.push_back(ParseBreak(iter));
-				break;
-			case CLexer::eLexEnum::Continue:
-				vBlock.push_back(ParseContinue(iter));
-				break;
-			case CLexer::eLexEnum::EndOfLine:
-				PrintLog(eLogType::Error, "EndOfLine checked before RightBrace came.");
-				vBlock.push_back(nullptr);
-				break;
-			default:
-				vBlock.push_back(ParseExpStatement(iter));
+
+			if (eLex == CLexer::eLexEnum::Semicolon)
+			{
+				iter.Next();
 				break;
+			}
 		}
 
-		if (vBlock[vBlock.size() - 1] == nullptr)
+		iter.Next();
+
+		if (eLex == CLexer::eLexEnum::LeftBrace)
+		{
+			++nDepth;
+		}
+		else if (eLex == CLexer::eLexEnum::RightBrace &&
+				 --nDepth == 0 &&
+				 iter.Lex() != CLexer::eLexEnum::Elif &&
+				 iter.Lex() != CLexer::eLexEnum::Else)
 		{
-			vBlock.clear();
-			vBlock.push_back(nullptr);
 			break;
 		}
 	}
 
-	return vBlock;
+	if (iter.Lex() != CLexer::eLexEnum::EndOfLine)
+		m_bPanic = false;
+}
+
+/**
+@brief		Skip to the next top-level function after an error ("type Function" outside of braces)
+@param		iter		Token iterator
+@return
+*/
+void CParser::SkipToFunction(CTokenReader& iter)
+{
+	size_t nDepth = 0;
+
+	while (iter.Lex() != CLexer::eLexEnum::EndOfLine)
+	{
+		if (nDepth == 0 &&
+			IsDeclaration(iter) &&
+			iter.Peek() == CLexer::eLexEnum::Function)
+			break;
+
+		if (iter.Lex() == CLexer::eLexEnum::LeftBrace)
+			++nDepth;
+		else if (iter.Lex() == CLexer::eLexEnum::RightBrace && nDepth > 0)
+			--nDepth;
+
+		iter.Next();
+	}
+
+	m_bPanic = false;
+}
+
+/**
+@brief		Report a syntax error at the current token
+@param		iter			Token iterator
+@param		strMessage		Message
+@return
+@details	The parser panics: errors that follow from the first one are dropped until it
+			resynchronizes (Synchronize, SkipToFunction).
+*/
+void CParser::ReportError(const CTokenReader& iter, std::string strMessage)
+{
+	if (m_bPanic == false)
+		m_pDiag->Error(m_nOffsetBase + iter.Offset(), std::move(strMessage));
+
+	m_bPanic = true;
 }
 
 /**
 @brief		Increment token iterator
 @param		eLexCheckType		Current iterator's eLex value
 @param		iter				Token iterator
-@param		bCritical			If eLexCheckType and iter->eLex are not the same, whether to terminate
-@return
+@param		bCritical			If eLexCheckType and iter.Lex() are not the same, whether it is an error
+@return		Whether the token was eLexCheckType (the iterator does not move otherwise)
 */
-bool CParser::NextIter(CLexer::eLexEnum eLexCheckType, vstToken::iterator& iter, bool bCritical)
+bool CParser::NextIter(CLexer::eLexEnum eLexCheckType, CTokenReader& iter, bool bCritical)
 {
-	if (iter->eLex != eLexCheckType)
+	if (iter.Lex() != eLexCheckType)
 	{
 		if (bCritical)
 		{
-			PrintLog(eLogType::Error, "Next token check failed.");
-			exit(1);
+			ReportError(iter, "Expected " + CLexer::FindLexToString(eLexCheckType) + (iter.Lex() == CLexer::eLexEnum::EndOfLine ?
+				" before the end of input." :
+				" at '" + std::string(iter.String()) + "'."));
 		}
 		return false;
 	}
 
-	++iter;
+	iter.Next();
 	return true;
+}
+
+/**
+@brief		Check name (Identifier, Variable or Function) and increment token iterator
+@param		iter		Token iterator
+@return		Name (symbol ID; INVALID_SYMBOL and the iterator does not move if it is not a name)
+*/
+SymbolID CParser::NextName(CTokenReader& iter)
+{
+	SymbolID nSymbol = iter.Symbol();
+
+	if (CLexer::IsIdentifier(iter.Lex()) == false)
+	{
+		ReportError(iter, iter.Lex() == CLexer::eLexEnum::EndOfLine ?
+			"Name expected before the end of input." :
+			"Name expected at '" + std::string(iter.String()) + "'.");
+		return CSymbolTable::INVALID_SYMBOL;
+	}
+
+	iter.Next();
+	return nSymbol;
 }
\ No newline at end of file
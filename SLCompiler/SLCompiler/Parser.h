@@ -1,10 +1,13 @@
 #pragma once
-#include <unordered_set>
+#include <array>
 #include "Structures.h"
 #include "Lexer.h"
+#include "TokenBuffer.h"
 
 typedef std::vector<CLexer::stToken> vstToken;
 
+class CThreadPool;
+
 static class CParser
 {
 // Enums and Classes, Structures ==========================================================
@@ -16,55 +19,209 @@ public:
 		Error,
 		LogTypeMax
 	};
+
+	// Operator (precedence climbing)
+	struct stOperator
+	{
+	public:
+		// Binary precedence (0 if the lex is not a binary operator; higher binds tighter)
+		unsigned char nPrec = 0;
+		// Right associative
+		bool bRightAssoc = false;
+		// Prefix (unary) operator
+		bool bPrefix = false;
+		// Node kind of the binary expression
+		eNodeKind eKind = eNodeKind::NodeKindMax;
+	};
+
+	typedef std::array<stOperator, static_cast<int>(CLexer::eLexEnum::EndOfLine) + 1> arrOperator;
+
+	enum class eParseMode
+	{
+		Auto,					// Recursive unless the nesting is deeper than RECURSION_LIMIT
+		Recursive,				// Recursive descent (native stack grows with the nesting)
+		Iterative,				// Explicit stacks on the heap (any nesting depth)
+	};
+
+	// Block being parsed by the explicit-stack parser
+	enum class eBlockFrame
+	{
+		Function,
+		Loop,					// For or while block
+		If,						// If or else if block
+		Else,
+		Case,					// Case or default block
+	};
+
+	struct stBlockFrame
+	{
+	public:
+		eBlockFrame eFrame;
+		stStatement* pOwner;
+		vstStatement* pBlock;
+	};
+
+	// Sub expression being parsed by the explicit-stack parser
+	enum class eExpFrame
+	{
+		Top,
+		Parenthesis,
+		Call,					// Argument of stCallFunc
+		Index,					// Index of an element (pNode is the container)
+		SetVariable,			// Init expression of stSetVariable
+		SetElement,				// Init expression of stSetElement
+	};
+
+	struct stExpFrame
+	{
+	public:
+		eExpFrame eFrame;
+		// Operators below this belong to the outer frames
+		size_t nOperBase;
+		stExpression* pNode;
+	};
+
+	// Function range of the parallel and incremental parsers
+	struct stChunk
+	{
+	public:
+		std::unique_ptr<CArena> pArena;
+		std::vector<stFunction*> vFunc;
+		size_t nNodeCount = 0;
+		bool bFailed = false;
+	};
+
+	// Operator waiting for its right operand
+	struct stPendingOper
+	{
+	public:
+		CLexer::eLexEnum eLex;
+		bool bPrefix;
+		// Source offset of the operator
+		unsigned int nOffset;
+	};
 // ========================================================================================
 
 
 // Variables ==============================================================================
+public:
+	// Nesting depth up to which Auto parses recursively
+	static constexpr size_t RECURSION_LIMIT = 256;
+
 private:
 	const static std::string LOG_TYPE[static_cast<int>(eLogType::LogTypeMax)];
-	static std::unordered_set<CLexer::eLexEnum> m_setRelOp;
-	static std::unordered_set<CLexer::eLexEnum> m_setCalOp1;
-	static std::unordered_set<CLexer::eLexEnum> m_setCalOp2;
+	// Operator table (indexed by CLexer::eLexEnum, constexpr in Parser.cpp)
+	static const arrOperator m_arrOperator;
+	// Node count of the running parse
+	static thread_local size_t m_nNodeCount;
+	// The running parse uses the explicit-stack functions
+	static thread_local bool m_bIterative;
+	// Diagnostics of the running parse
+	static thread_local CDiagnostics* m_pDiag;
+	// Source offset of the first token of the buffer (the streaming parser's buffers start mid-source)
+	static thread_local size_t m_nOffsetBase;
+	// An error was reported and the parse has not resynchronized yet (further errors are dropped)
+	static thread_local bool m_bPanic;
+	// Stacks of the explicit-stack parser (reused by every block and expression)
+	static thread_local std::vector<stBlockFrame> m_vBlockFrame;
+	static thread_local std::vector<stExpFrame> m_vExpFrame;
+	static thread_local std::vector<stPendingOper> m_vOper;
+	static thread_local std::vector<stExpression*> m_vValue;
 // ========================================================================================
 
 
 // Functions ==============================================================================
 public:
-	static stProgram* Parser(vstToken vTokens);
+	static stProgram* Parser(const vstToken& vTokens, CDiagnostics* pDiag = nullptr);
+	static stProgram* Parser(CLexerStream& stream, eParseMode eMode = eParseMode::Auto, CDiagnostics* pDiag = nullptr);
+	static stProgram* Parser(const CTokenBuffer& tokens, CArena::eMode eArenaMode = CArena::eMode::Block, eParseMode eMode = eParseMode::Auto, CDiagnostics* pDiag = nullptr);
+	static stProgram* ParserParallel(const CTokenBuffer& tokens, CThreadPool& pool, eParseMode eMode = eParseMode::Auto, CDiagnostics* pDiag = nullptr);
+	static void ParseChunk(const CTokenBuffer& tokens, size_t nBegin, size_t nEnd, stChunk& stChunkData, CDiagnostics* pDiag, eParseMode eMode = eParseMode::Auto, size_t nOffsetBase = 0);
+	static size_t MeasureNesting(const CTokenBuffer& tokens, size_t nBegin = 0, size_t nEnd = (size_t)-1);
 	
 private:
 	inline static void PrintLog(eLogType eType, std::string strLog);
+	static void ReportError(const CTokenReader& iter, std::string strMessage);
 
-	static stFunction* ParseFunction(CLexer::eLexEnum eType, vstToken::iterator& iter);
-	static stVariable* ParseVariable(vstToken::iterator& iter);
-	static stExpStatement* ParseExpStatement(vstToken::iterator& iter);
-	static stExpression* ParseExpression(vstToken::iterator& iter);
-	static stStatement* ParseReturn(CLexer::eLexEnum eType, vstToken::iterator& iter);
-	static stStatement* ParseFor(vstToken::iterator& iter);
-	static stStatement* ParseWhile(vstToken::iterator& iter);
-	static stStatement* ParseIf(vstToken::iterator& iter);
-	static stStatement* ParseSwitch(vstToken::iterator& iter);
-	static stStatement* ParseBreak(vstToken::iterator& iter);
-	static stStatement* ParseContinue(vstToken::iterator& iter);
-	static stStatement* ParsePrintf(vstToken::iterator& iter);
-	static stExpression* ParseDataType(vstToken::iterator& iter);
-	static stExpression* ParseNullData(vstToken::iterator& iter);
-	static stExpression* ParseBooleanData(vstToken::iterator& iter);
-	static stExpression* ParseIntData(vstToken::iterator& iter);
-	static stExpression* ParseDoubleData(vstToken::iterator& iter);
-	static stExpression* ParseStringData(vstToken::iterator& iter);
-	static stExpression* ParseVoidData(vstToken::iterator& iter);
-	static stExpression* ParseArrayData(vstToken::iterator& iter);
-	static stExpression* ParseAnd(vstToken::iterator& iter);
-	static stExpression* ParseOr(vstToken::iterator& iter);
-	static stExpression* ParseRelational(vstToken::iterator& iter);
-	static stExpression* ParseArithmetic(bool bIsPriority, vstToken::iterator& iter);
-	static stExpression* ParseUnary(vstToken::iterator& iter);
-	static stExpression* ParseIdentifier(vstToken::iterator& iter);
-
-	static std::vector<stStatement*> ParseBlock(CLexer::eLexEnum eType, vstToken::iterator& iter);
-
-	static bool NextIter(CLexer::eLexEnum eLexCheckType, vstToken::iterator& iter, bool bCritical = true);
+	template <typename T, typename... Args>
+	inline static T* NewNode(unsigned int nOffset, Args&&... args)
+	{
+		++m_nNodeCount;
+		T* pNode = CArena::Current()->New<T>(std::forward<Args>(args)...);
+		pNode->nOffset = nOffset;
+		return pNode;
+	}
+
+	// Source offset of the current token (the offset a node made here gets)
+	inline static unsigned int NodeOffset(const CTokenReader& iter)
+	{
+		return (unsigned int)(m_nOffsetBase + iter.Offset());
+	}
+
+	static std::vector<size_t> SplitFunctions(const CTokenBuffer& tokens, int nChunks);
+	static bool ParseFunctions(CTokenReader& iter, size_t nEnd, std::vector<stFunction*>& vFunc);
+	static stFunction* ParseFunction(CLexer::eLexEnum eType, CTokenReader& iter);
+	static stVariable* ParseVariable(CTokenReader& iter);
+	static stExpStatement* ParseExpStatement(CTokenReader& iter);
+	static stExpression* ParseExpression(CTokenReader& iter);
+	static stStatement* ParseReturn(CTokenReader& iter);
+	static stFor* ParseForHeader(CTokenReader& iter);
+	static stStatement* ParseFor(CTokenReader& iter);
+	static stWhile* ParseWhileHeader(CTokenReader& iter);
+	static stStatement* ParseWhile(CTokenReader& iter);
+	static bool ParseIfCondition(stIf* pIf, CTokenReader& iter);
+	static stStatement* ParseIf(CTokenReader& iter);
+	static stSwitch* ParseSwitchHeader(CTokenReader& iter);
+	static bool ParseCaseLabel(stSwitch* pSwitch, bool& bDefault, CTokenReader& iter);
+	static stStatement* ParseSwitch(CTokenReader& iter);
+	static stStatement* ParseBreak(CTokenReader& iter);
+	static stStatement* ParseContinue(CTokenReader& iter);
+	static stStatement* ParsePrintf(CTokenReader& iter);
+	static stExpression* ParseDataType(CTokenReader& iter);
+	static stExpression* ParseNullData(CTokenReader& iter);
+	static stExpression* ParseBooleanData(CTokenReader& iter);
+	static stExpression* ParseIntData(CTokenReader& iter);
+	static stExpression* ParseDoubleData(CTokenReader& iter);
+	static stExpression* ParseStringData(CTokenReader& iter);
+	static stExpression* ParseVoidData(CTokenReader& iter);
+	static stExpression* ParseArrayData(CTokenReader& iter);
+	static stExpression* NewBinary(CLexer::eLexEnum eOp, unsigned int nOffset, stExpression* pLeft, stExpression* pRight);
+	static stExpression* ParseBinary(int nMinPrec, CTokenReader& iter);
+	static stExpression* ParseUnary(CTokenReader& iter);
+	static stExpression* ParseIdentifier(CTokenReader& iter);
+	static stExpression* ParseParenthesis(CTokenReader& iter);
+
+	static stStatement* ParseStatement(CTokenReader& iter);
+	static vstStatement ParseBlock(CTokenReader& iter, bool bIsCase = false);
+
+	// Explicit-stack parsing (ParserIterative.cpp)
+	static vstStatement ParseBlockIterative(CTokenReader& iter);
+	static bool CloseBlockFrame(const stBlockFrame& stFrame, std::vector<stBlockFrame>& vStack, CTokenReader& iter);
+	static bool OpenCaseFrame(stSwitch* pSwitch, std::vector<stBlockFrame>& vStack, CTokenReader& iter);
+	static stExpression* ParseExpressionIterative(CTokenReader& iter);
+	static void ReduceOperators(size_t nOperBase, const stOperator* pNext, std::vector<stPendingOper>& vOper, std::vector<stExpression*>& vValue);
+
+	// Panic-mode recovery
+	static void Synchronize(CTokenReader& iter, size_t nStart, bool bIsCase);
+	static void SkipToFunction(CTokenReader& iter);
+
+	static bool NextIter(CLexer::eLexEnum eLexCheckType, CTokenReader& iter, bool bCritical = true);
+	static SymbolID NextName(CTokenReader& iter);
+
+	inline static bool IsDeclaration(const CTokenReader& iter)
+	{
+		// Type keywords and literals share a lex; a type keyword is followed by a name
+		switch (iter.Lex())
+		{
+			case CLexer::eLexEnum::Int:
+			case CLexer::eLexEnum::Double:
+			case CLexer::eLexEnum::String:
+			case CLexer::eLexEnum::Void:
+				return CLexer::IsIdentifier(iter.Peek());
+			default:
+				return false;
+		}
+	}
 
 // ========================================================================================
 
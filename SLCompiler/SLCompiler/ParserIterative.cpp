@@ -0,0 +1,509 @@
+#include "Parser.h"
+
+// Explicit-stack parsing
+// Generated sources can nest blocks and parentheses thousands of levels deep, which
+// overflows the native stack of the recursive descent functions. These functions keep
+// the open blocks and sub expressions in heap vectors instead, and build the same tree
+// as the recursive ones. Statements without a block of their own (variable, return,
+// printf, ...) are still parsed by the shared functions; their expressions come here
+// through ParseExpression().
+
+/**
+@brief		Measure the nesting depth of the tokens (cheap upper bound of the parser recursion)
+@param		tokens		Token buffer
+@param		nBegin		First token
+@param		nEnd		End token (clamped to the buffer)
+@return		Nesting depth (brackets, prefix operators and assignment chains)
+*/
+size_t CParser::MeasureNesting(const CTokenBuffer& tokens, size_t nBegin, size_t nEnd)
+{
+	const unsigned char* pKind = tokens.KindData();
+	size_t nDepth = 0;
+	size_t nChain = 0;
+	size_t nMax = 0;
+	CLexer::eLexEnum ePrev = CLexer::eLexEnum::Semicolon;
+
+	if (nEnd > tokens.Size())
+		nEnd = tokens.Size();
+
+	for (size_t i = nBegin; i < nEnd; ++i)
+	{
+		CLexer::eLexEnum eLex = static_cast<CLexer::eLexEnum>(pKind[i]);
+
+		switch (eLex)
+		{
+			case CLexer::eLexEnum::LeftParent:
+			case CLexer::eLexEnum::LeftBraket:
+				++nDepth;
+				break;
+			case CLexer::eLexEnum::LeftBrace:
+				++nDepth;
+				nChain = 0;
+				break;
+			case CLexer::eLexEnum::RightParent:
+			case CLexer::eLexEnum::RightBraket:
+				if (nDepth > 0)
+					--nDepth;
+				break;
+			case CLexer::eLexEnum::RightBrace:
+				if (nDepth > 0)
+					--nDepth;
+				nChain = 0;
+				break;
+			case CLexer::eLexEnum::Semicolon:
+				nChain = 0;
+				break;
+			case CLexer::eLexEnum::Assignment:
+				++nChain;
+				break;
+			default:
+				// A prefix operator is one that does not follow an operand
+				if (m_arrOperator[static_cast<int>(eLex)].bPrefix &&
+					CLexer::IsIdentifier(ePrev) == false &&
+					ePrev != CLexer::eLexEnum::RightParent &&
+					ePrev != CLexer::eLexEnum::RightBraket &&
+					(ePrev < CLexer::eLexEnum::Null || ePrev > CLexer::eLexEnum::Void))
+					++nChain;
+				break;
+		}
+
+		if (nDepth + nChain > nMax)
+			nMax = nDepth + nChain;
+		ePrev = eLex;
+	}
+
+	return nMax;
+}
+
+/**
+@brief		Block parser (explicit stack)
+@param		iter		Token iterator
+@return		Token to "Block statements" structure (statements with errors are left out, as ParseBlock does)
+*/
+vstStatement CParser::ParseBlockIterative(CTokenReader& iter)
+{
+	vstStatement vBlock;
+	std::vector<stBlockFrame>& vStack = m_vBlockFrame;
+	size_t nBase = vStack.size();
+	vStack.push_back(stBlockFrame{ eBlockFrame::Function, nullptr, &vBlock });
+
+	while (vStack.size() > nBase)
+	{
+		stBlockFrame stFrame = vStack.back();
+		CLexer::eLexEnum eLex = iter.Lex();
+
+		// Check the end of the block
+		if (eLex == CLexer::eLexEnum::RightBrace ||
+			(stFrame.eFrame == eBlockFrame::Case && (eLex == CLexer::eLexEnum::Case || eLex == CLexer::eLexEnum::Default)))
+		{
+			vStack.pop_back();
+
+			// A broken else if or else leaves the whole if statement out
+			if (CloseBlockFrame(stFrame, vStack, iter) == false)
+			{
+				vStack.back().pBlock->pop_back();
+				Synchronize(iter, iter.Position(), vStack.back().eFrame == eBlockFrame::Case);
+			}
+			continue;
+		}
+
+		if (eLex == CLexer::eLexEnum::EndOfLine)
+		{
+			ReportError(iter, "EndOfLine checked before RightBrace came.");
+			break;
+		}
+
+		// Statements with a block are added to their block and stay open on the stack
+		size_t nStart = iter.Position();
+		stStatement* pState = nullptr;
+
+		if (IsDeclaration(iter))
+		{
+			pState = ParseVariable(iter);
+		}
+		else
+		{
+			switch (eLex)
+			{
+				case CLexer::eLexEnum::For:
+				{
+					stFor* pFor = ParseForHeader(iter);
+					if (pFor != nullptr &&
+						m_bPanic == false &&
+						NextIter(CLexer::eLexEnum::LeftBrace, iter))
+					{
+						vStack.push_back(stBlockFrame{ eBlockFrame::Loop, pFor, &pFor->stBlock });
+						pState = pFor;
+					}
+					break;
+				}
+				case CLexer::eLexEnum::While:
+				{
+					stWhile* pWhile = ParseWhileHeader(iter);
+					if (pWhile != nullptr &&
+						m_bPanic == false &&
+						NextIter(CLexer::eLexEnum::LeftBrace, iter))
+					{
+						vStack.push_back(stBlockFrame{ eBlockFrame::Loop, pWhile, &pWhile->stBlock });
+						pState = pWhile;
+					}
+					break;
+				}
+				case CLexer::eLexEnum::If:
+				{
+					stIf* pIf = NewNode<stIf>(NodeOffset(iter));
+					NextIter(CLexer::eLexEnum::If, iter);
+					if (ParseIfCondition(pIf, iter) &&
+						m_bPanic == false &&
+						NextIter(CLexer::eLexEnum::LeftBrace, iter))
+					{
+						pIf->vIfBlock.emplace_back();
+						vStack.push_back(stBlockFrame{ eBlockFrame::If, pIf, &pIf->vIfBlock.back() });
+						pState = pIf;
+					}
+					break;
+				}
+				case CLexer::eLexEnum::Switch:
+				{
+					stSwitch* pSwitch = ParseSwitchHeader(iter);
+					if (m_bPanic == false &&
+						NextIter(CLexer::eLexEnum::LeftBrace, iter) &&
+						OpenCaseFrame(pSwitch, vStack, iter))
+						pState = pSwitch;
+					break;
+				}
+				default:
+					pState = ParseStatement(iter);
+					break;
+			}
+		}
+
+		// Skip the rest of a broken statement and go on with the next one
+		if (pState == nullptr ||
+			m_bPanic)
+		{
+			Synchronize(iter, nStart, stFrame.eFrame == eBlockFrame::Case);
+			continue;
+		}
+
+		stFrame.pBlock->push_back(pState);
+	}
+
+	// The input ended in an open statement; it is left out like a broken one
+	if (vStack.size() > nBase + 1)
+		vBlock.pop_back();
+	vStack.resize(nBase);
+
+	return vBlock;
+}
+
+/**
+@brief		Close a block of the explicit-stack parser (and open the next block of its statement)
+@param		stFrame		Closed block (already popped)
+@param		vStack		Open blocks
+@param		iter		Token iterator (at the end of the block)
+@return		Whether the statement continued without errors
+*/
+bool CParser::CloseBlockFrame(const stBlockFrame& stFrame, std::vector<stBlockFrame>& vStack, CTokenReader& iter)
+{
+	switch (stFrame.eFrame)
+	{
+		case eBlockFrame::Function:
+			// "}" of the function is checked by ParseFunction
+			return true;
+		case eBlockFrame::Loop:
+		case eBlockFrame::Else:
+			// Check "}"
+			NextIter(CLexer::eLexEnum::RightBrace, iter);
+			return true;
+		case eBlockFrame::If:
+		{
+			stIf* pIf = static_cast<stIf*>(stFrame.pOwner);
+
+			// Check "}"
+			NextIter(CLexer::eLexEnum::RightBrace, iter);
+
+			// Check "else if"
+			if (NextIter(CLexer::eLexEnum::Elif, iter, false))
+			{
+				if (ParseIfCondition(pIf, iter) == false ||
+					m_bPanic ||
+					NextIter(CLexer::eLexEnum::LeftBrace, iter) == false)
+					return false;
+
+				pIf->vIfBlock.emplace_back();
+				vStack.push_back(stBlockFrame{ eBlockFrame::If, pIf, &pIf->vIfBlock.back() });
+			}
+			// Check "else"
+			else if (NextIter(CLexer::eLexEnum::Else, iter, false))
+			{
+				if (NextIter(CLexer::eLexEnum::LeftBrace, iter) == false)
+					return false;
+
+				vStack.push_back(stBlockFrame{ eBlockFrame::Else, pIf, &pIf->vElseBlock });
+			}
+			return true;
+		}
+		case eBlockFrame::Case:
+			return OpenCaseFrame(static_cast<stSwitch*>(stFrame.pOwner), vStack, iter);
+	}
+
+	return false;
+}
+
+/**
+@brief		Open the next case block of a switch, or close the switch at "}"
+@param		pSwitch		Switch statement
+@param		vStack		Open blocks
+@param		iter		Token iterator
+@return		Whether a label or "}" was found (false at the end of input)
+*/
+bool CParser::OpenCaseFrame(stSwitch* pSwitch, std::vector<stBlockFrame>& vStack, CTokenReader& iter)
+{
+	bool bDefault = false;
+
+	// A broken label was skipped up to the next one
+	do
+	{
+		// Check "}" (an error if the input ends first)
+		if (NextIter(CLexer::eLexEnum::RightBrace, iter, iter.Lex() == CLexer::eLexEnum::EndOfLine))
+			return true;
+		if (iter.Lex() == CLexer::eLexEnum::EndOfLine)
+			return false;
+	} while (ParseCaseLabel(pSwitch, bDefault, iter) == false);
+
+	vstStatement* pBlock = &pSwitch->vDefaultBlock;
+
+	if (bDefault == false)
+	{
+		pSwitch->vCaseBlock.emplace_back();
+		pBlock = &pSwitch->vCaseBlock.back();
+	}
+
+	vStack.push_back(stBlockFrame{ eBlockFrame::Case, pSwitch, pBlock });
+	return true;
+}
+
+/**
+@brief		Expression parser (explicit stack, shunting-yard over m_arrOperator)
+@param		iter		Token iterator
+@return		Token to "Expression" structure
+*/
+stExpression* CParser::ParseExpressionIterative(CTokenReader& iter)
+{
+	std::vector<stExpFrame>& vFrame = m_vExpFrame;
+	std::vector<stPendingOper>& vOper = m_vOper;
+	std::vector<stExpression*>& vValue = m_vValue;
+	size_t nFrameBase = vFrame.size();
+	size_t nValueBase = vValue.size();
+	bool bOperand = true;
+
+	vFrame.push_back(stExpFrame{ eExpFrame::Top, vOper.size(), nullptr });
+
+	for (;;)
+	{
+		if (bOperand)
+		{
+			// Check prefix operators
+			while (m_arrOperator[static_cast<int>(iter.Lex())].bPrefix)
+			{
+				vOper.push_back(stPendingOper{ iter.Lex(), true, NodeOffset(iter) });
+				iter.Next();
+			}
+
+			stExpression* pOperand = nullptr;
+
+			switch (iter.Lex())
+			{
+				case CLexer::eLexEnum::LeftParent:
+					// Check "("
+					iter.Next();
+					vFrame.push_back(stExpFrame{ eExpFrame::Parenthesis, vOper.size(), nullptr });
+					continue;
+				case CLexer::eLexEnum::Identifier:
+				case CLexer::eLexEnum::Variable:
+				case CLexer::eLexEnum::Function:
+				{
+					// Every node of the identifier gets the offset of the name
+					unsigned int nOffset = NodeOffset(iter);
+					SymbolID nSymbol = NextName(iter);
+
+					// Check function call
+					if (NextIter(CLexer::eLexEnum::LeftParent, iter, false))
+					{
+						stCallFunc* pCall = NewNode<stCallFunc>(nOffset);
+						stGetVariable* pFunc = NewNode<stGetVariable>(nOffset);
+						pFunc->nSymbol = nSymbol;
+						pCall->stSubExp = pFunc;
+
+						if (NextIter(CLexer::eLexEnum::RightParent, iter, false))
+						{
+							pOperand = pCall;
+							break;
+						}
+						vFrame.push_back(stExpFrame{ eExpFrame::Call, vOper.size(), pCall });
+						continue;
+					}
+
+					// Check element
+					if (NextIter(CLexer::eLexEnum::LeftBraket, iter, false))
+					{
+						stGetVariable* pMems = NewNode<stGetVariable>(nOffset);
+						pMems->nSymbol = nSymbol;
+						vFrame.push_back(stExpFrame{ eExpFrame::Index, vOper.size(), pMems });
+						continue;
+					}
+
+					// Check assignment
+					if (NextIter(CLexer::eLexEnum::Assignment, iter, false))
+					{
+						stSetVariable* pSetVar = NewNode<stSetVariable>(nOffset);
+						pSetVar->nSymbol = nSymbol;
+						vFrame.push_back(stExpFrame{ eExpFrame::SetVariable, vOper.size(), pSetVar });
+						continue;
+					}
+
+					stGetVariable* pGetVar = NewNode<stGetVariable>(nOffset);
+					pGetVar->nSymbol = nSymbol;
+					pOperand = pGetVar;
+					break;
+				}
+				default:
+					pOperand = ParseDataType(iter);
+					break;
+			}
+
+			vValue.push_back(pOperand);
+			bOperand = false;
+			continue;
+		}
+
+		// Check binary operator
+		CLexer::eLexEnum eOp = iter.Lex();
+		const stOperator& stOper = m_arrOperator[static_cast<int>(eOp)];
+
+		if (stOper.nPrec != 0)
+		{
+			ReduceOperators(vFrame.back().nOperBase, &stOper, vOper, vValue);
+			vOper.push_back(stPendingOper{ eOp, false, NodeOffset(iter) });
+			iter.Next();
+			bOperand = true;
+			continue;
+		}
+
+		// The expression of the innermost frame ends here
+		stExpFrame stFrame = vFrame.back();
+		ReduceOperators(stFrame.nOperBase, nullptr, vOper, vValue);
+
+		if (stFrame.eFrame == eExpFrame::Top)
+		{
+			stExpression* pExp = vValue.back();
+			vFrame.resize(nFrameBase);
+			vValue.resize(nValueBase);
+			return pExp;
+		}
+
+		stExpression* pExp = vValue.back();
+		vValue.pop_back();
+		vFrame.pop_back();
+
+		switch (stFrame.eFrame)
+		{
+			case eExpFrame::Parenthesis:
+				// Check ")"
+				NextIter(CLexer::eLexEnum::RightParent, iter);
+				vValue.push_back(pExp);
+				break;
+			case eExpFrame::Call:
+			{
+				stCallFunc* pCall = static_cast<stCallFunc*>(stFrame.pNode);
+				pCall->vArgsExp.push_back(pExp);
+
+				// Check next argument
+				if (NextIter(CLexer::eLexEnum::Comma, iter, false))
+				{
+					vFrame.push_back(stFrame);
+					bOperand = true;
+					break;
+				}
+				// Check ")"
+				NextIter(CLexer::eLexEnum::RightParent, iter);
+				vValue.push_back(pCall);
+				break;
+			}
+			case eExpFrame::Index:
+			{
+				// Check "]"
+				NextIter(CLexer::eLexEnum::RightBraket, iter);
+
+				// Check assignment
+				if (NextIter(CLexer::eLexEnum::Assignment, iter, false))
+				{
+					stSetElement* pSetElem = NewNode<stSetElement>(stFrame.pNode->nOffset);
+					pSetElem->stMemsExp = stFrame.pNode;
+					pSetElem->stIndexExp = pExp;
+					vFrame.push_back(stExpFrame{ eExpFrame::SetElement, vOper.size(), pSetElem });
+					bOperand = true;
+					break;
+				}
+
+				stGetElement* pGetElem = NewNode<stGetElement>(stFrame.pNode->nOffset);
+				pGetElem->stMemsExp = stFrame.pNode;
+				pGetElem->stIndexExp = pExp;
+				vValue.push_back(pGetElem);
+				break;
+			}
+			case eExpFrame::SetVariable:
+				static_cast<stSetVariable*>(stFrame.pNode)->stInitExp = pExp;
+				vValue.push_back(stFrame.pNode);
+				break;
+			case eExpFrame::SetElement:
+				static_cast<stSetElement*>(stFrame.pNode)->stInitExp = pExp;
+				vValue.push_back(stFrame.pNode);
+				break;
+			case eExpFrame::Top:
+				// The top frame returned above
+				_ASSERT(false);
+				break;
+		}
+	}
+}
+
+/**
+@brief		Apply the pending operators of a frame
+@param		nOperBase	First operator of the frame
+@param		pNext		Next binary operator (nullptr applies every operator of the frame)
+@param		vOper		Pending operators
+@param		vValue		Operands
+@return
+*/
+void CParser::ReduceOperators(size_t nOperBase, const stOperator* pNext, std::vector<stPendingOper>& vOper, std::vector<stExpression*>& vValue)
+{
+	while (vOper.size() > nOperBase)
+	{
+		const stPendingOper& stPending = vOper.back();
+
+		if (stPending.bPrefix)
+		{
+			// Prefix operators bind tighter than any binary operator
+			stUnary* pUn = NewNode<stUnary>(stPending.nOffset);
+			pUn->eType = stPending.eLex;
+			pUn->stSubExp = vValue.back();
+			vValue.back() = pUn;
+		}
+		else
+		{
+			const stOperator& stOper = m_arrOperator[static_cast<int>(stPending.eLex)];
+
+			if (pNext != nullptr &&
+				(stOper.nPrec < pNext->nPrec || (stOper.nPrec == pNext->nPrec && pNext->bRightAssoc)))
+				break;
+
+			stExpression* pRight = vValue.back();
+			vValue.pop_back();
+			vValue.back() = NewBinary(stPending.eLex, stPending.nOffset, vValue.back(), pRight);
+		}
+
+		vOper.pop_back();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <string>
+#include "Resolver.h"
+
+CResolver::CResolver()
+	: m_pDiag(nullptr), m_nFrameSize(0)
+{
+}
+
+/**
+@brief		Bind the variable references of a program and compute the frame sizes
+@param		prog		Program
+@param		pDiag		Diagnostics (nullptr: dropped; offsets are those of the nodes)
+@return		false if a name was declared twice or is unknown
+			(unknown names are left Unresolved; the rest of the program is still bound)
+*/
+bool CResolver::Resolve(stProgram& prog, CDiagnostics* pDiag)
+{
+	CDiagnostics diagLocal;
+	m_pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+	size_t nErrors = m_pDiag->ErrorCount();
+
+	m_vTop.assign(CSymbolTable::Global().Size(), 0);
+	m_vFunc.assign(CSymbolTable::Global().Size(), 0);
+
+	// Functions can be called before their definition
+	for (size_t i = 0; i < prog.vFunc.size(); ++i)
+	{
+		stFunction* pFunc = prog.vFunc[i];
+		Reserve(pFunc->nSymbol);
+
+		if (m_vFunc[pFunc->nSymbol] != 0)
+			Report(pFunc->nOffset, "Redefinition of function", pFunc->nSymbol);
+		else
+			m_vFunc[pFunc->nSymbol] = (unsigned int)i + 1;
+	}
+
+	for (stFunction* pFunc : prog.vFunc)
+		ResolveFunction(pFunc);
+
+	bool bResolved = m_pDiag->ErrorCount() == nErrors;
+	m_pDiag = nullptr;
+
+	return bResolved;
+}
+
+/**
+@brief		Bind the references of a function
+@param		pFunc		Function
+@return
+*/
+void CResolver::ResolveFunction(stFunction* pFunc)
+{
+	m_vTask.clear();
+	m_vLocal.clear();
+	m_vScope.clear();
+	m_nFrameSize = 0;
+
+	// The parameters and the body share the function scope
+	m_vScope.push_back(0);
+	for (SymbolID nParam : pFunc->vParams)
+	{
+		unsigned int nSlot;
+		Declare(nParam, pFunc->nOffset, nSlot);
+	}
+
+	for (size_t i = pFunc->vBlock.size(); i-- > 0;)
+		PushStatement(pFunc->vBlock[i]);
+
+	while (m_vTask.empty() == false)
+	{
+		stTask stTaskData = m_vTask.back();
+		m_vTask.pop_back();
+
+		switch (stTaskData.eKind)
+		{
+			case eTaskKind::Statement:
+				ResolveStatement(stTaskData.pState);
+				break;
+			case eTaskKind::Expression:
+				ResolveExpression(stTaskData.pExp);
+				break;
+			case eTaskKind::ScopeBegin:
+				m_vScope.push_back((unsigned int)m_vLocal.size());
+				break;
+			case eTaskKind::ScopeEnd:
+				EndScope();
+				break;
+			case eTaskKind::Declare:
+			{
+				stVariable* pVar = static_cast<stVariable*>(stTaskData.pState);
+				Declare(pVar->nSymbol, pVar->nOffset, pVar->nSlot);
+				break;
+			}
+		}
+	}
+
+	EndScope();
+	pFunc->nFrameSize = m_nFrameSize;
+}
+
+/**
+@brief		Push the tasks of a statement (children are pushed in reverse, so they come out in source order)
+@param		pState		Statement
+@return
+*/
+void CResolver::ResolveStatement(stStatement* pState)
+{
+	switch (pState->eKind)
+	{
+		case eNodeKind::Variable:
+		{
+			stVariable* pVar = static_cast<stVariable*>(pState);
+			PushTask(eTaskKind::Declare, pVar);
+			PushExpression(pVar->stExp);
+			break;
+		}
+		case eNodeKind::ExpStatement:
+			PushExpression(static_cast<stExpStatement*>(pState)->stExp);
+			break;
+		case eNodeKind::Return:
+			PushExpression(static_cast<stReturn*>(pState)->stExp);
+			break;
+		case eNodeKind::For:
+		{
+			// The init-statement is seen by the condition, the loop expression and the block
+			stFor* pFor = static_cast<stFor*>(pState);
+			PushTask(eTaskKind::ScopeEnd);
+			AddBlock(pFor->stBlock);
+			PushExpression(pFor->stLoopExp);
+			PushExpression(pFor->stCondExp);
+			PushStatement(pFor->stVar);
+			PushTask(eTaskKind::ScopeBegin);
+			break;
+		}
+		case eNodeKind::While:
+		{
+			stWhile* pWhile = static_cast<stWhile*>(pState);
+			AddBlock(pWhile->stBlock);
+			PushExpression(pWhile->stCondExp);
+			break;
+		}
+		case eNodeKind::If:
+		{
+			stIf* pIf = static_cast<stIf*>(pState);
+			AddBlock(pIf->vElseBlock);
+			for (size_t i = pIf->vIfBlock.size(); i-- > 0;)
+				AddBlock(pIf->vIfBlock[i]);
+			for (size_t i = pIf->stCondStm.size(); i-- > 0;)
+				PushExpression(pIf->stCondStm[i]);
+			break;
+		}
+		case eNodeKind::Switch:
+		{
+			stSwitch* pSwitch = static_cast<stSwitch*>(pState);
+			AddBlock(pSwitch->vDefaultBlock);
+			for (size_t i = pSwitch->vCaseBlock.size(); i-- > 0;)
+				AddBlock(pSwitch->vCaseBlock[i]);
+			for (size_t i = pSwitch->stCondStm.size(); i-- > 0;)
+				PushExpression(pSwitch->stCondStm[i]);
+			PushExpression(pSwitch->stExp);
+			break;
+		}
+		case eNodeKind::Print:
+		{
+			stPrint* pPrint = static_cast<stPrint*>(pState);
+			for (size_t i = pPrint->stArgs.size(); i-- > 0;)
+				PushExpression(pPrint->stArgs[i]);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Bind a variable expression or push the tasks of its children
+@param		pExp		Expression
+@return
+*/
+void CResolver::ResolveExpression(stExpression* pExp)
+{
+	switch (pExp->eKind)
+	{
+		case eNodeKind::GetVariable:
+		{
+			stGetVariable* pGetVar = static_cast<stGetVariable*>(pExp);
+			Bind(pGetVar->nSymbol, pGetVar->nOffset, pGetVar->stBind);
+			break;
+		}
+		case eNodeKind::SetVariable:
+		{
+			stSetVariable* pSetVar = static_cast<stSetVariable*>(pExp);
+			Bind(pSetVar->nSymbol, pSetVar->nOffset, pSetVar->stBind);
+			PushExpression(pSetVar->stInitExp);
+			break;
+		}
+		case eNodeKind::And:
+		{
+			stAnd* pAnd = static_cast<stAnd*>(pExp);
+			PushExpression(pAnd->stRight);
+			PushExpression(pAnd->stLeft);
+			break;
+		}
+		case eNodeKind::Or:
+		{
+			stOr* pOr = static_cast<stOr*>(pExp);
+			PushExpression(pOr->stRight);
+			PushExpression(pOr->stLeft);
+			break;
+		}
+		case eNodeKind::Relational:
+		{
+			stRelational* pRel = static_cast<stRelational*>(pExp);
+			PushExpression(pRel->stRight);
+			PushExpression(pRel->stLeft);
+			break;
+		}
+		case eNodeKind::Arithmetic:
+		{
+			stArithmetic* pArith = static_cast<stArithmetic*>(pExp);
+			PushExpression(pArith->stRight);
+			PushExpression(pArith->stLeft);
+			break;
+		}
+		case eNodeKind::Unary:
+			PushExpression(static_cast<stUnary*>(pExp)->stSubExp);
+			break;
+		case eNodeKind::Convert:
+			PushExpression(static_cast<stConvert*>(pExp)->stSubExp);
+			break;
+		case eNodeKind::GetElement:
+		{
+			stGetElement* pGetElem = static_cast<stGetElement*>(pExp);
+			PushExpression(pGetElem->stIndexExp);
+			PushExpression(pGetElem->stMemsExp);
+			break;
+		}
+		case eNodeKind::SetElement:
+		{
+			stSetElement* pSetElem = static_cast<stSetElement*>(pExp);
+			PushExpression(pSetElem->stInitExp);
+			PushExpression(pSetElem->stIndexExp);
+			PushExpression(pSetElem->stMemsExp);
+			break;
+		}
+		case eNodeKind::CallFunc:
+		{
+			stCallFunc* pCall = static_cast<stCallFunc*>(pExp);
+			for (size_t i = pCall->vArgsExp.size(); i-- > 0;)
+				PushExpression(pCall->vArgsExp[i]);
+			PushExpression(pCall->stSubExp);
+			break;
+		}
+		case eNodeKind::Array:
+		{
+			stArray* pArray = static_cast<stArray*>(pExp);
+			for (int i = pArray->Size(); i-- > 0;)
+				PushExpression(pArray->Get(i));
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Declare a variable in the innermost scope
+@param		nSymbol		Variable name
+@param		nOffset		Source offset (for the diagnostic)
+@param		nSlot		(out) Frame slot
+@return
+*/
+void CResolver::Declare(SymbolID nSymbol, size_t nOffset, unsigned int& nSlot)
+{
+	Reserve(nSymbol);
+
+	unsigned int nScope = (unsigned int)m_vScope.size() - 1;
+	unsigned int nTop = m_vTop[nSymbol];
+
+	// A redeclaration still gets its own slot, so the nodes after it stay bound
+	if (nTop != 0 &&
+		m_vLocal[nTop - 1].nScope == nScope)
+		Report(nOffset, "Redeclaration of", nSymbol);
+
+	nSlot = (unsigned int)m_vLocal.size();
+	m_vLocal.push_back(stLocal{ nSymbol, nScope, nTop });
+	m_vTop[nSymbol] = (unsigned int)m_vLocal.size();
+	m_nFrameSize = std::max(m_nFrameSize, (unsigned int)m_vLocal.size());
+}
+
+/**
+@brief		Bind a reference to the innermost variable of its name, or to a function
+@param		nSymbol		Name
+@param		nOffset		Source offset (for the diagnostic)
+@param		stBind		(out) Binding
+@return
+*/
+void CResolver::Bind(SymbolID nSymbol, size_t nOffset, stBinding& stBind)
+{
+	Reserve(nSymbol);
+	stBind = stBinding();
+
+	if (m_vTop[nSymbol] != 0)
+	{
+		unsigned int nSlot = m_vTop[nSymbol] - 1;
+		stBind.eKind = eBindKind::Local;
+		stBind.nDepth = (unsigned short)std::min<size_t>(m_vScope.size() - 1 - m_vLocal[nSlot].nScope, 0xFFFF);
+		stBind.nSlot = nSlot;
+	}
+	else if (m_vFunc[nSymbol] != 0)
+	{
+		stBind.eKind = eBindKind::Function;
+		stBind.nSlot = m_vFunc[nSymbol] - 1;
+	}
+	else
+	{
+		Report(nOffset, "Unknown name", nSymbol);
+	}
+}
+
+/**
+@brief		Close the innermost scope (its variables go out of the name chains)
+@return
+*/
+void CResolver::EndScope()
+{
+	unsigned int nBegin = m_vScope.back();
+	m_vScope.pop_back();
+
+	while (m_vLocal.size() > nBegin)
+	{
+		m_vTop[m_vLocal.back().nSymbol] = m_vLocal.back().nPrev;
+		m_vLocal.pop_back();
+	}
+}
+
+/**
+@brief		Push a block as a nested scope
+@param		vBlock		Block
+@return
+*/
+void CResolver::AddBlock(const vstStatement& vBlock)
+{
+	PushTask(eTaskKind::ScopeEnd);
+	for (size_t i = vBlock.size(); i-- > 0;)
+		PushStatement(vBlock[i]);
+	PushTask(eTaskKind::ScopeBegin);
+}
+
+/**
+@brief		Add an error about a name
+@param		nOffset		Source offset
+@param		strWhat		Message before the name
+@param		nSymbol		Name
+@return
+*/
+void CResolver::Report(size_t nOffset, std::string_view strWhat, SymbolID nSymbol)
+{
+	m_pDiag->Error(nOffset, std::string(strWhat) + " '" + std::string(CSymbolTable::Global().GetName(nSymbol)) + "'.");
+}
\ No newline at end of file
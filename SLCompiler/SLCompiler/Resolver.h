@@ -0,0 +1,115 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include "Diagnostics.h"
+#include "Structures.h"
+
+// Scope resolver (semantic pass)
+// Binds every variable reference of a program to a frame slot of its function, or to a
+// top-level function, so that an execution engine can keep locals in an array.
+// A function body is one scope with the parameters (slots 0..n-1); every block of a
+// for/while/if/switch is a nested scope, and a for has one more scope around its
+// init-statement. A variable is declared after its initializer, so "int a = a;" reads an
+// outer a. Sibling scopes reuse the slots of each other, and the frame size is the most
+// locals that are alive at once. Names are looked up through a chain per symbol (the
+// innermost declaration first), so a lookup does not search the scopes.
+// Nodes are visited with an explicit stack of tasks, so any nesting depth the parser
+// accepts can be resolved.
+class CResolver
+{
+// Enums and Classes, Structures ==========================================================
+private:
+	enum class eTaskKind : unsigned char
+	{
+		Statement,
+		Expression,
+		ScopeBegin,
+		ScopeEnd,
+		// Declare pState (a stVariable) once its initializer is resolved
+		Declare,
+	};
+
+	struct stTask
+	{
+	public:
+		eTaskKind eKind;
+		stStatement* pState;
+		stExpression* pExp;
+	};
+
+	// Variable that is alive
+	struct stLocal
+	{
+	public:
+		SymbolID nSymbol;
+		// Scope index (0: function scope)
+		unsigned int nScope;
+		// Declaration of the same symbol that this one hides (m_vLocal index + 1, 0: none)
+		unsigned int nPrev;
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	CDiagnostics* m_pDiag;
+	// Tasks that are waiting to be resolved (last in, first out)
+	std::vector<stTask> m_vTask;
+	// Variables that are alive, in declaration order (the index is the frame slot)
+	std::vector<stLocal> m_vLocal;
+	// Innermost declaration of each symbol (m_vLocal index + 1, 0: none)
+	std::vector<unsigned int> m_vTop;
+	// Function of each symbol (stProgram::vFunc index + 1, 0: none)
+	std::vector<unsigned int> m_vFunc;
+	// m_vLocal size at the start of each open scope
+	std::vector<unsigned int> m_vScope;
+	unsigned int m_nFrameSize;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CResolver();
+
+	bool Resolve(stProgram& prog, CDiagnostics* pDiag = nullptr);
+
+private:
+	void ResolveFunction(stFunction* pFunc);
+	void ResolveStatement(stStatement* pState);
+	void ResolveExpression(stExpression* pExp);
+	void Declare(SymbolID nSymbol, size_t nOffset, unsigned int& nSlot);
+	void Bind(SymbolID nSymbol, size_t nOffset, stBinding& stBind);
+	void EndScope();
+	void AddBlock(const vstStatement& vBlock);
+	void Report(size_t nOffset, std::string_view strWhat, SymbolID nSymbol);
+
+	inline void PushStatement(stStatement* pState)
+	{
+		if (pState != nullptr)
+			m_vTask.push_back(stTask{ eTaskKind::Statement, pState, nullptr });
+	}
+
+	inline void PushExpression(stExpression* pExp)
+	{
+		if (pExp != nullptr)
+			m_vTask.push_back(stTask{ eTaskKind::Expression, nullptr, pExp });
+	}
+
+	inline void PushTask(eTaskKind eKind, stStatement* pState = nullptr)
+	{
+		m_vTask.push_back(stTask{ eKind, pState, nullptr });
+	}
+
+	// Symbol tables are indexed by SymbolID (names can be interned after Resolve() starts)
+	inline void Reserve(SymbolID nSymbol)
+	{
+		if (nSymbol >= m_vTop.size())
+		{
+			m_vTop.resize((size_t)nSymbol + 1, 0);
+			m_vFunc.resize((size_t)nSymbol + 1, 0);
+		}
+	}
+
+// ========================================================================================
+
+};
\ No newline at end of file
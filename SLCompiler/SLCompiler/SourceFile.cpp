@@ -0,0 +1,143 @@
+#include <fstream>
+#include <iterator>
+#include "SourceFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CSourceFile::CSourceFile()
+	: m_pData(""), m_nSize(0), m_bMapped(false)
+#ifdef _WIN32
+	, m_hFile(INVALID_HANDLE_VALUE), m_hMapping(nullptr)
+#endif
+{}
+
+CSourceFile::~CSourceFile()
+{
+	Close();
+}
+
+/**
+@brief		Open and map the source file
+@param		strPath		File path
+@return		Whether the file could be opened
+*/
+bool CSourceFile::Open(const std::string& strPath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(strPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER nFileSize;
+	SYSTEM_INFO stInfo;
+	GetSystemInfo(&stInfo);
+
+	// The zero fill after the end of file is only there if the last page is not full
+	if (GetFileSizeEx(hFile, &nFileSize) == FALSE ||
+		nFileSize.QuadPart == 0 ||
+		nFileSize.QuadPart % stInfo.dwPageSize == 0)
+	{
+		CloseHandle(hFile);
+		return ReadAll(strPath);
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* pView = hMapping != nullptr ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (pView == nullptr)
+	{
+		if (hMapping != nullptr)
+			CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return ReadAll(strPath);
+	}
+
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+	m_pData = static_cast<const char*>(pView);
+	m_nSize = (size_t)nFileSize.QuadPart;
+	m_bMapped = true;
+#else
+	int nFd = open(strPath.c_str(), O_RDONLY);
+	if (nFd < 0)
+		return false;
+
+	struct stat stStat;
+	long nPageSize = sysconf(_SC_PAGESIZE);
+
+	// The zero fill after the end of file is only there if the last page is not full
+	if (fstat(nFd, &stStat) != 0 ||
+		stStat.st_size == 0 ||
+		stStat.st_size % nPageSize == 0)
+	{
+		close(nFd);
+		return ReadAll(strPath);
+	}
+
+	void* pView = mmap(nullptr, (size_t)stStat.st_size, PROT_READ, MAP_PRIVATE, nFd, 0);
+	close(nFd);
+	if (pView == MAP_FAILED)
+		return ReadAll(strPath);
+
+	madvise(pView, (size_t)stStat.st_size, MADV_SEQUENTIAL);
+
+	m_pData = static_cast<const char*>(pView);
+	m_nSize = (size_t)stStat.st_size;
+	m_bMapped = true;
+#endif
+
+	return true;
+}
+
+/**
+@brief		Unmap (or free) the source text
+@return
+*/
+void CSourceFile::Close()
+{
+	if (m_bMapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_pData);
+		CloseHandle(m_hMapping);
+		CloseHandle(m_hFile);
+		m_hMapping = nullptr;
+		m_hFile = INVALID_HANDLE_VALUE;
+#else
+		munmap(const_cast<char*>(m_pData), m_nSize);
+#endif
+	}
+
+	m_strOwned.clear();
+	m_strOwned.shrink_to_fit();
+	m_pData = "";
+	m_nSize = 0;
+	m_bMapped = false;
+}
+
+/**
+@brief		Read the whole file into the owned buffer
+@param		strPath		File path
+@return		Whether the file could be read
+*/
+bool CSourceFile::ReadAll(const std::string& strPath)
+{
+	std::ifstream file(strPath, std::ios::binary);
+	if (file.is_open() == false)
+		return false;
+
+	m_strOwned.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	m_pData = m_strOwned.c_str();
+	m_nSize = m_strOwned.size();
+	return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Source code file
+// The file is memory-mapped read-only. The text is always followed by a '\0'
+// (the zero fill of the last mapped page), so the lexer can scan it in place.
+// When that is not possible (empty file, size is a multiple of the page size,
+// mapping failed) the file is read into an owned buffer instead.
+class CSourceFile
+{
+// Variables ==============================================================================
+private:
+	// Mapped text (or m_strOwned.c_str())
+	const char* m_pData;
+	// Text size (without the terminating '\0')
+	size_t m_nSize;
+	// Whether m_pData is a mapped view
+	bool m_bMapped;
+	// Fallback buffer
+	std::string m_strOwned;
+#ifdef _WIN32
+	void* m_hFile;
+	void* m_hMapping;
+#endif
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CSourceFile();
+	~CSourceFile();
+	CSourceFile(const CSourceFile&) = delete;
+	CSourceFile& operator=(const CSourceFile&) = delete;
+
+	bool Open(const std::string& strPath);
+	void Close();
+
+	inline const char* Data() const
+	{
+		return m_pData;
+	}
+
+	inline size_t Size() const
+	{
+		return m_nSize;
+	}
+
+	inline std::string_view Text() const
+	{
+		return std::string_view(m_pData, m_nSize);
+	}
+
+	inline bool IsMapped() const
+	{
+		return m_bMapped;
+	}
+
+private:
+	bool ReadAll(const std::string& strPath);
+
+// ========================================================================================
+
+};
@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include "Arena.h"
 #include "Lexer.h"
 
 #define CREATE_CHS(X)	char* chs = new char[X + 1]; \
@@ -54,10 +55,120 @@ void DeleteArray(T p[])
 	p = nullptr;
 }
 
+struct stStatement;
+struct stExpression;
+
+// Child vectors (allocated from the arena of the program)
+typedef std::vector<SymbolID, CArenaAllocator<SymbolID>> vSymbol;
+typedef std::vector<CLexer::eLexEnum, CArenaAllocator<CLexer::eLexEnum>> vLexEnum;
+typedef std::vector<stStatement*, CArenaAllocator<stStatement*>> vstStatement;
+typedef std::vector<stExpression*, CArenaAllocator<stExpression*>> vstExpression;
+typedef std::vector<vstStatement, CArenaAllocator<vstStatement>> vvstStatement;
+
+// Node kind (lets passes switch on a node instead of probing its type)
+enum class eNodeKind : unsigned char
+{
+	// Statements
+	Function,
+	Variable,
+	ExpStatement,
+	Return,
+	For,
+	While,
+	If,
+	Switch,
+	Break,
+	Continue,
+	Print,
+
+	// Expressions
+	NullData,
+	BoolData,
+	IntData,
+	DoubleData,
+	StringData,
+	VoidData,
+	Array,
+	And,
+	Or,
+	Relational,
+	Arithmetic,
+	Unary,
+	GetVariable,
+	SetVariable,
+	GetElement,
+	SetElement,
+	CallFunc,
+	Convert,
+
+	NodeKindMax
+};
+
+// Static type of an expression (set by CTypeChecker)
+enum class eValueType : unsigned char
+{
+	Unknown,				// Not checked, or the type of an expression with errors
+	Null,
+	Bool,
+	Int,
+	Double,
+	String,
+	Void,
+	Array,
+	Function,				// Name of a top-level function
+
+	ValueTypeMax
+};
+
+/**
+@brief		Name of a static type (as it is written in the source)
+@param		eType		Type
+@return		Name
+*/
+inline const char* GetValueTypeName(eValueType eType)
+{
+	static const char* const arrName[static_cast<int>(eValueType::ValueTypeMax)] = {
+		"unknown", "null", "bool", "int", "double", "string", "void", "array", "function"
+	};
+
+	return arrName[static_cast<int>(eType)];
+}
+
+// What a variable reference is bound to (set by CResolver)
+enum class eBindKind : unsigned char
+{
+	Unresolved,
+	Local,					// Parameter or local variable of the function
+	Function,				// Top-level function
+};
+
+// Variable binding
+struct stBinding
+{
+public:
+	eBindKind eKind = eBindKind::Unresolved;
+	// Local: scopes between the reference and the declaration (0: same scope)
+	unsigned short nDepth = 0;
+	// Local: frame slot, Function: index into stProgram::vFunc
+	unsigned int nSlot = 0;
+};
+
 // Statement structure
+// (Nodes live in the arena of stProgram and are never destructed one by one,
+//  so a node does not free its children)
 struct stStatement
 {
 public:
+	// Node kind
+	const eNodeKind eKind;
+	// Source offset (first token; the name of a function)
+	unsigned int nOffset;
+
+	stStatement(eNodeKind eKind)
+		: eKind(eKind), nOffset(0)
+	{}
+
+	virtual ~stStatement() {}
 	virtual void Print(int nSpace) = 0;
 };
 
@@ -65,6 +176,18 @@ public:
 struct stExpression
 {
 public:
+	// Node kind
+	const eNodeKind eKind;
+	// Result type (set by CTypeChecker)
+	eValueType eValType;
+	// Source offset (first token; the operator of a binary expression)
+	unsigned int nOffset;
+
+	stExpression(eNodeKind eKind)
+		: eKind(eKind), eValType(eValueType::Unknown), nOffset(0)
+	{}
+
+	virtual ~stExpression() {}
 	virtual void Print(int nSpace) = 0;
 };
 
@@ -76,14 +199,9 @@ public:
 	stExpression* stExp;
 
 	stExpStatement()
-		: stExp(nullptr)
+		: stStatement(eNodeKind::ExpStatement), stExp(nullptr)
 	{}
 
-	~stExpStatement()
-	{
-		DeletePtr<stExpression>(stExp);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -98,28 +216,30 @@ public:
 struct stFunction : stStatement
 {
 public:
-	// Function name
-	std::string strName;
-	// Function parameter name
-	std::vector<std::string> vParams;
+	// Function name (symbol ID)
+	SymbolID nSymbol;
+	// Function parameter name (symbol ID)
+	vSymbol vParams;
+	// Function parameter type (Unknown if it is not written)
+	vLexEnum vParamTypes;
 	// Function block
-	std::vector<stStatement*> vBlock;
+	vstStatement vBlock;
+	// Return type
+	CLexer::eLexEnum eType;
+	// Frame slots of the parameters and local variables (set by CResolver)
+	unsigned int nFrameSize;
 
 	stFunction()
-		: strName("")
+		: stStatement(eNodeKind::Function), nSymbol(CSymbolTable::INVALID_SYMBOL), eType(CLexer::eLexEnum::Void), nFrameSize(0)
 	{}
 
-	~stFunction()
-	{
-		DeleteVectorPtrArgs<stStatement>(vBlock);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
 		std::string strParam = "";
-		std::for_each(vParams.begin(), vParams.end(), [&strParam](std::string& str) {strParam += strParam + " "; });
-		printf("%sFunction %s(%s):\n", chs, strName.c_str(), strParam.c_str());
+		std::for_each(vParams.begin(), vParams.end(), [&strParam](SymbolID nParam) {strParam += std::string(CSymbolTable::Global().GetName(nParam)) + " "; });
+		std::string strName(CSymbolTable::Global().GetName(nSymbol));
+		printf("%sFunction(%s) %s(%s):\n", chs, CLexer::FindLexToString(eType).c_str(), strName.c_str(), strParam.c_str());
 		std::for_each(vBlock.begin(), vBlock.end(), [&nSpace](stStatement* pState) {pState->Print(nSpace + 1); });
 		DELETE_CHS;
 	}
@@ -129,25 +249,23 @@ public:
 struct stVariable : stStatement
 {
 public:
-	// Variable name
-	std::string strName;
+	// Variable name (symbol ID)
+	SymbolID nSymbol;
 	// Expression
 	stExpression* stExp;
 	// Data type
 	CLexer::eLexEnum eType;
+	// Frame slot (set by CResolver)
+	unsigned int nSlot;
 
 	stVariable()
-		: strName(""), stExp(nullptr), eType(CLexer::eLexEnum::Int)
+		: stStatement(eNodeKind::Variable), nSymbol(CSymbolTable::INVALID_SYMBOL), stExp(nullptr), eType(CLexer::eLexEnum::Int), nSlot(0)
 	{}
 
-	~stVariable()
-	{
-		DeletePtr<stExpression>(stExp);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
+		std::string strName(CSymbolTable::Global().GetName(nSymbol));
 		printf("%sVariable(%s) %s:\n", chs, CLexer::FindLexToString(eType).c_str(), strName.c_str());
 		if (stExp != nullptr)
 			stExp->Print(nSpace + 1);
@@ -163,14 +281,9 @@ public:
 	stExpression* stExp;
 
 	stReturn()
-		: stExp(nullptr)
+		: stStatement(eNodeKind::Return), stExp(nullptr)
 	{}
 
-	~stReturn()
-	{
-		DeletePtr<stExpression>(stExp);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -192,20 +305,12 @@ public:
 	// Loop expression
 	stExpression* stLoopExp;
 	// For block
-	std::vector<stStatement*> stBlock;
+	vstStatement stBlock;
 
 	stFor()
-		: stVar(nullptr), stCondExp(nullptr), stLoopExp(nullptr)
+		: stStatement(eNodeKind::For), stVar(nullptr), stCondExp(nullptr), stLoopExp(nullptr)
 	{}
 
-	~stFor()
-	{
-		DeletePtr<stVariable>(stVar);
-		DeletePtr<stExpression>(stCondExp);
-		DeletePtr<stExpression>(stLoopExp);
-		DeleteVectorPtrArgs<stStatement>(stBlock);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -232,18 +337,12 @@ public:
 	// Condition expression
 	stExpression* stCondExp;
 	// While block
-	std::vector<stStatement*> stBlock;
+	vstStatement stBlock;
 
 	stWhile()
-		: stCondExp(nullptr)
+		: stStatement(eNodeKind::While), stCondExp(nullptr)
 	{}
 
-	~stWhile()
-	{
-		DeletePtr<stExpression>(stCondExp);
-		DeleteVectorPtrArgs<stStatement>(stBlock);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -262,27 +361,16 @@ struct stIf : stStatement
 {
 public:
 	// If condition statements
-	std::vector<stExpression*> stCondStm;
+	vstExpression stCondStm;
 	// If expression block
-	std::vector<std::vector<stStatement*>> vIfBlock;
+	vvstStatement vIfBlock;
 	// Else expression block
-	std::vector<stStatement*> vElseBlock;
+	vstStatement vElseBlock;
 
 	stIf()
+		: stStatement(eNodeKind::If)
 	{}
 
-	~stIf()
-	{
-		DeleteVectorPtrArgs<stExpression>(stCondStm);
-		DeleteVectorPtrArgs<stStatement>(vElseBlock);
-
-		int nSize = (int)vIfBlock.size();
-		if (nSize == 0)
-			return;
-		for (int i = 0; i < nSize; ++i)
-			DeleteVectorPtrArgs<stStatement>(vIfBlock[i]);
-	}
-
 	void Print(int nSpace) override
 	{
 		_ASSERT(stCondStm.size() == vIfBlock.size());
@@ -315,26 +403,18 @@ public:
 	// Switch condition statements
 	stExpression* stExp;
 	// Case condition statement
-	std::vector<stExpression*> stCondStm;
-	// Switch case, default statements block
-	std::vector<std::vector<stStatement*>> vCaseBlock;
+	vstExpression stCondStm;
+	// Switch case statements block
+	vvstStatement vCaseBlock;
+	// Switch default statements block
+	vstStatement vDefaultBlock;
+	// Index of the case that follows the default label (vCaseBlock.size() if it is last, -1 if there is none)
+	int nDefaultIdx;
 
 	stSwitch()
-		: stExp(nullptr)
+		: stStatement(eNodeKind::Switch), stExp(nullptr), nDefaultIdx(-1)
 	{}
 
-	~stSwitch()
-	{
-		DeletePtr<stExpression>(stExp);
-		DeleteVectorPtrArgs<stExpression>(stCondStm);
-
-		int nSize = (int)vCaseBlock.size();
-		if (nSize == 0)
-			return;
-		for (int i = 0; i < nSize; ++i)
-			DeleteVectorPtrArgs<stStatement>(vCaseBlock[i]);
-	}
-
 	void Print(int nSpace) override
 	{
 		_ASSERT(stCondStm.size() == vCaseBlock.size());
@@ -345,8 +425,17 @@ public:
 		if (stExp != nullptr)
 			stExp->Print(nSpace + 2);
 		int nSize = (int)stCondStm.size();
-		for (int i = 0; i < nSize; ++i)
+		for (int i = 0; i <= nSize; ++i)
 		{
+			if (i == nDefaultIdx)
+			{
+				printf("%s Default:\n", chs);
+				printf("%s Block:\n", chs);
+				std::for_each(vDefaultBlock.begin(), vDefaultBlock.end(), [&nSpace](stStatement* pState) {pState->Print(nSpace + 2); });
+			}
+			if (i == nSize)
+				break;
+
 			printf("%s Case:\n", chs);
 			printf("%s Condition-expression:\n", chs);
 			stCondStm[i]->Print(nSpace + 2);
@@ -361,6 +450,10 @@ public:
 struct stBreak : stStatement
 {
 public:
+	stBreak()
+		: stStatement(eNodeKind::Break)
+	{}
+
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -373,6 +466,10 @@ public:
 struct stContinue : stStatement
 {
 public:
+	stContinue()
+		: stStatement(eNodeKind::Continue)
+	{}
+
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -385,25 +482,20 @@ public:
 struct stPrint : stStatement
 {
 public:
-	// Print format
-	std::string strFormat;
+	// Print format (copied into the arena)
+	std::string_view strFormat;
 	// Print arguments
-	std::vector<stExpression*> stArgs;
+	vstExpression stArgs;
 
 	stPrint()
-		: strFormat("")
+		: stStatement(eNodeKind::Print)
 	{}
 
-	~stPrint()
-	{
-		DeleteVectorPtrArgs<stExpression>(stArgs);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
 		printf("%sPrint:\n", chs);
-		printf("%s Format: %s\n", chs, strFormat.c_str());
+		printf("%s Format: %.*s\n", chs, (int)strFormat.size(), strFormat.data());
 		printf("%s Arguments:\n", chs);
 		std::for_each(stArgs.begin(), stArgs.end(), [&nSpace](stExpression* pExp) {pExp->Print(nSpace + 2); });
 		DELETE_CHS;
@@ -414,6 +506,10 @@ public:
 struct stNullData : stExpression
 {
 public:
+	stNullData()
+		: stExpression(eNodeKind::NullData)
+	{}
+
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -430,7 +526,7 @@ public:
 	bool bData;
 
 	stBoolData()
-		: bData(false)
+		: stExpression(eNodeKind::BoolData), bData(false)
 	{}
 
 	void Print(int nSpace) override
@@ -449,7 +545,7 @@ public:
 	int nData;
 
 	stIntData()
-		: nData(0)
+		: stExpression(eNodeKind::IntData), nData(0)
 	{}
 
 	void Print(int nSpace) override
@@ -468,7 +564,7 @@ public:
 	double dData;
 
 	stDoubleData()
-		: dData(0.0)
+		: stExpression(eNodeKind::DoubleData), dData(0.0)
 	{}
 
 	void Print(int nSpace) override
@@ -483,17 +579,17 @@ public:
 struct stStringData : stExpression
 {
 public:
-	// Data
-	std::string strData;
+	// Data (copied into the arena)
+	std::string_view strData;
 
 	stStringData()
-		: strData("")
+		: stExpression(eNodeKind::StringData)
 	{}
 
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
-		printf("%sString Data: %s\n", chs, strData.c_str());
+		printf("%sString Data: %.*s\n", chs, (int)strData.size(), strData.data());
 		DELETE_CHS;
 	}
 };
@@ -506,7 +602,7 @@ public:
 	void* pVoid;
 
 	stVoidData()
-		: pVoid(nullptr)
+		: stExpression(eNodeKind::VoidData), pVoid(nullptr)
 	{}
 
 	void Print(int nSpace) override
@@ -522,59 +618,44 @@ struct stArray : stExpression
 {
 private:
 	// Array
-	stExpression** m_stArrExp;
-	int m_nSize;
+	vstExpression m_vArrExp;
 
 public:
 	stArray(int nSize)
-		: m_stArrExp(nullptr), m_nSize(0)
+		: stExpression(eNodeKind::Array)
 	{
 		if (nSize <= 0)
 			return;
 
-		m_nSize = nSize;
-		m_stArrExp = new stExpression* [nSize];
+		m_vArrExp.resize(nSize, nullptr);
 	}
 
-	~stArray()
+	void Destroy()
 	{
-		Destroy();
+		m_vArrExp.clear();
 	}
 
-	void Destroy()
+	int Size() const
 	{
-		m_nSize = 0;
-
-		if (m_stArrExp != nullptr)
-		{
-			delete[] m_stArrExp;
-			m_stArrExp = nullptr;
-		}
+		return (int)m_vArrExp.size();
 	}
 
 	stExpression* Get(int nIdx)
 	{
 		if (nIdx <= 0 ||
-			nIdx >= m_nSize)
-			return nullptr;
-
-		if (m_stArrExp == nullptr)
+			nIdx >= (int)m_vArrExp.size())
 			return nullptr;
 
-		return m_stArrExp[nIdx];
+		return m_vArrExp[nIdx];
 	}
 
 	void Set(int nIdx, stExpression* pExp)
 	{
 		if (nIdx <= 0 ||
-			nIdx >= m_nSize)
+			nIdx >= (int)m_vArrExp.size())
 			return;
 
-		if (m_stArrExp == nullptr)
-			return;
-
-		delete m_stArrExp[nIdx];
-		m_stArrExp[nIdx] = pExp;
+		m_vArrExp[nIdx] = pExp;
 	}
 
 	void Print(int nSpace) override
@@ -595,15 +676,9 @@ public:
 	stExpression* stRight;
 
 	stAnd()
-		: stLeft(nullptr), stRight(nullptr)
+		: stExpression(eNodeKind::And), stLeft(nullptr), stRight(nullptr)
 	{}
 
-	~stAnd()
-	{
-		DeletePtr<stExpression>(stLeft);
-		DeletePtr<stExpression>(stRight);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -628,15 +703,9 @@ public:
 	stExpression* stRight;
 
 	stOr()
-		: stLeft(nullptr), stRight(nullptr)
+		: stExpression(eNodeKind::Or), stLeft(nullptr), stRight(nullptr)
 	{}
 
-	~stOr()
-	{
-		DeletePtr<stExpression>(stLeft);
-		DeletePtr<stExpression>(stRight);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -663,15 +732,9 @@ public:
 	CLexer::eLexEnum eType;
 
 	stRelational()
-		: stLeft(nullptr), stRight(nullptr), eType(CLexer::eLexEnum::Unknown)
+		: stExpression(eNodeKind::Relational), stLeft(nullptr), stRight(nullptr), eType(CLexer::eLexEnum::Unknown)
 	{}
 
-	~stRelational()
-	{
-		DeletePtr<stExpression>(stLeft);
-		DeletePtr<stExpression>(stRight);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -698,15 +761,9 @@ public:
 	CLexer::eLexEnum eType;
 
 	stArithmetic()
-		: stLeft(nullptr), stRight(nullptr), eType(CLexer::eLexEnum::Unknown)
+		: stExpression(eNodeKind::Arithmetic), stLeft(nullptr), stRight(nullptr), eType(CLexer::eLexEnum::Unknown)
 	{}
 
-	~stArithmetic()
-	{
-		DeletePtr<stExpression>(stLeft);
-		DeletePtr<stExpression>(stRight);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -731,14 +788,9 @@ public:
 	CLexer::eLexEnum eType;
 
 	stUnary()
-		: stSubExp(nullptr), eType(CLexer::eLexEnum::Unknown)
+		: stExpression(eNodeKind::Unary), stSubExp(nullptr), eType(CLexer::eLexEnum::Unknown)
 	{}
 
-	~stUnary()
-	{
-		DeletePtr<stExpression>(stSubExp);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -754,8 +806,14 @@ public:
 struct stGetVariable : stExpression
 {
 public:
-	// Variable name
-	std::string strName;
+	// Variable name (symbol ID)
+	SymbolID nSymbol;
+	// Binding (set by CResolver)
+	stBinding stBind;
+
+	stGetVariable()
+		: stExpression(eNodeKind::GetVariable), nSymbol(CSymbolTable::INVALID_SYMBOL)
+	{}
 
 	void Print(int nSpace) override
 	{
@@ -769,20 +827,17 @@ public:
 struct stSetVariable : stExpression
 {
 public:
-	// Variable name
-	std::string strName;
+	// Variable name (symbol ID)
+	SymbolID nSymbol;
+	// Binding (set by CResolver)
+	stBinding stBind;
 	// Initialize expression
 	stExpression* stInitExp;
 
 	stSetVariable()
-		: strName(""), stInitExp(nullptr)
+		: stExpression(eNodeKind::SetVariable), nSymbol(CSymbolTable::INVALID_SYMBOL), stInitExp(nullptr)
 	{}
 
-	~stSetVariable()
-	{
-		DeletePtr<stExpression>(stInitExp);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -801,15 +856,9 @@ public:
 	stExpression* stIndexExp;
 
 	stGetElement()
-		: stMemsExp(nullptr), stIndexExp(nullptr)
+		: stExpression(eNodeKind::GetElement), stMemsExp(nullptr), stIndexExp(nullptr)
 	{}
 
-	~stGetElement()
-	{
-		DeletePtr<stExpression>(stMemsExp);
-		DeletePtr<stExpression>(stIndexExp);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -830,16 +879,9 @@ public:
 	stExpression* stInitExp;
 
 	stSetElement()
-		: stMemsExp(nullptr), stIndexExp(nullptr), stInitExp(nullptr)
+		: stExpression(eNodeKind::SetElement), stMemsExp(nullptr), stIndexExp(nullptr), stInitExp(nullptr)
 	{}
 
-	~stSetElement()
-	{
-		DeletePtr<stExpression>(stMemsExp);
-		DeletePtr<stExpression>(stIndexExp);
-		DeletePtr<stExpression>(stInitExp);
-	}
-
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
@@ -855,41 +897,63 @@ public:
 	// Subsituation expression
 	stExpression* stSubExp;
 	// Function arguments
-	std::vector<stExpression*> vArgsExp;
+	vstExpression vArgsExp;
 
 	stCallFunc()
-		: stSubExp(nullptr)
+		: stExpression(eNodeKind::CallFunc), stSubExp(nullptr)
 	{}
 
-	~stCallFunc()
+	void Print(int nSpace) override
 	{
-		DeleteVectorPtrArgs<stExpression>(vArgsExp);
+		CREATE_CHS(nSpace);
+
+		DELETE_CHS;
 	}
+};
+
+// Conversion expression structure (inserted by CTypeChecker; eValType is the target type)
+struct stConvert : stExpression
+{
+public:
+	// Converted expression
+	stExpression* stSubExp;
+
+	stConvert()
+		: stExpression(eNodeKind::Convert), stSubExp(nullptr)
+	{}
 
 	void Print(int nSpace) override
 	{
 		CREATE_CHS(nSpace);
-
+		printf("%sConvert(%s):\n", chs, GetValueTypeName(eValType));
+		if (stSubExp != nullptr)
+			stSubExp->Print(nSpace + 1);
 		DELETE_CHS;
 	}
 };
 
 // Program structure
+// (Owns the arena of every node; deleting the program releases the arena at once)
 struct stProgram
 {
 public:
+	// Node storage
+	CArena arena;
+	// Node storage of the parallel parser (one arena per chunk of functions)
+	std::vector<std::unique_ptr<CArena>> vChunkArena;
 	std::vector<stFunction*> vFunc;
+	// Node count (Set by the parser)
+	size_t nNodeCount;
 
-	~stProgram()
-	{
-		DeleteVectorPtrArgs<stFunction>(vFunc);
-	}
+	stProgram(CArena::eMode eArenaMode = CArena::eMode::Block)
+		: arena(eArenaMode), nNodeCount(0)
+	{}
 
 	void Print()
 	{
 		std::vector<stFunction*>::iterator iter = vFunc.begin();
 
-		while (iter != vFunc.begin())
+		while (iter != vFunc.end())
 		{
 			(*iter)->Print(0);
 
@@ -0,0 +1,85 @@
+#include <cstring>
+#include "SymbolTable.h"
+
+CSymbolTable::CSymbolTable()
+	: m_pBlockPos(nullptr), m_nBlockLeft(0)
+{}
+
+/**
+@brief		Global symbol table (shared by the lexer, the parser and every later pass)
+@return		Global symbol table
+*/
+CSymbolTable& CSymbolTable::Global()
+{
+	static CSymbolTable symbols;
+	return symbols;
+}
+
+/**
+@brief		Intern a name
+@param		strName		Name
+@return		Symbol ID of the name (new ID if the name was not interned yet)
+*/
+SymbolID CSymbolTable::Intern(std::string_view strName)
+{
+	std::unordered_map<std::string_view, SymbolID>::const_iterator iter = m_mapSymbol.find(strName);
+	if (iter != m_mapSymbol.end())
+		return iter->second;
+
+	SymbolID nSymbol = (SymbolID)m_vName.size();
+	std::string_view strCopy = CopyName(strName);
+	m_vName.push_back(strCopy);
+	m_mapSymbol.emplace(strCopy, nSymbol);
+
+	return nSymbol;
+}
+
+/**
+@brief		Find a name without interning it
+@param		strName		Name
+@return		Symbol ID of the name (INVALID_SYMBOL if the name is not interned)
+*/
+SymbolID CSymbolTable::Find(std::string_view strName) const
+{
+	std::unordered_map<std::string_view, SymbolID>::const_iterator iter = m_mapSymbol.find(strName);
+	if (iter != m_mapSymbol.end())
+		return iter->second;
+	return INVALID_SYMBOL;
+}
+
+/**
+@brief		Remove every symbol (IDs handed out before are invalid afterwards)
+@return
+*/
+void CSymbolTable::Clear()
+{
+	m_mapSymbol.clear();
+	m_vName.clear();
+	m_vBlock.clear();
+	m_pBlockPos = nullptr;
+	m_nBlockLeft = 0;
+}
+
+/**
+@brief		Copy a name into the name storage
+@param		strName		Name
+@return		Copied name
+*/
+std::string_view CSymbolTable::CopyName(std::string_view strName)
+{
+	if (strName.size() > m_nBlockLeft)
+	{
+		size_t nBlockSize = strName.size() > NAME_BLOCK_SIZE ? strName.size() : NAME_BLOCK_SIZE;
+		m_vBlock.emplace_back(new char[nBlockSize]);
+		m_pBlockPos = m_vBlock.back().get();
+		m_nBlockLeft = nBlockSize;
+	}
+
+	if (strName.empty() == false)
+		memcpy(m_pBlockPos, strName.data(), strName.size());
+	std::string_view strCopy(m_pBlockPos, strName.size());
+	m_pBlockPos += strName.size();
+	m_nBlockLeft -= strName.size();
+
+	return strCopy;
+}
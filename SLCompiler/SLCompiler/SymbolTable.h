@@ -0,0 +1,63 @@
+#pragma once
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Symbol ID (interned identifier)
+typedef unsigned int SymbolID;
+
+// Symbol table
+// Interns identifier names so that later stages compare 32-bit IDs instead of strings.
+// IDs are handed out in first-intern order. Names are copied into the table, so they
+// stay valid after the source buffer is released.
+// A table is not thread-safe; the parallel lexer interns into one table per chunk
+// and merges them into the global table in source order.
+class CSymbolTable
+{
+// Variables ==============================================================================
+public:
+	static constexpr SymbolID INVALID_SYMBOL = 0xFFFFFFFFu;
+
+private:
+	static constexpr size_t NAME_BLOCK_SIZE = 64 * 1024;
+
+	std::unordered_map<std::string_view, SymbolID> m_mapSymbol;
+	std::vector<std::string_view> m_vName;
+	// Name storage
+	std::vector<std::unique_ptr<char[]>> m_vBlock;
+	char* m_pBlockPos;
+	size_t m_nBlockLeft;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CSymbolTable();
+	CSymbolTable(const CSymbolTable&) = delete;
+	CSymbolTable& operator=(const CSymbolTable&) = delete;
+
+	static CSymbolTable& Global();
+
+	SymbolID Intern(std::string_view strName);
+	SymbolID Find(std::string_view strName) const;
+	void Clear();
+
+	inline std::string_view GetName(SymbolID nSymbol) const
+	{
+		if (nSymbol >= m_vName.size())
+			return std::string_view();
+		return m_vName[nSymbol];
+	}
+
+	inline size_t Size() const
+	{
+		return m_vName.size();
+	}
+
+private:
+	std::string_view CopyName(std::string_view strName);
+
+// ========================================================================================
+
+};
@@ -0,0 +1,115 @@
+#include "ThreadPool.h"
+
+/**
+@brief		Create the worker threads
+@param		nThreads		Threads that run tasks including the caller (0: hardware concurrency)
+*/
+CThreadPool::CThreadPool(int nThreads)
+	: m_nGeneration(0), m_bStop(false)
+{
+	if (nThreads <= 0)
+		nThreads = (int)std::thread::hardware_concurrency();
+	if (nThreads <= 0)
+		nThreads = 1;
+
+	for (int i = 1; i < nThreads; ++i)
+		m_vThreads.emplace_back(&CThreadPool::WorkerMain, this);
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStop = true;
+	}
+	m_cvWork.notify_all();
+
+	for (std::thread& thread : m_vThreads)
+		thread.join();
+}
+
+/**
+@brief		Run tasks on the pool and wait for them
+@param		nTasks		Task count
+@param		fnTask		Task (called with the task index)
+@return
+*/
+void CThreadPool::Run(int nTasks, const std::function<void(int)>& fnTask)
+{
+	if (nTasks <= 0)
+		return;
+
+	if (m_vThreads.empty() ||
+		nTasks == 1)
+	{
+		for (int i = 0; i < nTasks; ++i)
+			fnTask(i);
+		return;
+	}
+
+	std::shared_ptr<stJob> pJob = std::make_shared<stJob>();
+	pJob->pTask = &fnTask;
+	pJob->nTasks = nTasks;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pJob = pJob;
+		++m_nGeneration;
+	}
+	m_cvWork.notify_all();
+
+	// The calling thread works too
+	RunTasks(*pJob);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_cvDone.wait(lock, [&pJob]() { return pJob->nDone.load() == pJob->nTasks; });
+	m_pJob.reset();
+}
+
+/**
+@brief		Worker thread main loop
+@return
+*/
+void CThreadPool::WorkerMain()
+{
+	unsigned long long nSeenGeneration = 0;
+
+	while (true)
+	{
+		std::shared_ptr<stJob> pJob;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cvWork.wait(lock, [this, nSeenGeneration]() { return m_bStop || m_nGeneration != nSeenGeneration; });
+			if (m_bStop)
+				return;
+
+			nSeenGeneration = m_nGeneration;
+			pJob = m_pJob;
+		}
+
+		if (pJob != nullptr)
+			RunTasks(*pJob);
+	}
+}
+
+/**
+@brief		Run tasks of the job until there are none left
+@param		stJobData		Job
+@return
+*/
+void CThreadPool::RunTasks(stJob& stJobData)
+{
+	while (true)
+	{
+		int nIdx = stJobData.nNext.fetch_add(1);
+		if (nIdx >= stJobData.nTasks)
+			break;
+
+		(*stJobData.pTask)(nIdx);
+
+		if (stJobData.nDone.fetch_add(1) + 1 == stJobData.nTasks)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_cvDone.notify_all();
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool
+// Run() hands out task indices [0, nTasks) to the worker threads and the calling
+// thread, and returns when every task has finished.
+class CThreadPool
+{
+// Enums and Classes, Structures ==========================================================
+private:
+	// One Run() call
+	struct stJob
+	{
+	public:
+		const std::function<void(int)>* pTask = nullptr;
+		int nTasks = 0;
+		std::atomic<int> nNext{ 0 };
+		std::atomic<int> nDone{ 0 };
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	std::vector<std::thread> m_vThreads;
+	std::mutex m_mutex;
+	std::condition_variable m_cvWork;
+	std::condition_variable m_cvDone;
+	// Current job (workers that wake up late only ever see an exhausted job)
+	std::shared_ptr<stJob> m_pJob;
+	unsigned long long m_nGeneration;
+	bool m_bStop;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CThreadPool(int nThreads = 0);
+	~CThreadPool();
+	CThreadPool(const CThreadPool&) = delete;
+	CThreadPool& operator=(const CThreadPool&) = delete;
+
+	void Run(int nTasks, const std::function<void(int)>& fnTask);
+
+	// Threads that run tasks (including the calling thread)
+	inline int GetThreadCount() const
+	{
+		return (int)m_vThreads.size() + 1;
+	}
+
+private:
+	void WorkerMain();
+	void RunTasks(stJob& stJobData);
+
+// ========================================================================================
+
+};
@@ -0,0 +1,81 @@
+#include "TokenBuffer.h"
+
+CTokenBuffer::CTokenBuffer()
+	: m_pSource("")
+{}
+
+/**
+@brief		Clear the buffer
+@param		pSource		Source buffer the tokens will refer to
+@return
+*/
+void CTokenBuffer::Reset(const char* pSource)
+{
+	m_pSource = pSource;
+	m_vKind.clear();
+	m_vOffset.clear();
+	m_vLength.clear();
+	m_vPayload.clear();
+}
+
+/**
+@brief		Fill the buffer from a token vector (and add the EndOfLine sentinel)
+@param		vTokens		Tokens
+@param		pSource		Source buffer the tokens refer to (nullptr: the lowest token address)
+@return
+*/
+void CTokenBuffer::Assign(const std::vector<CLexer::stToken>& vTokens, const char* pSource)
+{
+	if (pSource == nullptr)
+	{
+		for (const CLexer::stToken& stTokenData : vTokens)
+		{
+			if (pSource == nullptr ||
+				stTokenData.strString.data() < pSource)
+				pSource = stTokenData.strString.data();
+		}
+	}
+
+	Reset(pSource != nullptr ? pSource : "");
+
+	size_t nSize = vTokens.size() + 1;
+	m_vKind.reserve(nSize);
+	m_vOffset.reserve(nSize);
+	m_vLength.reserve(nSize);
+	m_vPayload.reserve(nSize);
+
+	for (const CLexer::stToken& stTokenData : vTokens)
+	{
+		if (stTokenData.eLex == CLexer::eLexEnum::EndOfLine)
+			break;
+		Push(stTokenData);
+	}
+
+	Finish();
+}
+
+/**
+@brief		Add the EndOfLine sentinel
+@return
+*/
+void CTokenBuffer::Finish()
+{
+	unsigned int nEnd = m_vOffset.empty() ? 0 : m_vOffset.back() + m_vLength.back();
+
+	m_vKind.push_back(static_cast<unsigned char>(CLexer::eLexEnum::EndOfLine));
+	m_vOffset.push_back(nEnd);
+	m_vLength.push_back(0);
+	m_vPayload.push_back({ CSymbolTable::INVALID_SYMBOL });
+}
+
+/**
+@brief		Token at the index
+@param		nIdx		Token index
+@return		Token
+*/
+CLexer::stToken CTokenBuffer::Token(size_t nIdx) const
+{
+	CLexer::stToken stTokenData(Kind(nIdx), String(nIdx));
+	stTokenData.uValue = Value(nIdx);
+	return stTokenData;
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include "Lexer.h"
+
+// Token buffer (struct-of-arrays)
+// Token kinds, source offsets, lengths and payloads live in separate contiguous
+// arrays, so the parser's kind checks walk a dense byte array.
+// The buffer always ends with an EndOfLine sentinel (after Finish()).
+// Offsets are 32-bit, so a source is limited to 4 GB.
+class CTokenBuffer
+{
+// Variables ==============================================================================
+private:
+	// Source buffer the offsets refer to (must outlive the buffer)
+	const char* m_pSource;
+	// Token kinds (CLexer::eLexEnum)
+	std::vector<unsigned char> m_vKind;
+	// Source offsets
+	std::vector<unsigned int> m_vOffset;
+	// Lengths
+	std::vector<unsigned int> m_vLength;
+	// Payloads (symbol ID of identifiers, value of Int and Double literals)
+	std::vector<CLexer::uTokenValue> m_vPayload;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CTokenBuffer();
+
+	void Reset(const char* pSource);
+	void Assign(const std::vector<CLexer::stToken>& vTokens, const char* pSource = nullptr);
+	void Finish();
+
+	inline void Push(const CLexer::stToken& stTokenData)
+	{
+		m_vKind.push_back(static_cast<unsigned char>(stTokenData.eLex));
+		m_vOffset.push_back((unsigned int)(stTokenData.strString.data() - m_pSource));
+		m_vLength.push_back((unsigned int)stTokenData.strString.size());
+		m_vPayload.push_back(stTokenData.uValue);
+	}
+
+	// Token count (including the EndOfLine sentinel)
+	inline size_t Size() const
+	{
+		return m_vKind.size();
+	}
+
+	inline const char* Source() const
+	{
+		return m_pSource;
+	}
+
+	inline const unsigned char* KindData() const
+	{
+		return m_vKind.data();
+	}
+
+	inline CLexer::eLexEnum Kind(size_t nIdx) const
+	{
+		return static_cast<CLexer::eLexEnum>(m_vKind[nIdx]);
+	}
+
+	inline void SetKind(size_t nIdx, CLexer::eLexEnum eLex)
+	{
+		m_vKind[nIdx] = static_cast<unsigned char>(eLex);
+	}
+
+	inline unsigned int Offset(size_t nIdx) const
+	{
+		return m_vOffset[nIdx];
+	}
+
+	inline unsigned int Length(size_t nIdx) const
+	{
+		return m_vLength[nIdx];
+	}
+
+	inline std::string_view String(size_t nIdx) const
+	{
+		return std::string_view(m_pSource + m_vOffset[nIdx], m_vLength[nIdx]);
+	}
+
+	inline SymbolID Symbol(size_t nIdx) const
+	{
+		return m_vPayload[nIdx].nSymbol;
+	}
+
+	inline int Int(size_t nIdx) const
+	{
+		return m_vPayload[nIdx].nInt;
+	}
+
+	inline double Double(size_t nIdx) const
+	{
+		return m_vPayload[nIdx].dDouble;
+	}
+
+	inline const CLexer::uTokenValue& Value(size_t nIdx) const
+	{
+		return m_vPayload[nIdx];
+	}
+
+	CLexer::stToken Token(size_t nIdx) const;
+
+// ========================================================================================
+
+};
+
+
+// Token reader (Parser input)
+// Reads a CTokenBuffer front to back. It never moves past the EndOfLine sentinel.
+class CTokenReader
+{
+// Variables ==============================================================================
+private:
+	const CTokenBuffer* m_pBuffer;
+	const unsigned char* m_pKind;
+	size_t m_nPos;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CTokenReader(const CTokenBuffer& buffer, size_t nPos = 0)
+		: m_pBuffer(&buffer), m_pKind(buffer.KindData()), m_nPos(nPos)
+	{}
+
+	inline CLexer::eLexEnum Lex() const
+	{
+		return static_cast<CLexer::eLexEnum>(m_pKind[m_nPos]);
+	}
+
+	// Kind of the next token (EndOfLine at the end)
+	inline CLexer::eLexEnum Peek() const
+	{
+		if (Lex() == CLexer::eLexEnum::EndOfLine)
+			return CLexer::eLexEnum::EndOfLine;
+		return static_cast<CLexer::eLexEnum>(m_pKind[m_nPos + 1]);
+	}
+
+	// Kind of the previous token (EndOfLine at the start)
+	inline CLexer::eLexEnum Prev() const
+	{
+		if (m_nPos == 0)
+			return CLexer::eLexEnum::EndOfLine;
+		return static_cast<CLexer::eLexEnum>(m_pKind[m_nPos - 1]);
+	}
+
+	inline std::string_view String() const
+	{
+		return m_pBuffer->String(m_nPos);
+	}
+
+	inline unsigned int Offset() const
+	{
+		return m_pBuffer->Offset(m_nPos);
+	}
+
+	inline SymbolID Symbol() const
+	{
+		return m_pBuffer->Symbol(m_nPos);
+	}
+
+	inline int Int() const
+	{
+		return m_pBuffer->Int(m_nPos);
+	}
+
+	inline double Double() const
+	{
+		return m_pBuffer->Double(m_nPos);
+	}
+
+	inline size_t Position() const
+	{
+		return m_nPos;
+	}
+
+	inline void Next()
+	{
+		if (Lex() != CLexer::eLexEnum::EndOfLine)
+			++m_nPos;
+	}
+
+// ========================================================================================
+
+};
@@ -0,0 +1,761 @@
+#include <cstring>
+#include "TypeChecker.h"
+
+/**
+@brief		Spelling of an operator (for the diagnostics)
+@param		eOp			Operator
+@return		Operator as it is written in the source
+*/
+static std::string OperatorText(CLexer::eLexEnum eOp)
+{
+	switch (eOp)
+	{
+		case CLexer::eLexEnum::RelOpEqual:				return "==";
+		case CLexer::eLexEnum::RelOpNotEqual:			return "!=";
+		case CLexer::eLexEnum::RelOpLessThan:			return "<";
+		case CLexer::eLexEnum::RelOpGreaterThan:		return ">";
+		case CLexer::eLexEnum::RelOpLessOrEqual:		return "<=";
+		case CLexer::eLexEnum::RelOpGreaterOrEqual:		return ">=";
+		case CLexer::eLexEnum::OpAdd:					return "+";
+		case CLexer::eLexEnum::OpSubtract:				return "-";
+		case CLexer::eLexEnum::OpMultiply:				return "*";
+		case CLexer::eLexEnum::OpDivide:				return "/";
+		case CLexer::eLexEnum::OpModulo:				return "%";
+		default:										return CLexer::FindLexToString(eOp);
+	}
+}
+
+CTypeChecker::CTypeChecker()
+	: m_pProg(nullptr), m_pDiag(nullptr), m_pFunc(nullptr), m_nConverts(0)
+{
+}
+
+/**
+@brief		Type every expression of a resolved program
+@param		prog		Program (bound by CResolver; conversions are made in its arena)
+@param		pDiag		Diagnostics (nullptr: dropped)
+@return		false if there was a type error
+*/
+bool CTypeChecker::Check(stProgram& prog, CDiagnostics* pDiag)
+{
+	CDiagnostics diagLocal;
+	m_pDiag = pDiag != nullptr ? pDiag : &diagLocal;
+	m_pProg = &prog;
+	m_nConverts = 0;
+	size_t nErrors = m_pDiag->ErrorCount();
+
+	for (stFunction* pFunc : prog.vFunc)
+		CheckFunction(pFunc);
+
+	bool bChecked = m_pDiag->ErrorCount() == nErrors;
+	m_pDiag = nullptr;
+	m_pProg = nullptr;
+	m_pFunc = nullptr;
+
+	return bChecked;
+}
+
+/**
+@brief		Static type of a declared type
+@param		eType		Declared type (Unknown: parameter without a type)
+@return		Type
+*/
+eValueType CTypeChecker::ToValueType(CLexer::eLexEnum eType)
+{
+	switch (eType)
+	{
+		case CLexer::eLexEnum::True:
+		case CLexer::eLexEnum::False:
+			return eValueType::Bool;
+		case CLexer::eLexEnum::Unknown:
+		case CLexer::eLexEnum::Int:
+			return eValueType::Int;
+		case CLexer::eLexEnum::Double:
+			return eValueType::Double;
+		case CLexer::eLexEnum::String:
+			return eValueType::String;
+		case CLexer::eLexEnum::Void:
+			return eValueType::Void;
+		default:
+			return eValueType::Unknown;
+	}
+}
+
+/**
+@brief		Type the statements of a function
+@param		pFunc		Function
+@return
+*/
+void CTypeChecker::CheckFunction(stFunction* pFunc)
+{
+	m_pFunc = pFunc;
+	m_vTask.clear();
+	m_vSlotType.assign(pFunc->nFrameSize, eValueType::Unknown);
+
+	// Parameters hold slots 0..n-1
+	for (size_t i = 0; i < pFunc->vParams.size() && i < m_vSlotType.size(); ++i)
+		m_vSlotType[i] = ToValueType(i < pFunc->vParamTypes.size() ? pFunc->vParamTypes[i] : CLexer::eLexEnum::Unknown);
+
+	PushBlock(pFunc->vBlock);
+
+	while (m_vTask.empty() == false)
+	{
+		stTask stTaskData = m_vTask.back();
+		m_vTask.pop_back();
+
+		switch (stTaskData.eKind)
+		{
+			case eTaskKind::Statement:
+				BeginStatement(stTaskData.pState);
+				break;
+			case eTaskKind::StatementEnd:
+				EndStatement(stTaskData.pState);
+				break;
+			case eTaskKind::Expression:
+				BeginExpression(stTaskData.pExp);
+				break;
+			case eTaskKind::ExpressionEnd:
+				EndExpression(stTaskData.pExp);
+				break;
+		}
+	}
+}
+
+/**
+@brief		Push the tasks of a statement (its children in source order, then its own check)
+@param		pState		Statement
+@return
+*/
+void CTypeChecker::BeginStatement(stStatement* pState)
+{
+	m_vTask.push_back(stTask{ eTaskKind::StatementEnd, pState, nullptr });
+
+	switch (pState->eKind)
+	{
+		case eNodeKind::Variable:
+			PushExpression(static_cast<stVariable*>(pState)->stExp);
+			break;
+		case eNodeKind::ExpStatement:
+			PushExpression(static_cast<stExpStatement*>(pState)->stExp);
+			break;
+		case eNodeKind::Return:
+			PushExpression(static_cast<stReturn*>(pState)->stExp);
+			break;
+		case eNodeKind::For:
+		{
+			stFor* pFor = static_cast<stFor*>(pState);
+			PushBlock(pFor->stBlock);
+			PushExpression(pFor->stLoopExp);
+			PushExpression(pFor->stCondExp);
+			PushStatement(pFor->stVar);
+			break;
+		}
+		case eNodeKind::While:
+		{
+			stWhile* pWhile = static_cast<stWhile*>(pState);
+			PushBlock(pWhile->stBlock);
+			PushExpression(pWhile->stCondExp);
+			break;
+		}
+		case eNodeKind::If:
+		{
+			stIf* pIf = static_cast<stIf*>(pState);
+			PushBlock(pIf->vElseBlock);
+			for (size_t i = pIf->vIfBlock.size(); i-- > 0;)
+				PushBlock(pIf->vIfBlock[i]);
+			for (size_t i = pIf->stCondStm.size(); i-- > 0;)
+				PushExpression(pIf->stCondStm[i]);
+			break;
+		}
+		case eNodeKind::Switch:
+		{
+			stSwitch* pSwitch = static_cast<stSwitch*>(pState);
+			PushBlock(pSwitch->vDefaultBlock);
+			for (size_t i = pSwitch->vCaseBlock.size(); i-- > 0;)
+				PushBlock(pSwitch->vCaseBlock[i]);
+			for (size_t i = pSwitch->stCondStm.size(); i-- > 0;)
+				PushExpression(pSwitch->stCondStm[i]);
+			PushExpression(pSwitch->stExp);
+			break;
+		}
+		case eNodeKind::Print:
+		{
+			stPrint* pPrint = static_cast<stPrint*>(pState);
+			for (size_t i = pPrint->stArgs.size(); i-- > 0;)
+				PushExpression(pPrint->stArgs[i]);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Check a statement whose expressions are typed
+@param		pState		Statement
+@return
+*/
+void CTypeChecker::EndStatement(stStatement* pState)
+{
+	switch (pState->eKind)
+	{
+		case eNodeKind::Variable:
+		{
+			stVariable* pVar = static_cast<stVariable*>(pState);
+			eValueType eType = ToValueType(pVar->eType);
+
+			if (eType == eValueType::Void)
+			{
+				Report(pVar->nOffset, "Variable '" + std::string(CSymbolTable::Global().GetName(pVar->nSymbol)) + "' cannot be void.");
+				eType = eValueType::Unknown;
+			}
+			else
+			{
+				CheckAssign(pVar->stExp, eType);
+			}
+
+			// The variable is declared after its initializer (as CResolver does)
+			if (pVar->nSlot < m_vSlotType.size())
+				m_vSlotType[pVar->nSlot] = eType;
+			break;
+		}
+		case eNodeKind::Return:
+		{
+			stReturn* pReturn = static_cast<stReturn*>(pState);
+			eValueType eType = ToValueType(m_pFunc->eType);
+			std::string strName(CSymbolTable::Global().GetName(m_pFunc->nSymbol));
+
+			if (eType == eValueType::Void)
+			{
+				if (pReturn->stExp != nullptr &&
+					TypeOf(pReturn->stExp) != eValueType::Void &&
+					TypeOf(pReturn->stExp) != eValueType::Unknown)
+					Report(pReturn->stExp->nOffset, "Function '" + strName + "' returns void.");
+			}
+			else if (pReturn->stExp == nullptr)
+			{
+				Report(pReturn->nOffset, "Function '" + strName + "' has to return " + TypeName(eType) + ".");
+			}
+			else
+			{
+				CheckAssign(pReturn->stExp, eType);
+			}
+			break;
+		}
+		case eNodeKind::For:
+		{
+			stFor* pFor = static_cast<stFor*>(pState);
+			CheckCondition(pFor->stCondExp);
+			break;
+		}
+		case eNodeKind::While:
+			CheckCondition(static_cast<stWhile*>(pState)->stCondExp);
+			break;
+		case eNodeKind::If:
+		{
+			stIf* pIf = static_cast<stIf*>(pState);
+			for (stExpression*& pCond : pIf->stCondStm)
+				CheckCondition(pCond);
+			break;
+		}
+		case eNodeKind::Switch:
+		{
+			stSwitch* pSwitch = static_cast<stSwitch*>(pState);
+			eValueType eType = TypeOf(pSwitch->stExp);
+
+			if (eType != eValueType::Unknown &&
+				eType != eValueType::Int &&
+				eType != eValueType::Bool &&
+				eType != eValueType::String)
+			{
+				Report(pSwitch->stExp->nOffset, "Switch value cannot be " + TypeName(eType) + ".");
+				break;
+			}
+
+			for (stExpression* pCase : pSwitch->stCondStm)
+			{
+				eValueType eCaseType = TypeOf(pCase);
+				if (eType != eValueType::Unknown &&
+					eCaseType != eValueType::Unknown &&
+					eCaseType != eType)
+					Report(pCase->nOffset, "Case value " + TypeName(eCaseType) + " does not match the switch value " + TypeName(eType) + ".");
+			}
+			break;
+		}
+		case eNodeKind::Print:
+			CheckPrint(static_cast<stPrint*>(pState));
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Type a leaf expression, or push the tasks of the children of one
+@param		pExp		Expression
+@return
+*/
+void CTypeChecker::BeginExpression(stExpression* pExp)
+{
+	switch (pExp->eKind)
+	{
+		case eNodeKind::NullData:
+			pExp->eValType = eValueType::Null;
+			return;
+		case eNodeKind::BoolData:
+			pExp->eValType = eValueType::Bool;
+			return;
+		case eNodeKind::IntData:
+			pExp->eValType = eValueType::Int;
+			return;
+		case eNodeKind::DoubleData:
+			pExp->eValType = eValueType::Double;
+			return;
+		case eNodeKind::StringData:
+			pExp->eValType = eValueType::String;
+			return;
+		case eNodeKind::VoidData:
+			pExp->eValType = eValueType::Void;
+			return;
+		case eNodeKind::Array:
+			pExp->eValType = eValueType::Array;
+			return;
+		case eNodeKind::GetVariable:
+		{
+			const stBinding& stBind = static_cast<stGetVariable*>(pExp)->stBind;
+
+			if (stBind.eKind == eBindKind::Local)
+				pExp->eValType = stBind.nSlot < m_vSlotType.size() ? m_vSlotType[stBind.nSlot] : eValueType::Unknown;
+			else if (stBind.eKind == eBindKind::Function)
+				pExp->eValType = eValueType::Function;
+			else
+				pExp->eValType = eValueType::Unknown;
+			return;
+		}
+		default:
+			break;
+	}
+
+	m_vTask.push_back(stTask{ eTaskKind::ExpressionEnd, nullptr, pExp });
+
+	switch (pExp->eKind)
+	{
+		case eNodeKind::And:
+		{
+			stAnd* pAnd = static_cast<stAnd*>(pExp);
+			PushExpression(pAnd->stRight);
+			PushExpression(pAnd->stLeft);
+			break;
+		}
+		case eNodeKind::Or:
+		{
+			stOr* pOr = static_cast<stOr*>(pExp);
+			PushExpression(pOr->stRight);
+			PushExpression(pOr->stLeft);
+			break;
+		}
+		case eNodeKind::Relational:
+		{
+			stRelational* pRel = static_cast<stRelational*>(pExp);
+			PushExpression(pRel->stRight);
+			PushExpression(pRel->stLeft);
+			break;
+		}
+		case eNodeKind::Arithmetic:
+		{
+			stArithmetic* pArith = static_cast<stArithmetic*>(pExp);
+			PushExpression(pArith->stRight);
+			PushExpression(pArith->stLeft);
+			break;
+		}
+		case eNodeKind::Unary:
+			PushExpression(static_cast<stUnary*>(pExp)->stSubExp);
+			break;
+		case eNodeKind::Convert:
+			PushExpression(static_cast<stConvert*>(pExp)->stSubExp);
+			break;
+		case eNodeKind::SetVariable:
+			PushExpression(static_cast<stSetVariable*>(pExp)->stInitExp);
+			break;
+		case eNodeKind::GetElement:
+		{
+			stGetElement* pGetElem = static_cast<stGetElement*>(pExp);
+			PushExpression(pGetElem->stIndexExp);
+			PushExpression(pGetElem->stMemsExp);
+			break;
+		}
+		case eNodeKind::SetElement:
+		{
+			stSetElement* pSetElem = static_cast<stSetElement*>(pExp);
+			PushExpression(pSetElem->stInitExp);
+			PushExpression(pSetElem->stIndexExp);
+			PushExpression(pSetElem->stMemsExp);
+			break;
+		}
+		case eNodeKind::CallFunc:
+		{
+			stCallFunc* pCall = static_cast<stCallFunc*>(pExp);
+			for (size_t i = pCall->vArgsExp.size(); i-- > 0;)
+				PushExpression(pCall->vArgsExp[i]);
+			PushExpression(pCall->stSubExp);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Type an expression whose children are typed (conversions of the children are inserted here)
+@param		pExp		Expression
+@return
+*/
+void CTypeChecker::EndExpression(stExpression* pExp)
+{
+	switch (pExp->eKind)
+	{
+		case eNodeKind::And:
+		{
+			stAnd* pAnd = static_cast<stAnd*>(pExp);
+			CheckCondition(pAnd->stLeft);
+			CheckCondition(pAnd->stRight);
+			pExp->eValType = eValueType::Bool;
+			break;
+		}
+		case eNodeKind::Or:
+		{
+			stOr* pOr = static_cast<stOr*>(pExp);
+			CheckCondition(pOr->stLeft);
+			CheckCondition(pOr->stRight);
+			pExp->eValType = eValueType::Bool;
+			break;
+		}
+		case eNodeKind::Relational:
+			pExp->eValType = CheckRelational(static_cast<stRelational*>(pExp));
+			break;
+		case eNodeKind::Arithmetic:
+			pExp->eValType = CheckArithmetic(static_cast<stArithmetic*>(pExp));
+			break;
+		case eNodeKind::Unary:
+		{
+			stUnary* pUn = static_cast<stUnary*>(pExp);
+			eValueType eType = TypeOf(pUn->stSubExp);
+
+			pExp->eValType = IsNumber(eType) ? eType : eValueType::Unknown;
+			if (IsNumber(eType) == false &&
+				eType != eValueType::Unknown)
+				Report(pUn->nOffset, "Operator '" + OperatorText(pUn->eType) + "' cannot be applied to " + TypeName(eType) + ".");
+			break;
+		}
+		case eNodeKind::SetVariable:
+		{
+			stSetVariable* pSetVar = static_cast<stSetVariable*>(pExp);
+			const stBinding& stBind = pSetVar->stBind;
+
+			pExp->eValType = eValueType::Unknown;
+			if (stBind.eKind == eBindKind::Local &&
+				stBind.nSlot < m_vSlotType.size())
+			{
+				pExp->eValType = m_vSlotType[stBind.nSlot];
+				CheckAssign(pSetVar->stInitExp, pExp->eValType);
+			}
+			else if (stBind.eKind == eBindKind::Function)
+			{
+				Report(pSetVar->nOffset, "Cannot assign to function '" + std::string(CSymbolTable::Global().GetName(pSetVar->nSymbol)) + "'.");
+			}
+			break;
+		}
+		case eNodeKind::GetElement:
+		{
+			// Strings are indexed by an int (a one-character string)
+			stGetElement* pGetElem = static_cast<stGetElement*>(pExp);
+			eValueType eType = TypeOf(pGetElem->stMemsExp);
+
+			pExp->eValType = eValueType::Unknown;
+			if (eType == eValueType::String)
+			{
+				CheckAssign(pGetElem->stIndexExp, eValueType::Int);
+				pExp->eValType = eValueType::String;
+			}
+			else if (eType != eValueType::Unknown)
+			{
+				Report(pGetElem->nOffset, "Type " + TypeName(eType) + " cannot be indexed.");
+			}
+			break;
+		}
+		case eNodeKind::SetElement:
+		{
+			stSetElement* pSetElem = static_cast<stSetElement*>(pExp);
+			eValueType eType = TypeOf(pSetElem->stMemsExp);
+
+			pExp->eValType = eValueType::Unknown;
+			if (eType != eValueType::Unknown)
+				Report(pSetElem->nOffset, "Elements of type " + TypeName(eType) + " cannot be assigned.");
+			break;
+		}
+		case eNodeKind::CallFunc:
+			pExp->eValType = CheckCall(static_cast<stCallFunc*>(pExp));
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+@brief		Type an arithmetic expression
+@param		pArith		Arithmetic expression
+@return		Result type
+*/
+eValueType CTypeChecker::CheckArithmetic(stArithmetic* pArith)
+{
+	eValueType eLeft = TypeOf(pArith->stLeft);
+	eValueType eRight = TypeOf(pArith->stRight);
+
+	if (eLeft == eValueType::Unknown ||
+		eRight == eValueType::Unknown)
+		return eValueType::Unknown;
+
+	if (IsNumber(eLeft) &&
+		IsNumber(eRight))
+	{
+		if (eLeft == eValueType::Int &&
+			eRight == eValueType::Int)
+			return eValueType::Int;
+
+		if (pArith->eType == CLexer::eLexEnum::OpModulo)
+		{
+			Report(pArith->nOffset, "Operator '%' needs int operands.");
+			return eValueType::Unknown;
+		}
+
+		Coerce(pArith->stLeft, eValueType::Double);
+		Coerce(pArith->stRight, eValueType::Double);
+		return eValueType::Double;
+	}
+
+	if (pArith->eType == CLexer::eLexEnum::OpAdd &&
+		eLeft == eValueType::String &&
+		eRight == eValueType::String)
+		return eValueType::String;
+
+	Report(pArith->nOffset, "Operator '" + OperatorText(pArith->eType) + "' cannot be applied to " +
+		   TypeName(eLeft) + " and " + TypeName(eRight) + ".");
+	return eValueType::Unknown;
+}
+
+/**
+@brief		Type a relational expression
+@param		pRel		Relational expression
+@return		Result type (bool)
+*/
+eValueType CTypeChecker::CheckRelational(stRelational* pRel)
+{
+	eValueType eLeft = TypeOf(pRel->stLeft);
+	eValueType eRight = TypeOf(pRel->stRight);
+	bool bEquality = pRel->eType == CLexer::eLexEnum::RelOpEqual ||
+					 pRel->eType == CLexer::eLexEnum::RelOpNotEqual;
+
+	if (eLeft == eValueType::Unknown ||
+		eRight == eValueType::Unknown)
+		return eValueType::Bool;
+
+	if (IsNumber(eLeft) &&
+		IsNumber(eRight))
+	{
+		if (eLeft != eRight)
+		{
+			Coerce(pRel->stLeft, eValueType::Double);
+			Coerce(pRel->stRight, eValueType::Double);
+		}
+		return eValueType::Bool;
+	}
+
+	// Strings are ordered; bools and null are only compared for equality
+	if ((eLeft == eValueType::String && eRight == eValueType::String) ||
+		(bEquality && eLeft == eRight && (eLeft == eValueType::Bool || eLeft == eValueType::Null)) ||
+		(bEquality && eLeft == eValueType::Null && eRight == eValueType::String) ||
+		(bEquality && eLeft == eValueType::String && eRight == eValueType::Null))
+		return eValueType::Bool;
+
+	Report(pRel->nOffset, "Operator '" + OperatorText(pRel->eType) + "' cannot compare " +
+		   TypeName(eLeft) + " and " + TypeName(eRight) + ".");
+	return eValueType::Bool;
+}
+
+/**
+@brief		Check the arguments of a call against the parameters of its function
+@param		pCall		Call expression
+@return		Result type (the return type of the function)
+*/
+eValueType CTypeChecker::CheckCall(stCallFunc* pCall)
+{
+	if (pCall->stSubExp == nullptr ||
+		pCall->stSubExp->eKind != eNodeKind::GetVariable)
+		return eValueType::Unknown;
+
+	const stGetVariable* pCallee = static_cast<const stGetVariable*>(pCall->stSubExp);
+	std::string strName(CSymbolTable::Global().GetName(pCallee->nSymbol));
+
+	if (pCallee->stBind.eKind == eBindKind::Unresolved)
+		return eValueType::Unknown;
+	if (pCallee->stBind.eKind != eBindKind::Function)
+	{
+		Report(pCall->nOffset, "'" + strName + "' is not a function.");
+		return eValueType::Unknown;
+	}
+
+	const stFunction* pFunc = m_pProg->vFunc[pCallee->stBind.nSlot];
+	if (pCall->vArgsExp.size() != pFunc->vParams.size())
+	{
+		Report(pCall->nOffset, "Function '" + strName + "' takes " + std::to_string(pFunc->vParams.size()) +
+			   " arguments, not " + std::to_string(pCall->vArgsExp.size()) + ".");
+		return ToValueType(pFunc->eType);
+	}
+
+	for (size_t i = 0; i < pCall->vArgsExp.size(); ++i)
+		CheckAssign(pCall->vArgsExp[i], ToValueType(i < pFunc->vParamTypes.size() ? pFunc->vParamTypes[i] : CLexer::eLexEnum::Unknown));
+
+	return ToValueType(pFunc->eType);
+}
+
+/**
+@brief		Check the arguments of printf against the conversions of its format
+@param		pPrint		Print statement
+@return
+*/
+void CTypeChecker::CheckPrint(stPrint* pPrint)
+{
+	std::string_view strFormat = pPrint->strFormat;
+	size_t nArg = 0;
+
+	for (size_t i = 0; i < strFormat.size(); ++i)
+	{
+		if (strFormat[i] != '%')
+			continue;
+
+		// Flags, width, precision and length are skipped
+		++i;
+		while (i < strFormat.size() &&
+			   strchr("-+ #0123456789.lh", strFormat[i]) != nullptr)
+			++i;
+
+		if (i >= strFormat.size())
+		{
+			Report(pPrint->nOffset, "printf format ends in a conversion.");
+			return;
+		}
+
+		eValueType eType;
+		switch (strFormat[i])
+		{
+			case '%':
+				continue;
+			case 'd':
+			case 'i':
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+			case 'c':
+				eType = eValueType::Int;
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+				eType = eValueType::Double;
+				break;
+			case 's':
+				eType = eValueType::String;
+				break;
+			default:
+				Report(pPrint->nOffset, std::string("Unknown printf conversion '%") + strFormat[i] + "'.");
+				return;
+		}
+
+		if (nArg < pPrint->stArgs.size())
+			CheckAssign(pPrint->stArgs[nArg], eType);
+		++nArg;
+	}
+
+	if (nArg != pPrint->stArgs.size())
+		Report(pPrint->nOffset, "printf format takes " + std::to_string(nArg) + " arguments, not " + std::to_string(pPrint->stArgs.size()) + ".");
+}
+
+/**
+@brief		Check a condition (an int is converted to bool)
+@param		pExp		Condition (a conversion may be put in its place)
+@return
+*/
+void CTypeChecker::CheckCondition(stExpression*& pExp)
+{
+	eValueType eType = TypeOf(pExp);
+
+	if (eType == eValueType::Int)
+		Coerce(pExp, eValueType::Bool);
+	else if (eType != eValueType::Bool &&
+			 eType != eValueType::Unknown)
+		Report(pExp->nOffset, "Condition has to be bool or int, not " + TypeName(eType) + ".");
+}
+
+/**
+@brief		Check a value that is stored as a type (initializer, assignment, argument, return)
+@param		pExp		Value (a conversion may be put in its place)
+@param		eTarget		Type it is stored as
+@return
+*/
+void CTypeChecker::CheckAssign(stExpression*& pExp, eValueType eTarget)
+{
+	if (Coerce(pExp, eTarget) == false)
+		Report(pExp->nOffset, "Cannot convert " + TypeName(pExp->eValType) + " to " + TypeName(eTarget) + ".");
+}
+
+/**
+@brief		Convert an expression to a type
+@param		pExp		Expression (replaced by a stConvert if the types differ)
+@param		eTarget		Type
+@return		false if there is no conversion (int <-> double, int <-> bool and null -> string are)
+*/
+bool CTypeChecker::Coerce(stExpression*& pExp, eValueType eTarget)
+{
+	eValueType eType = TypeOf(pExp);
+
+	if (pExp == nullptr ||
+		eType == eTarget ||
+		eType == eValueType::Unknown ||
+		eTarget == eValueType::Unknown)
+		return true;
+
+	if (eType == eValueType::Null &&
+		eTarget == eValueType::String)
+		return true;
+
+	bool bConvert = (IsNumber(eType) && IsNumber(eTarget)) ||
+					(eType == eValueType::Int && eTarget == eValueType::Bool) ||
+					(eType == eValueType::Bool && eTarget == eValueType::Int);
+	if (bConvert == false)
+		return false;
+
+	stConvert* pConv = m_pProg->arena.New<stConvert>();
+	pConv->eValType = eTarget;
+	pConv->nOffset = pExp->nOffset;
+	pConv->stSubExp = pExp;
+	pExp = pConv;
+
+	++m_pProg->nNodeCount;
+	++m_nConverts;
+	return true;
+}
+
+/**
+@brief		Add a type error
+@param		nOffset		Source offset
+@param		strMessage	Message
+@return
+*/
+void CTypeChecker::Report(size_t nOffset, std::string strMessage)
+{
+	m_pDiag->Error(nOffset, std::move(strMessage));
+}
\ No newline at end of file
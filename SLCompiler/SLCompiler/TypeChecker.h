@@ -0,0 +1,123 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Diagnostics.h"
+#include "Structures.h"
+
+// Static type checker (semantic pass, runs after CResolver)
+// Sets the result type (stExpression::eValType) of every expression and makes every int <->
+// double conversion explicit with a stConvert node, so a backend can pick an operation by
+// the types of its operands and does not have to check tags at run time.
+// - Variables have their declared type; a parameter without a type is an int (K&R style).
+// - int op int is int (/ truncates, % needs ints); int op double converts the int side.
+// - string + string is string; relational operators compare numbers, strings, bools and null.
+// - Initializers, assignments, arguments and return values convert int <-> double and
+//   bool -> int (as in C) to the type they are stored as; conditions take bool or int (an
+//   int converts to bool).
+// - printf arguments are checked against the conversions of the format (%d %f %s ...).
+// An expression with an error has the Unknown type, and Unknown operands do not report
+// again, so one mistake gives one diagnostic.
+// Nodes are visited with an explicit stack of tasks (children before their parent), so any
+// nesting depth the parser accepts can be checked.
+class CTypeChecker
+{
+// Enums and Classes, Structures ==========================================================
+private:
+	enum class eTaskKind : unsigned char
+	{
+		Statement,
+		// Check a statement once its children are checked
+		StatementEnd,
+		Expression,
+		// Type an expression once its children are typed
+		ExpressionEnd,
+	};
+
+	struct stTask
+	{
+	public:
+		eTaskKind eKind;
+		stStatement* pState;
+		stExpression* pExp;
+	};
+// ========================================================================================
+
+
+// Variables ==============================================================================
+private:
+	stProgram* m_pProg;
+	CDiagnostics* m_pDiag;
+	const stFunction* m_pFunc;
+	// Tasks that are waiting to be checked (last in, first out)
+	std::vector<stTask> m_vTask;
+	// Type of the variable that holds each frame slot now (slots are reused like CResolver does)
+	std::vector<eValueType> m_vSlotType;
+	// Conversions inserted by the last Check()
+	size_t m_nConverts;
+// ========================================================================================
+
+
+// Functions ==============================================================================
+public:
+	CTypeChecker();
+
+	bool Check(stProgram& prog, CDiagnostics* pDiag = nullptr);
+
+	inline size_t GetConvertCount() const
+	{
+		return m_nConverts;
+	}
+
+	static eValueType ToValueType(CLexer::eLexEnum eType);
+
+private:
+	void CheckFunction(stFunction* pFunc);
+	void BeginStatement(stStatement* pState);
+	void EndStatement(stStatement* pState);
+	void BeginExpression(stExpression* pExp);
+	void EndExpression(stExpression* pExp);
+	eValueType CheckArithmetic(stArithmetic* pArith);
+	eValueType CheckRelational(stRelational* pRel);
+	eValueType CheckCall(stCallFunc* pCall);
+	void CheckPrint(stPrint* pPrint);
+	void CheckCondition(stExpression*& pExp);
+	void CheckAssign(stExpression*& pExp, eValueType eTarget);
+	bool Coerce(stExpression*& pExp, eValueType eTarget);
+	void Report(size_t nOffset, std::string strMessage);
+
+	inline void PushStatement(stStatement* pState)
+	{
+		if (pState != nullptr)
+			m_vTask.push_back(stTask{ eTaskKind::Statement, pState, nullptr });
+	}
+
+	inline void PushExpression(stExpression* pExp)
+	{
+		if (pExp != nullptr)
+			m_vTask.push_back(stTask{ eTaskKind::Expression, nullptr, pExp });
+	}
+
+	inline void PushBlock(const vstStatement& vBlock)
+	{
+		for (size_t i = vBlock.size(); i-- > 0;)
+			PushStatement(vBlock[i]);
+	}
+
+	inline static bool IsNumber(eValueType eType)
+	{
+		return eType == eValueType::Int || eType == eValueType::Double;
+	}
+
+	inline static eValueType TypeOf(const stExpression* pExp)
+	{
+		return pExp != nullptr ? pExp->eValType : eValueType::Unknown;
+	}
+
+	inline static std::string TypeName(eValueType eType)
+	{
+		return std::string("'") + GetValueTypeName(eType) + "'";
+	}
+
+// ========================================================================================
+
+};
\ No newline at end of file
@@ -1,11 +1,197 @@
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 #include "Lexer.h"
 #include "Parser.h"
+#include "ASTCache.h"
+#include "ASTDumper.h"
+#include "Resolver.h"
+#include "TypeChecker.h"
+#include "ConstantFolder.h"
+#include "DeadCodeEliminator.h"
+#include "Interpreter.h"
+#include "Benchmark.h"
 
 
-int main(void)
+int main(int argc, char* argv[])
 {
+	if (argc > 1 &&
+		strcmp(argv[1], "-bench") == 0)
+		return CBenchmark::Run(argc, argv);
+	if (argc > 1 &&
+		strcmp(argv[1], "-bench-shape") == 0)
+		return CBenchmark::RunShape(argc, argv);
+	if (argc > 1 &&
+		strcmp(argv[1], "-bench-exec") == 0)
+		return CBenchmark::RunExec(argc, argv);
+
+	// Check: parse, resolve, type check and optimize every source file in turn and print its diagnostics
+	// (errors do not stop the process; the exit code tells whether any file had one)
+	// -check [-cache Dir] file...: files that are in the AST cache are not scanned and parsed again
+	// (the passes after the parser still run, so their diagnostics are the same as without the cache)
+	if (argc > 1 &&
+		strcmp(argv[1], "-check") == 0)
+	{
+		int nFailed = 0;
+		int nFirst = 2;
+		std::unique_ptr<CASTCache> pCache;
+
+		if (argc > 3 &&
+			strcmp(argv[2], "-cache") == 0)
+		{
+			pCache.reset(new CASTCache(argv[3]));
+			nFirst = 4;
+		}
+
+		for (int i = nFirst; i < argc; ++i)
+		{
+			CSourceFile source;
+			if (source.Open(argv[i]) == false)
+			{
+				printf("Cannot open %s\n", argv[i]);
+				++nFailed;
+				continue;
+			}
+
+			CDiagnostics diag;
+			CFlatAST ast;
+			stProgram* pProg = nullptr;
+			bool bCached = pCache != nullptr && pCache->Load(source.Text(), ast);
+
+			if (bCached)
+			{
+				pProg = new stProgram();
+				ast.ToProgram(*pProg);
+			}
+			else
+			{
+				CLexerStream stream(source, &diag);
+				pProg = CParser::Parser(stream, CParser::eParseMode::Auto, &diag);
+
+				// Only sources that scan and parse without diagnostics are cached (the AST as parsed)
+				if (pCache != nullptr &&
+					diag.Get().empty())
+				{
+					ast.Build(*pProg);
+					pCache->Store(source.Text(), ast);
+				}
+			}
+
+			// Functions as parsed (the eliminator removes the ones main does not reach)
+			size_t nFunctions = pProg->vFunc.size();
+
+			CResolver resolver;
+			resolver.Resolve(*pProg, &diag);
+			CTypeChecker checker;
+			checker.Check(*pProg, &diag);
+			CConstantFolder folder;
+			folder.Fold(*pProg, &diag);
+			CDeadCodeEliminator eliminator;
+			eliminator.Eliminate(*pProg);
+
+			const CDeadCodeEliminator::stDeadCodeStats& stStats = eliminator.GetStats();
+			printf("%s: %zu functions, %zu errors, %zu statements and %zu functions removed%s\n", argv[i], nFunctions, diag.ErrorCount(),
+				   stStats.nStatements, stStats.nFunctions, bCached ? " (cached)" : "");
+			diag.Sort();
+			diag.Print(source.Text());
+			if (diag.HasError())
+				++nFailed;
+
+			DeletePtr<stProgram>(pProg);
+		}
+
+		return nFailed == 0 ? 0 : 1;
+	}
+
+	// Dump: print the AST of a source file as indented text or JSON (-dump [-json] file)
+	if (argc > 1 &&
+		strcmp(argv[1], "-dump") == 0)
+	{
+		bool bJson = argc > 3 && strcmp(argv[2], "-json") == 0;
+		const char* pPath = argc > (bJson ? 3 : 2) ? argv[bJson ? 3 : 2] : nullptr;
+		CSourceFile source;
+
+		if (pPath == nullptr ||
+			source.Open(pPath) == false)
+		{
+			printf("Usage: %s -dump [-json] file\n", argv[0]);
+			return 1;
+		}
+
+		CDiagnostics diag;
+		CLexerStream stream(source, &diag);
+		stProgram* pProg = CParser::Parser(stream, CParser::eParseMode::Auto, &diag);
+
+		CASTDumper dumper(bJson ? CASTDumper::eFormat::Json : CASTDumper::eFormat::Text);
+		dumper.Print(*pProg);
+		diag.Sort();
+		diag.Print(source.Text());
+
+		DeletePtr<stProgram>(pProg);
+		return diag.HasError() ? 1 : 0;
+	}
+
+	// Run: check and optimize a source file, then run its main with the reference interpreter (-run file)
+	// (the program runs only without errors; the exit code is the int that main returns)
+	if (argc > 1 &&
+		strcmp(argv[1], "-run") == 0)
+	{
+		CSourceFile source;
+		if (argc < 3 ||
+			source.Open(argv[2]) == false)
+		{
+			printf("Usage: %s -run file\n", argv[0]);
+			return 1;
+		}
+
+		CDiagnostics diag;
+		CLexerStream stream(source, &diag);
+		stProgram* pProg = CParser::Parser(stream, CParser::eParseMode::Auto, &diag);
+		CResolver resolver;
+		resolver.Resolve(*pProg, &diag);
+		CTypeChecker checker;
+		checker.Check(*pProg, &diag);
+		CConstantFolder folder;
+		folder.Fold(*pProg, &diag);
+		CDeadCodeEliminator eliminator;
+		eliminator.Eliminate(*pProg);
+
+		stValue valResult;
+		bool bRun = false;
+		if (diag.HasError() == false)
+		{
+			CInterpreter interpreter;
+			bRun = interpreter.Run(*pProg, valResult, &diag);
+		}
+
+		diag.Sort();
+		diag.Print(source.Text());
+
+		DeletePtr<stProgram>(pProg);
+
+		if (bRun == false)
+			return 1;
+		return valResult.eType == eValueType::Int ? valResult.nData : 0;
+	}
+
+	// Source file: stream the tokens of the mapped file
+	if (argc > 1)
+	{
+		CSourceFile source;
+		if (source.Open(argv[1]) == false)
+		{
+			printf("Cannot open %s\n", argv[1]);
+			return 1;
+		}
+
+		CLexerStream stream(source);
+		CLexer::stToken token;
+		while (stream.NextToken(token))
+			printf("%-20.*s %-5s\n", (int)token.strString.size(), token.strString.data(), CLexer::FindLexToString(token.eLex).c_str());
+
+		return 0;
+	}
+
 	std::string strSource = "void main()\
 	{\
 		int nNum = 5;\
@@ -17,12 +203,23 @@ int main(void)
 
 	std::vector<CLexer::stToken> vResult = CLexer::Scan(strSource);
 	std::for_each(vResult.begin(), vResult.end(), [](CLexer::stToken& token) {
-		printf("%-20s %-5s\n", token.strString.c_str(), CLexer::FindLexToString(token.eLex).c_str());
+		printf("%-20.*s %-5s\n", (int)token.strString.size(), token.strString.data(), CLexer::FindLexToString(token.eLex).c_str());
 	});
-	//stProgram* pProg = CParser::Parser(vResult);
-	//while ()
 
-	//DeletePtr<stProgram>(pProg);
+	CDiagnostics diag;
+	stProgram* pProg = CParser::Parser(vResult, &diag);
+	CResolver resolver;
+	resolver.Resolve(*pProg, &diag);
+	CTypeChecker checker;
+	checker.Check(*pProg, &diag);
+	CConstantFolder folder;
+	folder.Fold(*pProg, &diag);
+	CDeadCodeEliminator eliminator;
+	eliminator.Eliminate(*pProg);
+	diag.Sort();
+	diag.Print(strSource);
+
+	DeletePtr<stProgram>(pProg);
 
-	return 0;
+	return diag.HasError() ? 1 : 0;
 }
\ No newline at end of file